@@ -0,0 +1,346 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "batch.h"
+#include "util.h"
+
+// A chain of the batch and the search of its current level
+typedef struct {
+    hcb_builder* builder;
+    int level;
+    nonce_t resume;                       // Nonce the level was started from in this run
+    nonce_t next;                         // First nonce of the level not given to a thread
+    nonce_t best;                         // Lowest valid nonce found, NONCE_MAX if none
+    int searching;                        // Threads searching a slice of the chain
+    bool writing;                         // The block of the level is being appended
+    double start;                         // Time the level was started in this run
+} chain_t;
+
+// A thread of the pool and the slice it searches
+typedef struct {
+    hcb_batch* batch;
+    search_t* search;                     // Searcher with a single thread, the calling one
+    int chain;                            // Chain of the slice, -1 if none
+    int previous;                         // Chain of the last slice, -1 if none
+    int level;
+    nonce_t start;
+    nonce_t end;
+    nonce_t position;                     // Lowest nonce of the slice that may not have been tested
+    char* message;                        // Message of the level, the builder rewrites its own once the block is found
+    size_t message_size;
+} pool_thread_t;
+
+struct hcb_batch {
+    chain_t* chains;
+    int chain_count;
+    pool_thread_t threads[SEARCH_MAX_THREADS];
+    int thread_count;
+    bool pinned;                          // Each thread of the pool runs on its own CPU
+    int cursor;                           // Chain picked first among the ones with the fewest threads
+
+    pthread_mutex_t lock;                 // Protects everything above and below
+    pthread_cond_t changed;               // A level started, or the batch stopped
+    bool stopped;
+    hcb_error error;                      // First error of the batch, HCB_OK if none
+
+    hcb_batch_callback callback;
+    void* data;
+};
+
+// Start searching the current level of a chain
+static void chain_start(chain_t* chain) {
+    chain->level = hcb_builder_level(chain->builder);
+    chain->resume = chain->next = hcb_builder_position(chain->builder);
+    chain->best = NONCE_MAX;
+    chain->start = util_now();
+}
+
+hcb_status hcb_batch_create(hcb_batch** result, hcb_builder* const builders[], int count, const hcb_options* options, hcb_error* error) {
+
+    *result = NULL;
+    hcb_batch* batch = calloc(1, sizeof(hcb_batch));
+    if (batch == NULL || (batch->chains = calloc(count > 0 ? count : 1, sizeof(chain_t))) == NULL) {
+        free(batch);
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+    }
+    pthread_mutex_init(&batch->lock, NULL);
+    pthread_cond_init(&batch->changed, NULL);
+    util_fail(&batch->error, HCB_OK, "");
+    batch->chain_count = count;
+    for (int i = 0; i < count; i++) {
+        batch->chains[i].builder = builders[i];
+    }
+
+    // The threads of the pool each own a single threaded searcher
+    search_t* search = search_create();
+    if (search == NULL) {
+        hcb_batch_close(batch);
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+    }
+    batch->thread_count = search_set_threads(search, options != NULL ? options->threads : 0);
+    batch->pinned = options != NULL && options->pinned;
+    search_destroy(search);
+    for (int i = 0; i < batch->thread_count; i++) {
+        pool_thread_t* thread = &batch->threads[i];
+        thread->batch = batch;
+        thread->chain = -1;
+        thread->previous = -1;
+        if ((thread->search = search_create()) == NULL) {
+            hcb_batch_close(batch);
+            return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+        }
+        if (options != NULL && options->kernel != NULL) {
+            search_set_kernel(thread->search, options->kernel);
+        }
+        search_set_throttle(thread->search, options != NULL ? options->throttle : NULL);
+    }
+
+    *result = batch;
+    return util_fail(error, HCB_OK, "");
+
+}
+
+// Lowest nonce of the current level of a chain that may not have been tested, capped by the
+// lowest valid one
+static nonce_t batch_position(hcb_batch* batch, int index) {
+    chain_t* chain = &batch->chains[index];
+    nonce_t position = chain->next < chain->best ? chain->next : chain->best;
+    for (int i = 0; i < batch->thread_count; i++) {
+        pool_thread_t* thread = &batch->threads[i];
+        if (thread->chain == index && thread->level == chain->level && thread->position < position) {
+            position = thread->position;
+        }
+    }
+    return position;
+}
+
+// Whether a chain has a slice to give to a thread
+static bool batch_searchable(const chain_t* chain) {
+    return !chain->writing && chain->next < chain->best;
+}
+
+// Chain whose next slice is searched by the free thread self, -1 if every chain is being written
+// or has no nonce left below its lowest valid one
+// The thread goes to the chain the fewest threads search, but stays on the memory-hard chain of
+// its last slice while every other chain has a thread: its scratchpad is filled for the level
+static int batch_pick(hcb_batch* batch, const pool_thread_t* self) {
+    int picked = -1;
+    for (int k = 0; k < batch->chain_count; k++) {
+        int i = (batch->cursor + k) % batch->chain_count;
+        chain_t* chain = &batch->chains[i];
+        if (batch_searchable(chain) && (picked < 0 || chain->searching < batch->chains[picked].searching)) {
+            picked = i;
+        }
+    }
+    if (picked >= 0 && self->previous >= 0 && batch->chains[picked].searching > 0) {
+        chain_t* previous = &batch->chains[self->previous];
+        if (batch_searchable(previous) && hcb_builder_memory(previous->builder) != 0) {
+            return self->previous;
+        }
+    }
+    if (picked >= 0) {
+        batch->cursor = (picked + 1) % batch->chain_count;
+    }
+    return picked;
+}
+
+// Stop every thread, the first error is kept
+static void batch_stop(hcb_batch* batch, const hcb_error* error) {
+    if (error != NULL && batch->error.status == HCB_OK) {
+        batch->error = *error;
+    }
+    batch->stopped = true;
+    for (int i = 0; i < batch->thread_count; i++) {
+        search_cancel(batch->threads[i].search);
+    }
+    pthread_cond_broadcast(&batch->changed);
+}
+
+// Append the block of a chain whose lowest valid nonce is known, then start its next level
+// Called with the lock held, which is released while writing
+static void batch_write(hcb_batch* batch, int index) {
+
+    chain_t* chain = &batch->chains[index];
+    hcb_block block;
+    hcb_error error;
+
+    chain->writing = true;
+    pthread_mutex_unlock(&batch->lock);
+    hcb_status status = hcb_builder_append(chain->builder, chain->best, (long long unsigned int)(chain->best + 1 - chain->resume), util_now() - chain->start, &block, &error);
+    if (status == HCB_OK && batch->callback != NULL) {
+        batch->callback(index, &block, batch->data);
+    }
+    pthread_mutex_lock(&batch->lock);
+
+    if (status != HCB_OK) {
+        batch_stop(batch, &error);
+        return;
+    }
+    chain_start(chain);
+    chain->writing = false;
+    pthread_cond_broadcast(&batch->changed);
+
+}
+
+// Thread of the pool: searches slices of the chains until the batch is stopped
+static void* batch_thread(void* arg) {
+
+    pool_thread_t* self = arg;
+    hcb_batch* batch = self->batch;
+    BYTE hash[SHA256_BLOCK_SIZE];
+    nonce_t nonce;
+
+    // The searcher of the thread creates its worker from it, on the same CPU
+    if (batch->pinned) {
+        search_pin_thread(self - batch->threads);
+    }
+
+    pthread_mutex_lock(&batch->lock);
+    while (!batch->stopped) {
+
+        int index = batch_pick(batch, self);
+        if (index < 0) {
+            pthread_cond_wait(&batch->changed, &batch->lock);
+            continue;
+        }
+
+        // Claim the next slice of the chain
+        chain_t* chain = &batch->chains[index];
+        const char* message = hcb_builder_message(chain->builder);
+        size_t size = strlen(message) + 1;
+        if (size > self->message_size) {
+            char* copy = realloc(self->message, size);
+            if (copy == NULL) {
+                hcb_error error;
+                util_fail(&error, HCB_ERROR_MEMORY, "Error: Out of memory");
+                batch_stop(batch, &error);
+                break;
+            }
+            self->message = copy;
+            self->message_size = size;
+        }
+
+        memcpy(self->message, message, size);
+        self->chain = self->previous = index;
+        self->level = chain->level;
+        self->start = self->position = chain->next;
+        self->end = NONCE_MAX - chain->next > BATCH_SLICE_SIZE ? chain->next + BATCH_SLICE_SIZE : NONCE_MAX;
+        chain->next = self->end;
+        chain->searching++;
+        size_t memory = hcb_builder_memory(chain->builder);
+        pthread_mutex_unlock(&batch->lock);
+
+        // A memory-hard chain is searched with a scratchpad of its own size in each thread,
+        // allocated without holding the lock
+        if (!search_set_memory(self->search, memory)) {
+            hcb_error error;
+            util_fail(&error, HCB_ERROR_MEMORY, "Error: Out of memory for a scratchpad of %zu KiB", memory);
+            pthread_mutex_lock(&batch->lock);
+            chain->searching--;
+            batch_stop(batch, &error);
+            break;
+        }
+
+        search_set_position(self->search, self->start);
+        search_set_hash(self->search, hcb_builder_hash(chain->builder));
+        int result = search_run(self->search, self->message, self->level, self->start, self->end, &nonce, hash);
+
+        pthread_mutex_lock(&batch->lock);
+        chain->searching--;
+
+        // The slice stays attached to the chain, its position is where the search resumes: the
+        // first nonce the cancelled search did not test, never one past a valid nonce
+        if (result == SEARCH_CANCELLED) {
+            self->position = search_position(self->search);
+            break;
+        }
+        self->chain = -1;
+
+        // A slice of a level already written, or being written
+        if (self->level != chain->level || chain->writing) {
+            continue;
+        }
+        if (result == SEARCH_FOUND && nonce < chain->best) {
+            chain->best = nonce;
+        }
+
+        // The block is written once every nonce below the lowest valid one was tested
+        nonce_t position = batch_position(batch, index);
+        if (position < chain->best) {
+            search_set_position(hcb_builder_search(chain->builder), position);
+        } else {
+            batch_write(batch, index);
+        }
+
+    }
+    pthread_mutex_unlock(&batch->lock);
+    return NULL;
+
+}
+
+hcb_status hcb_batch_run(hcb_batch* batch, hcb_batch_callback callback, void* data, hcb_error* error) {
+
+    pthread_t threads[SEARCH_MAX_THREADS];
+
+    if (batch->chain_count == 0) {
+        return util_fail(error, HCB_OK, "");
+    }
+    batch->callback = callback;
+    batch->data = data;
+    for (int i = 0; i < batch->chain_count; i++) {
+        chain_start(&batch->chains[i]);
+    }
+
+    // Without any thread, the pool runs in the calling one
+    int started = 0;
+    for (; started < batch->thread_count; started++) {
+        if (pthread_create(&threads[started], NULL, batch_thread, &batch->threads[started]) != 0) {
+            break;
+        }
+    }
+    if (started == 0) {
+        batch_thread(&batch->threads[0]);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // Save where every chain stopped, for the checkpoints
+    for (int i = 0; i < batch->chain_count; i++) {
+        if (!batch->chains[i].writing) {
+            search_set_position(hcb_builder_search(batch->chains[i].builder), batch_position(batch, i));
+        }
+    }
+
+    if (batch->error.status != HCB_OK) {
+        if (error != NULL) {
+            *error = batch->error;
+        }
+        return batch->error.status;
+    }
+    return util_fail(error, HCB_CANCELLED, "Batch cancelled");
+
+}
+
+void hcb_batch_cancel(hcb_batch* batch) {
+    pthread_mutex_lock(&batch->lock);
+    batch_stop(batch, NULL);
+    pthread_mutex_unlock(&batch->lock);
+}
+
+void hcb_batch_close(hcb_batch* batch) {
+    if (batch == NULL) {
+        return;
+    }
+    for (int i = 0; i < batch->thread_count; i++) {
+        search_destroy(batch->threads[i].search);
+        free(batch->threads[i].message);
+    }
+    pthread_mutex_destroy(&batch->lock);
+    pthread_cond_destroy(&batch->changed);
+    free(batch->chains);
+    free(batch);
+}
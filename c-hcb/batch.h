@@ -0,0 +1,46 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "hcb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Nonces of a chain a thread searches at once before picking a chain again: a whole number of
+// epochs, so the lanes of a kernel are always filled with candidates of a single chain
+#define BATCH_SLICE_SIZE (100 * SEARCH_CHUNK_SIZE)
+
+// Builds several independent chains with one pool of threads: every thread searches a slice of
+// the chain with the fewest threads, so the cores go to the chains that still have nonces to
+// test while the others write their blocks
+// The lowest valid nonce of each level is always kept, so every chain is the same as the one a
+// single process would produce
+typedef struct hcb_batch hcb_batch;
+
+// Called after each block appended to the chain number chain, from the thread that found it
+typedef void (*hcb_batch_callback)(int chain, const hcb_block* block, void* data);
+
+// Build the chains of the count builders, which must stay open while the batch runs
+// options give the threads of the pool, their pinning and the kernel, the options of the builders
+// are ignored
+hcb_status hcb_batch_create(hcb_batch** batch, hcb_builder* const builders[], int count, const hcb_options* options, hcb_error* error);
+
+// Search the blocks of every chain until hcb_batch_cancel is called or a chain cannot be written,
+// callback may be NULL
+// The search progress of each chain is kept in its builder, so hcb_builder_position and
+// hcb_builder_checkpoint can be used while it runs and once it returns
+// Returns HCB_CANCELLED if hcb_batch_cancel was called, a batch only runs once
+hcb_status hcb_batch_run(hcb_batch* batch, hcb_batch_callback callback, void* data, hcb_error* error);
+
+// Stop the search, can be called from any thread
+void hcb_batch_cancel(hcb_batch* batch);
+
+// The builders are not closed
+void hcb_batch_close(hcb_batch* batch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   // BATCH_H
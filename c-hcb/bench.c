@@ -0,0 +1,649 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "sha256.h"
+#include "search.h"
+#include "hcb.h"
+#include "binary.h"
+#include "hash.h"
+#include "energy.h"
+#include "util.h"
+
+// Result of one benchmark
+typedef struct {
+    char name[64];
+    const char* unit;                    // What one operation is
+    long long unsigned int ops;
+    double seconds;
+    long long int cycles;                // -1 if the counter is not available
+    long long int instructions;          // -1 if the counter is not available
+    double joules;                       // Energy of the processor packages, -1 if not available
+} result_t;
+
+// Hardware counters opened with perf_event_open, -1 if not available
+static int cycles_fd = -1;
+static int instructions_fd = -1;
+
+// Energy counters of the processor packages, NULL if not available
+static energy_t* energy = NULL;
+
+// Values the benchmarks compute, kept so the compiler does not remove the work
+static volatile WORD sink;
+
+// Options of the benchmarks
+static int bench_threads = 1;
+static long long unsigned int bench_attempts = 1 << 22;
+static double bench_scale = 1;
+
+// Searcher of the search benchmarks and options of the check benchmark
+static search_t* bench_search;
+static hcb_options bench_options;
+
+// Chain checked by the check_chain benchmark, and its binary copy checked by check_binary
+static char chain_path[64];
+static char binary_path[sizeof(chain_path) + 4];     // chain_path followed by .bin
+static int chain_blocks;
+
+// A level of the chain replayed by --replay: its message and the nonce recorded for its block
+typedef struct {
+    int level;
+    char* message;
+    nonce_t nonce;
+} replay_t;
+
+// Open a hardware counter of this process and its future threads
+static int counter_open(long long unsigned int config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void counter_start(int fd) {
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+static long long int counter_stop(int fd) {
+    long long int value = -1;
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &value, sizeof(value)) != sizeof(value)) {
+            value = -1;
+        }
+    }
+    return value;
+}
+
+// Number of operations of a benchmark, scaled by --scale
+static long long unsigned int scaled(long long unsigned int ops) {
+    long long unsigned int value = ops * bench_scale;
+    return value > 0 ? value : 1;
+}
+
+// Rate of the scalar kernel in the same family as r (kernel_ or search_ of a SHA-256 kernel), the
+// baseline of the other kernels, 0 if there is none
+static double baseline_rate(const result_t results[], int count, const result_t* r) {
+    char name[64];
+    const char* kernel = strchr(r->name, '_');
+    if (kernel == NULL || sha256_kernel_find(kernel + 1) == NULL) {
+        return 0;
+    }
+    snprintf(name, sizeof(name), "%.*s_scalar", (int)(kernel - r->name), r->name);
+    for (int i = 0; i < count; i++) {
+        if (strcmp(results[i].name, name) == 0) {
+            return results[i].ops / results[i].seconds;
+        }
+    }
+    return 0;
+}
+
+// Run a benchmark doing ops operations in a single call of run, which returns the number of
+// operations actually done
+static result_t measure(const char* name, const char* unit, long long unsigned int (*run)(long long unsigned int, const void*), long long unsigned int ops, const void* arg) {
+
+    result_t result;
+    snprintf(result.name, sizeof(result.name), "%s", name);
+    result.unit = unit;
+
+    // Warm up the caches and the frequency
+    run(ops / 16 + 1, arg);
+
+    // The energy is read around the run only, never from its loop
+    double joules = energy != NULL ? energy_read(energy) : 0;
+    counter_start(cycles_fd);
+    counter_start(instructions_fd);
+    double start = util_now();
+    result.ops = run(ops, arg);
+    result.seconds = util_now() - start;
+    result.cycles = counter_stop(cycles_fd);
+    result.instructions = counter_stop(instructions_fd);
+    result.joules = energy != NULL ? energy_read(energy) - joules : -1;
+    return result;
+
+}
+
+// One compression of a single block, through the dispatch used by sha256_transform
+static long long unsigned int run_compress(long long unsigned int ops, const void* arg) {
+    (void)arg;
+    WORD state[8];
+    BYTE block[64];
+    sha256_init_state(state);
+    memset(block, 'a', sizeof(block));
+    for (long long unsigned int i = 0; i < ops; i++) {
+        sha256_compress(state, block);
+    }
+    sink = state[0];
+    return ops;
+}
+
+// One call of a multi-buffer kernel, compressing one block per lane
+static long long unsigned int run_kernel(long long unsigned int ops, const void* arg) {
+    const SHA256_KERNEL* kernel = arg;
+    WORD state[SHA256_MAX_LANES][8];
+    BYTE blocks[SHA256_MAX_LANES][64];
+    for (int l = 0; l < kernel->lanes; l++) {
+        sha256_init_state(state[l]);
+        memset(blocks[l], 'a' + l, 64);
+    }
+    long long unsigned int calls = (ops + kernel->lanes - 1) / kernel->lanes;
+    for (long long unsigned int i = 0; i < calls; i++) {
+        kernel->transform(state, (const BYTE (*)[64])blocks);
+    }
+    sink = state[0][0];
+    return calls * kernel->lanes;
+}
+
+// Hash a standard 129 bytes "hash\nnonce" message with the regular API
+static long long unsigned int run_update(long long unsigned int ops, const void* arg) {
+    (void)arg;
+    SHA256_CTX ctx;
+    BYTE message[SHA256_BLOCK_SIZE * 4 + 1];
+    BYTE hash[SHA256_BLOCK_SIZE];
+    memset(message, '0', sizeof(message));
+    message[SHA256_BLOCK_SIZE * 2] = '\n';
+    for (long long unsigned int i = 0; i < ops; i++) {
+        message[0] = (BYTE)i;
+        sha256_init(&ctx);
+        sha256_update(&ctx, message, sizeof(message));
+        sha256_final(&ctx, hash);
+    }
+    sink = hash[0];
+    return ops;
+}
+
+// Format a nonce the way the chain stores it
+static long long unsigned int run_format(long long unsigned int ops, const void* arg) {
+    (void)arg;
+    char nonce[SHA256_BLOCK_SIZE * 2 + 1];
+    for (long long unsigned int i = 0; i < ops; i++) {
+        nonce_format((nonce_t)i * 7919, nonce_length, nonce);
+    }
+    sink = nonce[nonce_length - 1];
+    return ops;
+}
+
+// Count the leading zeros of hashes with an increasing number of them
+static long long unsigned int run_zero(long long unsigned int ops, const void* arg) {
+    (void)arg;
+    BYTE hashes[64][SHA256_BLOCK_SIZE];
+    WORD total = 0;
+    memset(hashes, 0, sizeof(hashes));
+    for (int i = 0; i < 64; i++) {
+        hashes[i][i / 8] = 0x80 >> (i % 8);
+    }
+    for (long long unsigned int i = 0; i < ops; i++) {
+        total += numberOfZero(hashes[i & 63], SHA256_BLOCK_SIZE);
+    }
+    sink = total;
+    return ops;
+}
+
+static long long unsigned int run_hex(long long unsigned int ops, const void* arg) {
+    (void)arg;
+    BYTE hash[SHA256_BLOCK_SIZE];
+    char hex[SHA256_BLOCK_SIZE * 2 + 1];
+    memset(hash, 0xA5, sizeof(hash));
+    for (long long unsigned int i = 0; i < ops; i++) {
+        hash[0] = (BYTE)i;
+        byteToHex(hash, SHA256_BLOCK_SIZE, hex);
+    }
+    sink = hex[0];
+    return ops;
+}
+
+// Check the generated chain (arg is its path), one operation is one block
+static long long unsigned int run_check(long long unsigned int ops, const void* arg) {
+    hcb_chain_info info;
+    long long unsigned int checks = (ops + chain_blocks - 1) / chain_blocks;
+    for (long long unsigned int i = 0; i < checks; i++) {
+        hcb_check(arg, &bench_options, &info, NULL);
+        sink = info.last_hash[0];
+    }
+    return checks * chain_blocks;
+}
+
+// Test a fixed number of nonces at a difficulty that is never reached
+static long long unsigned int run_search(long long unsigned int ops, const void* arg) {
+    BYTE hash[SHA256_BLOCK_SIZE];
+    nonce_t nonce;
+    search_set_kernel(bench_search, arg);
+    search_run(bench_search, "0000000000000000000000000000000000000000000000000000000000000000", 128, 0, ops, &nonce, hash);
+    return ops;
+}
+
+// Same search with another hash algorithm (arg), one hash of the whole block per nonce
+static long long unsigned int run_search_hash(long long unsigned int ops, const void* arg) {
+    BYTE hash[SHA256_BLOCK_SIZE];
+    nonce_t nonce;
+    search_set_hash(bench_search, arg);
+    search_run(bench_search, "0000000000000000000000000000000000000000000000000000000000000000", 128, 0, ops, &nonce, hash);
+    search_set_hash(bench_search, &hash_sha256);
+    return ops;
+}
+
+// Scratchpad sizes of the memory-hard benchmarks, in KiB: about a L2 cache, a L3 cache and DRAM
+static const size_t memory_sizes[] = {256, 8 * 1024, 256 * 1024};
+
+// Same search on a memory-hard chain with a scratchpad of arg KiB, filled once by the warm up
+static long long unsigned int run_search_memory(long long unsigned int ops, const void* arg) {
+    BYTE hash[SHA256_BLOCK_SIZE];
+    nonce_t nonce;
+    if (!search_set_memory(bench_search, *(const size_t*)arg)) {
+        printf("Error: Out of memory\n\n");
+        exit(HCB_ERROR_MEMORY);
+    }
+    search_run(bench_search, "0000000000000000000000000000000000000000000000000000000000000000", 128, 0, ops, &nonce, hash);
+    return ops;
+}
+
+// Search a level of a replayed chain (arg) from nonce 0 to its recorded nonce, or to ops nonces
+// The valid nonces below the recorded one are skipped, so the work only depends on the chain
+static long long unsigned int run_replay(long long unsigned int ops, const void* arg) {
+    const replay_t* replay = arg;
+    BYTE hash[SHA256_BLOCK_SIZE];
+    nonce_t nonce, start = 0;
+    nonce_t end = (nonce_t)ops < replay->nonce + 1 ? (nonce_t)ops : replay->nonce + 1;
+    while (search_run(bench_search, replay->message, replay->level, start, end, &nonce, hash) == SEARCH_FOUND && nonce + 1 < end) {
+        start = nonce + 1;
+    }
+    return (long long unsigned int)end;
+}
+
+// Read the levels of the chain at path (text or binary) to replay, up to max_levels (-1 for all)
+// Returns the number of levels, the chain is checked first
+static int replay_load(const char* path, int max_levels, replay_t** result) {
+
+    hcb_error error;
+    hcb_chain_info info;
+    char hex[SHA256_BLOCK_SIZE * 2 + 1];
+    BYTE hash[SHA256_BLOCK_SIZE];
+
+    if (hcb_check(path, &bench_options, &info, &error) != HCB_OK) {
+        printf("%s\n\n", error.message);
+        exit(error.status);
+    }
+    search_set_hash(bench_search, info.hash);
+    if (!search_set_memory(bench_search, info.memory)) {
+        printf("Error: Out of memory\n\n");
+        exit(HCB_ERROR_MEMORY);
+    }
+    int levels = max_levels >= 0 && max_levels < info.blocks ? max_levels : info.blocks;
+    replay_t* replays = calloc(levels > 0 ? levels : 1, sizeof(replay_t));
+    if (replays == NULL) {
+        printf("Error: Out of memory\n\n");
+        exit(HCB_ERROR_MEMORY);
+    }
+
+    // The message of a level is the start message or the hash line of the previous block
+    bool valid = true;
+    if (hcb_is_binary(path)) {
+
+        hcb_binary* chain;
+        if (hcb_binary_open(&chain, path, &error) != HCB_OK) {
+            printf("%s\n\n", error.message);
+            exit(error.status);
+        }
+        const char* message = hcb_binary_message(chain);
+        for (int level = 0; level < levels && valid; level++) {
+            replays[level].level = level;
+            replays[level].message = strdup(message);
+            valid = hcb_binary_block(chain, level, hex, hash, NULL) == HCB_OK && nonce_parse(hex, nonce_length, &replays[level].nonce);
+            byteToHex(hash, SHA256_BLOCK_SIZE, hex);
+            message = hex;
+        }
+        hcb_binary_close(chain);
+
+    } else {
+
+        // The lines of a valid chain, without its comments: header, message, then nonce,
+        // separator and hash of each block
+        char* line = NULL;
+        size_t size = 0;
+        ssize_t length;
+        int current_line = 0;
+        char* message = NULL;
+        FILE* fp = fopen(path, "r");
+        while (fp != NULL && valid && (length = getline(&line, &size, fp)) >= 0) {
+            line[strcspn(line, "\r\n")] = '\0';
+            if (line[0] == '#') {
+                continue;
+            }
+            current_line++;
+            int level = (current_line - 3) / 3;
+            if (level >= levels) {
+                break;
+            }
+            if (current_line == 2 || (current_line > 2 && current_line % 3 == 2)) {
+                free(message);
+                message = strdup(line);
+            } else if (current_line > 2 && current_line % 3 == 0) {
+                replays[level].level = level;
+                replays[level].message = message;
+                message = NULL;
+                valid = nonce_parse(line, nonce_length, &replays[level].nonce);
+            }
+        }
+        free(message);
+        free(line);
+        if (fp != NULL) {
+            fclose(fp);
+        }
+
+    }
+
+    for (int level = 0; level < levels; level++) {
+        valid = valid && replays[level].message != NULL;
+    }
+    if (!valid) {
+        printf("Error: Unable to replay \"%s\", its nonces must fit in %d digits\n\n", path, NONCE_DIGITS);
+        exit(HCB_ERROR_NONCE);
+    }
+    *result = replays;
+    return levels;
+
+}
+
+// Write a valid chain of the given number of blocks to chain_path
+static void chain_create(int blocks) {
+
+    hcb_builder* builder;
+    hcb_error error;
+
+    snprintf(chain_path, sizeof(chain_path), "/tmp/hcb-bench-XXXXXX");
+    int fd = mkstemp(chain_path);
+    if (fd < 0 || hcb_builder_create(&builder, chain_path, "HCB benchmark", &bench_options, &error) != HCB_OK) {
+        printf("Error: Unable to create the benchmark chain\n\n");
+        exit(2);
+    }
+    close(fd);
+    for (int level = 0; level < blocks; level++) {
+        if (hcb_builder_next(builder, NULL, &error) != HCB_OK) {
+            printf("%s\n\n", error.message);
+            exit(2);
+        }
+    }
+    hcb_builder_close(builder);
+    chain_blocks = blocks;
+
+    snprintf(binary_path, sizeof(binary_path), "%s.bin", chain_path);
+    if (hcb_to_binary(chain_path, binary_path, &bench_options, &error) != HCB_OK) {
+        printf("%s\n\n", error.message);
+        exit(2);
+    }
+
+}
+
+static void print_usage() {
+    printf("Usage: hcb-bench [--json] [--threads N] [--attempts N] [--scale X] [--powercap DIR]\n");
+    printf("       hcb-bench [--json] [--threads N] [--kernel NAME] [--levels N] [--powercap DIR] --replay FILE\n\n");
+    printf("\t--json\t\tPrint the results as JSON\n");
+    printf("\t--threads N\tThreads used by the search and check benchmarks (0 for one per CPU, default 1)\n");
+    printf("\t--attempts N\tNonces tested by each search benchmark (default %llu)\n", bench_attempts);
+    printf("\t--scale X\tMultiply the number of operations of the other benchmarks by X (default 1)\n");
+    printf("\t--replay FILE\tSearch again every nonce from 0 to the recorded one of each level of the chain\n");
+    printf("\t\t\tFILE instead of the other benchmarks: a fixed amount of work, the same on every host\n");
+    printf("\t--levels N\tOnly replay the levels 0 to N-1\n");
+    printf("\t--kernel NAME\tKernel searching the replayed levels (default the fastest supported one)\n");
+    printf("\t--powercap DIR\tRead the energy of the processor packages from the RAPL zones of the powercap\n");
+    printf("\t\t\ttree DIR (default %s)\n\n", ENERGY_POWERCAP_ROOT);
+}
+
+int main(int argc, char** argv) {
+
+    bool json = false;
+    result_t results[64];
+    int count = 0;
+    const char* replay_path = NULL;
+    int replay_levels = -1;
+    const SHA256_KERNEL* replay_kernel = NULL;
+    const char* powercap_root = NULL;
+
+    for (int arg = 1; arg < argc; arg++) {
+        char* end_ptr = NULL;
+        if (strcmp(argv[arg], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc) {
+            bench_threads = strtol(argv[++arg], &end_ptr, 10);
+            if (bench_threads < 0) {
+                printf("Error: --threads expects a positive or zero integer\n\n");
+                print_usage();
+                return 1;
+            }
+        } else if (strcmp(argv[arg], "--attempts") == 0 && arg + 1 < argc) {
+            bench_attempts = strtoull(argv[++arg], &end_ptr, 10);
+        } else if (strcmp(argv[arg], "--scale") == 0 && arg + 1 < argc) {
+            bench_scale = strtod(argv[++arg], &end_ptr);
+        } else if (strcmp(argv[arg], "--replay") == 0 && arg + 1 < argc) {
+            replay_path = argv[++arg];
+        } else if (strcmp(argv[arg], "--levels") == 0 && arg + 1 < argc) {
+            replay_levels = strtol(argv[++arg], &end_ptr, 10);
+        } else if (strcmp(argv[arg], "--powercap") == 0 && arg + 1 < argc) {
+            powercap_root = argv[++arg];
+        } else if (strcmp(argv[arg], "--kernel") == 0 && arg + 1 < argc && (replay_kernel = sha256_kernel_find(argv[arg + 1])) != NULL && replay_kernel->supported()) {
+            arg++;
+        } else {
+            print_usage();
+            return 1;
+        }
+        if (end_ptr != NULL && (end_ptr == argv[arg] || *end_ptr != '\0')) {
+            print_usage();
+            return 1;
+        }
+    }
+    bench_search = search_create();
+    if (bench_search == NULL) {
+        printf("Error: Out of memory\n\n");
+        return 2;
+    }
+    bench_threads = search_set_threads(bench_search, bench_threads);
+    hcb_options_init(&bench_options);
+    bench_options.threads = bench_threads;
+
+    cycles_fd = counter_open(PERF_COUNT_HW_CPU_CYCLES);
+    instructions_fd = counter_open(PERF_COUNT_HW_INSTRUCTIONS);
+    energy = energy_open(powercap_root);
+    if (energy == NULL && powercap_root != NULL) {
+        printf("Error: No readable RAPL package zone in \"%s\"\n\n", powercap_root);
+        return 1;
+    }
+
+    // Replay of the levels of a chain, then their total, or every other benchmark
+    const SHA256_KERNEL* best = search_get_kernel(bench_search);
+    if (replay_path != NULL) {
+
+        replay_t* replays;
+        int levels = replay_load(replay_path, replay_levels, &replays);
+        // One result is kept for the total
+        size_t max_levels = sizeof(results) / sizeof(results[0]) - 1;
+        if ((size_t)levels > max_levels) {
+            fprintf(stderr, "Warning: Only the first %zu levels of \"%s\" are replayed\n", max_levels, replay_path);
+            levels = (int)max_levels;
+        }
+        if (replay_kernel != NULL) {
+            best = replay_kernel;
+            search_set_kernel(bench_search, best);
+        }
+        result_t total = {"replay_total", "hash", 0, 0, 0, 0, energy != NULL ? 0 : -1};
+        for (int level = 0; level < levels; level++) {
+            char name[64];
+            snprintf(name, sizeof(name), "replay_level_%d", level);
+            results[count] = measure(name, "hash", run_replay, (long long unsigned int)(replays[level].nonce + 1), &replays[level]);
+            total.ops += results[count].ops;
+            total.seconds += results[count].seconds;
+            total.cycles = total.cycles >= 0 && results[count].cycles >= 0 ? total.cycles + results[count].cycles : -1;
+            total.instructions = total.instructions >= 0 && results[count].instructions >= 0 ? total.instructions + results[count].instructions : -1;
+            total.joules = total.joules >= 0 && results[count].joules >= 0 ? total.joules + results[count].joules : -1;
+            count++;
+            free(replays[level].message);
+        }
+        free(replays);
+        results[count++] = total;
+
+    } else {
+
+        // Single operations of the hot paths
+        results[count++] = measure("sha256_transform", "block", run_compress, scaled(2000000), NULL);
+        for (int i = 0; sha256_kernels[i] != NULL; i++) {
+            if (sha256_kernels[i]->supported()) {
+                char name[64];
+                snprintf(name, sizeof(name), "kernel_%s", sha256_kernels[i]->name);
+                results[count++] = measure(name, "block", run_kernel, scaled(4000000), sha256_kernels[i]);
+            }
+        }
+        results[count++] = measure("sha256_update", "hash", run_update, scaled(1000000), NULL);
+        results[count++] = measure("format_nonce", "nonce", run_format, scaled(2000000), NULL);
+        results[count++] = measure("numberOfZero", "hash", run_zero, scaled(20000000), NULL);
+        results[count++] = measure("byteToHex", "hash", run_hex, scaled(5000000), NULL);
+
+        // Parsing and verification of a chain
+        chain_create(18);
+        results[count++] = measure("check_chain", "block", run_check, scaled(100000), chain_path);
+        results[count++] = measure("check_binary", "block", run_check, scaled(100000), binary_path);
+        unlink(chain_path);
+        unlink(binary_path);
+
+        // End-to-end search loop
+        for (int i = 0; sha256_kernels[i] != NULL; i++) {
+            if (sha256_kernels[i]->supported()) {
+                char name[64];
+                snprintf(name, sizeof(name), "search_%s", sha256_kernels[i]->name);
+                results[count++] = measure(name, "hash", run_search, bench_attempts, sha256_kernels[i]);
+            }
+        }
+        search_set_kernel(bench_search, best);
+        for (int i = 0; hash_algorithms[i] != NULL; i++) {
+            if (hash_algorithms[i] != &hash_sha256) {
+                char name[64];
+                snprintf(name, sizeof(name), "search_%s", hash_algorithms[i]->name);
+                results[count++] = measure(name, "hash", run_search_hash, bench_attempts / 4, hash_algorithms[i]);
+            }
+        }
+        for (size_t i = 0; i < sizeof(memory_sizes) / sizeof(memory_sizes[0]); i++) {
+            char name[64];
+            if (memory_sizes[i] % 1024 == 0) {
+                snprintf(name, sizeof(name), "search_memory_%zum", memory_sizes[i] / 1024);
+            } else {
+                snprintf(name, sizeof(name), "search_memory_%zuk", memory_sizes[i]);
+            }
+            results[count++] = measure(name, "hash", run_search_memory, bench_attempts / 64, &memory_sizes[i]);
+        }
+        search_set_memory(bench_search, 0);
+
+    }
+
+    // Report
+    if (json) {
+        printf("{\n  \"threads\": %d,\n  \"best_kernel\": \"%s\",\n  \"counters\": %s,\n  \"energy\": %s,\n  \"benchmarks\": [\n",
+            bench_threads, best->name, cycles_fd >= 0 ? "true" : "false", energy != NULL ? "true" : "false");
+    } else {
+        printf("%-20s %12s %12s %14s %9s %12s %12s %10s %14s\n", "benchmark", "ops", "ns/op", "ops/s", "x scalar", "cycles/op", "instr/op", "watts", "ops/J");
+    }
+    for (int i = 0; i < count; i++) {
+        result_t* r = &results[i];
+        double ns = r->seconds * 1e9 / r->ops;
+        double rate = r->ops / r->seconds;
+        double cycles = r->cycles >= 0 ? (double)r->cycles / r->ops : -1;
+        double instructions = r->instructions >= 0 ? (double)r->instructions / r->ops : -1;
+        double watts = r->joules >= 0 && r->seconds > 0 ? r->joules / r->seconds : -1;
+        double per_joule = r->joules > 0 ? r->ops / r->joules : -1;
+        double baseline = baseline_rate(results, count, r);
+        if (json) {
+            printf("    {\"name\": \"%s\", \"unit\": \"%s\", \"ops\": %llu, \"seconds\": %.6f, \"ns_per_op\": %.3f, \"ops_per_second\": %.1f, ",
+                r->name, r->unit, r->ops, r->seconds, ns, rate);
+            if (baseline > 0) {
+                printf("\"speedup_vs_scalar\": %.2f, ", rate / baseline);
+            } else {
+                printf("\"speedup_vs_scalar\": null, ");
+            }
+            if (cycles >= 0) {
+                printf("\"cycles_per_op\": %.2f, ", cycles);
+            } else {
+                printf("\"cycles_per_op\": null, ");
+            }
+            if (instructions >= 0) {
+                printf("\"instructions_per_op\": %.2f, ", instructions);
+            } else {
+                printf("\"instructions_per_op\": null, ");
+            }
+            if (r->joules >= 0) {
+                printf("\"joules\": %.3f, \"watts\": %.2f, ", r->joules, watts);
+            } else {
+                printf("\"joules\": null, \"watts\": null, ");
+            }
+            if (per_joule >= 0) {
+                printf("\"ops_per_joule\": %.1f}%s\n", per_joule, i + 1 < count ? "," : "");
+            } else {
+                printf("\"ops_per_joule\": null}%s\n", i + 1 < count ? "," : "");
+            }
+        } else {
+            printf("%-20s %12llu %12.2f %14.0f", r->name, r->ops, ns, rate);
+            if (baseline > 0) {
+                printf(" %9.2f", rate / baseline);
+            } else {
+                printf(" %9s", "-");
+            }
+            if (cycles >= 0) {
+                printf(" %12.1f", cycles);
+            } else {
+                printf(" %12s", "-");
+            }
+            if (instructions >= 0) {
+                printf(" %12.1f", instructions);
+            } else {
+                printf(" %12s", "-");
+            }
+            if (watts >= 0) {
+                printf(" %10.1f", watts);
+            } else {
+                printf(" %10s", "-");
+            }
+            if (per_joule >= 0) {
+                printf(" %14.0f\n", per_joule);
+            } else {
+                printf(" %14s\n", "-");
+            }
+        }
+    }
+    if (json) {
+        printf("  ]\n}\n");
+    }
+    energy_close(energy);
+
+    return 0;
+
+}
@@ -0,0 +1,430 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "binary.h"
+#include "verify.h"
+#include "util.h"
+
+// Number of blocks verified at once, so the memory used does not grow with the chain
+#define CHECK_WINDOW 4096
+
+struct hcb_binary {
+    const BYTE* data;
+    size_t size;
+    char* message;
+    long long unsigned int blocks;
+    nonce_t resume;
+    const HASH_ALGORITHM* hash;
+    size_t memory;
+    const BYTE* records;
+};
+
+static uint64_t read_le(const BYTE* bytes, int length) {
+    uint64_t value = 0;
+    for (int i = length - 1; i >= 0; i--) {
+        value = value << 8 | bytes[i];
+    }
+    return value;
+}
+
+static void write_le(BYTE* bytes, uint64_t value, int length) {
+    for (int i = 0; i < length; i++) {
+        bytes[i] = (BYTE)(value >> (i * 8));
+    }
+}
+
+// Write the 64 decimal digits of a 256 bits big-endian nonce, returns false if it does not fit
+// The nonce is divided by 10^9 on 32 bits limbs, giving 9 digits at a time
+static bool nonce_digits(const BYTE binary[], char digits[]) {
+    uint32_t limbs[SHA256_BLOCK_SIZE / 4];
+    for (int i = 0; i < SHA256_BLOCK_SIZE / 4; i++) {
+        limbs[i] = (uint32_t)binary[i*4] << 24 | (uint32_t)binary[i*4+1] << 16 | (uint32_t)binary[i*4+2] << 8 | binary[i*4+3];
+    }
+    for (int end = nonce_length; end > 0; end -= 9) {
+        uint64_t remainder = 0;
+        for (int i = 0; i < SHA256_BLOCK_SIZE / 4; i++) {
+            uint64_t current = remainder << 32 | limbs[i];
+            limbs[i] = (uint32_t)(current / 1000000000);
+            remainder = current % 1000000000;
+        }
+        for (int d = end - 1; d >= 0 && d >= end - 9; d--) {
+            digits[d] = '0' + remainder % 10;
+            remainder /= 10;
+        }
+        // The first digits of the field are not a full group of 9
+        if (remainder != 0) {
+            return false;
+        }
+    }
+    digits[nonce_length] = '\0';
+    for (int i = 0; i < SHA256_BLOCK_SIZE / 4; i++) {
+        if (limbs[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Read the 64 decimal digits of a nonce as a 256 bits big-endian integer
+static void nonce_binary(const char* digits, BYTE binary[]) {
+    memset(binary, 0, SHA256_BLOCK_SIZE);
+    for (int d = 0; d < nonce_length; d++) {
+        unsigned int carry = digits[d] - '0';
+        for (int i = SHA256_BLOCK_SIZE - 1; i >= 0; i--) {
+            unsigned int current = binary[i] * 10 + carry;
+            binary[i] = (BYTE)current;
+            carry = current >> 8;
+        }
+    }
+}
+
+bool hcb_is_binary(const char* path) {
+    char magic[4];
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    bool binary = fread(magic, 1, sizeof(magic), fp) == sizeof(magic) && memcmp(magic, HCB_BINARY_MAGIC, sizeof(magic)) == 0;
+    fclose(fp);
+    return binary;
+}
+
+hcb_status hcb_binary_open(hcb_binary** result, const char* path, hcb_error* error) {
+
+    *result = NULL;
+
+    // Open and map the file, its records are read in place
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return util_fail(error, HCB_ERROR_OPEN, "Error: Unable to open file \"%s\"", path);
+    }
+    size_t size = st.st_size;
+    const BYTE* data = size > 0 ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+    close(fd);
+    if (data == MAP_FAILED) {
+        return util_fail(error, HCB_ERROR_OPEN, "Error: Unable to open file \"%s\"", path);
+    }
+
+    // Header: version 1.0 for SHA-256, 1.1 followed by the number of the algorithm for the others,
+    // 1.2 for the memory-hard chains, which also have the size of their scratchpads
+    const HASH_ALGORITHM* hash = size < HCB_BINARY_HEADER || memcmp(data, HCB_BINARY_MAGIC, 4) != 0 || data[4] != 1 ? NULL :
+        data[5] == 0 && data[6] == 0 ? &hash_sha256 : data[5] == 1 || data[5] == 2 ? hash_algorithm_id(data[6]) : NULL;
+    size_t memory = hash != NULL && data[5] == 2 ? read_le(data + 12, 4) : 0;
+    if (hash == NULL || (data[5] == 2) != (memory >= SCRATCHPAD_MIN_SIZE && memory <= SCRATCHPAD_MAX_SIZE)) {
+        if (data != NULL) {
+            munmap((void*)data, size);
+        }
+        return util_fail(error, HCB_ERROR_FIRST_LINE, "Error while checking \"%s\": Not a binary HCB 1.0, 1.1 or 1.2 chain", path);
+    }
+    hcb_binary* chain = calloc(1, sizeof(hcb_binary));
+    if (chain == NULL) {
+        munmap((void*)data, size);
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+    }
+    chain->data = data;
+    chain->size = size;
+    chain->hash = hash;
+    chain->memory = memory;
+    size_t message_length = read_le(data + 8, 4);
+    chain->blocks = read_le(data + 16, 8);
+    chain->resume = (nonce_t)read_le(data + 32, 8) << 64 | read_le(data + 24, 8);
+
+    // The records fill the rest of the file
+    if (message_length > size - HCB_BINARY_HEADER || chain->blocks != (size - HCB_BINARY_HEADER - message_length) / HCB_BINARY_RECORD ||
+        (size - HCB_BINARY_HEADER - message_length) % HCB_BINARY_RECORD != 0) {
+        hcb_binary_close(chain);
+        return util_fail(error, HCB_ERROR_END, "Error while checking \"%s\": File size does not match its number of blocks", path);
+    }
+    chain->records = data + HCB_BINARY_HEADER + message_length;
+    if ((chain->message = malloc(message_length + 1)) == NULL) {
+        hcb_binary_close(chain);
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+    }
+    memcpy(chain->message, data + HCB_BINARY_HEADER, message_length);
+    chain->message[message_length] = '\0';
+    if (strlen(chain->message) != message_length || strchr(chain->message, '\n') != NULL || strchr(chain->message, '\r') != NULL) {
+        hcb_binary_close(chain);
+        return util_fail(error, HCB_ERROR_MESSAGE, "Error while checking \"%s\": Start message must be over one single line", path);
+    }
+
+    *result = chain;
+    return util_fail(error, HCB_OK, "");
+
+}
+
+long long unsigned int hcb_binary_blocks(const hcb_binary* chain) {
+    return chain->blocks;
+}
+
+const char* hcb_binary_message(const hcb_binary* chain) {
+    return chain->message;
+}
+
+const HASH_ALGORITHM* hcb_binary_hash(const hcb_binary* chain) {
+    return chain->hash;
+}
+
+size_t hcb_binary_memory(const hcb_binary* chain) {
+    return chain->memory;
+}
+
+hcb_status hcb_binary_block(const hcb_binary* chain, long long unsigned int n, char nonce[], BYTE hash[], hcb_error* error) {
+    if (n >= chain->blocks) {
+        return util_fail(error, HCB_ERROR_BLOCK, "Error: Block #%llu is past the end of the chain of %llu blocks", n, chain->blocks);
+    }
+    const BYTE* record = chain->records + n * HCB_BINARY_RECORD;
+    char digits[SHA256_BLOCK_SIZE * 2 + 1];
+    if (!nonce_digits(record, digits)) {
+        return util_fail(error, HCB_ERROR_NONCE, "Error: Nonce of block #%llu does not fit in %d digits", n, nonce_length);
+    }
+    if (nonce != NULL) {
+        memcpy(nonce, digits, sizeof(digits));
+    }
+    if (hash != NULL) {
+        memcpy(hash, record + SHA256_BLOCK_SIZE, SHA256_BLOCK_SIZE);
+    }
+    return util_fail(error, HCB_OK, "");
+}
+
+void hcb_binary_close(hcb_binary* chain) {
+    if (chain == NULL) {
+        return;
+    }
+    if (chain->data != NULL) {
+        munmap((void*)chain->data, chain->size);
+    }
+    free(chain->message);
+    free(chain);
+}
+
+// Verify the records of a chain window by window, the hexadecimal messages and decimal nonces
+// hashed by verify_blocks are rebuilt from the raw ones
+// info->blocks receives the number of blocks preceding the first invalid one
+static hcb_status check_records(const char* path, const hcb_binary* chain, const hcb_options* options, hcb_chain_info* info, hcb_error* error) {
+
+    const SHA256_KERNEL* kernel = options->kernel != NULL ? options->kernel : sha256_kernel_best();
+    size_t window = chain->blocks < CHECK_WINDOW ? chain->blocks + 1 : CHECK_WINDOW;
+    verify_block_t* blocks = malloc(window * sizeof(verify_block_t));
+    char* hex = malloc((window + 1) * sha256_hex_length);
+    char* nonces = malloc(window * (nonce_length + 1));
+    scratchpad_t* scratchpad = chain->memory != 0 ? scratchpad_create(chain->memory) : NULL;
+    hcb_status status = HCB_OK;
+    if (blocks == NULL || hex == NULL || nonces == NULL) {
+        status = util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+    } else if (chain->memory != 0 && scratchpad == NULL) {
+        status = util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory for a scratchpad of %zu KiB", chain->memory);
+    }
+
+    for (long long unsigned int first = 0; status == HCB_OK && first < chain->blocks; first += window) {
+
+        size_t count = chain->blocks - first < window ? chain->blocks - first : window;
+        char text[SHA256_BLOCK_SIZE * 2 + 1];
+
+        // hex holds the hash preceding the window, then the hash of each block
+        if (first > 0) {
+            byteToHex(chain->records + (first - 1) * HCB_BINARY_RECORD + SHA256_BLOCK_SIZE, SHA256_BLOCK_SIZE, text);
+            memcpy(hex, text, sha256_hex_length);
+        }
+        for (size_t i = 0; i < count; i++) {
+            const BYTE* record = chain->records + (first + i) * HCB_BINARY_RECORD;
+            verify_block_t* block = &blocks[i];
+            char* nonce = nonces + i * (nonce_length + 1);
+            if (!nonce_digits(record, nonce)) {
+                status = util_fail(error, HCB_ERROR_NONCE, "Error while checking \"%s\": Nonce of block #%llu does not fit in %d digits", path, first + i, nonce_length);
+                count = i;
+                break;
+            }
+            byteToHex(record + SHA256_BLOCK_SIZE, SHA256_BLOCK_SIZE, text);
+            memcpy(hex + (i + 1) * sha256_hex_length, text, sha256_hex_length);
+            block->message = first + i == 0 ? chain->message : hex + i * sha256_hex_length;
+            block->message_length = first + i == 0 ? strlen(chain->message) : sha256_hex_length;
+            block->nonce = nonce;
+            memcpy(block->hash, record + SHA256_BLOCK_SIZE, SHA256_BLOCK_SIZE);
+            block->hash_valid = true;
+        }
+
+        // An invalid block comes before an unreadable nonce
+        size_t invalid = verify_blocks(blocks, count, first, options->threads, kernel, chain->hash, scratchpad);
+        info->blocks = (int)(first + invalid);
+        if (invalid < count) {
+            BYTE hash[SHA256_BLOCK_SIZE];
+            char expected[SHA256_BLOCK_SIZE * 2 + 1];
+            verify_hash(&blocks[invalid], chain->hash, scratchpad, hash);
+            byteToHex(hash, SHA256_BLOCK_SIZE, expected);
+            byteToHex(blocks[invalid].hash, SHA256_BLOCK_SIZE, text);
+            if (memcmp(hash, blocks[invalid].hash, SHA256_BLOCK_SIZE) != 0) {
+                status = util_fail(error, HCB_ERROR_HASH, "Error while checking \"%s\": Block #%llu expected hash \"%s\" but got \"%s\"", path, first + invalid, expected, text);
+            } else {
+                status = util_fail(error, HCB_ERROR_DIFFICULTY, "Error while checking \"%s\": Block #%llu (\"%s\") expected difficulty \"%llu\" but got \"%d\"", path, first + invalid, text, first + invalid, numberOfZero(hash, SHA256_BLOCK_SIZE));
+            }
+        }
+
+    }
+
+    free(blocks);
+    free(hex);
+    free(nonces);
+    scratchpad_destroy(scratchpad);
+    return status;
+
+}
+
+hcb_status hcb_binary_check(const char* path, const hcb_options* options, hcb_chain_info* info, hcb_error* error) {
+
+    hcb_options default_options;
+    hcb_chain_info default_info;
+    hcb_binary* chain;
+    if (options == NULL) {
+        hcb_options_init(&default_options);
+        options = &default_options;
+    }
+    if (info == NULL) {
+        info = &default_info;
+    }
+    memset(info, 0, sizeof(hcb_chain_info));
+    info->nonce_lines = -1;
+
+    hcb_status status = hcb_binary_open(&chain, path, error);
+    if (status != HCB_OK) {
+        return status;
+    }
+    info->hash = chain->hash;
+    info->memory = chain->memory;
+    status = check_records(path, chain, options, info, error);
+    if (info->blocks > 0) {
+        memcpy(info->last_hash, chain->records + (info->blocks - 1) * HCB_BINARY_RECORD + SHA256_BLOCK_SIZE, SHA256_BLOCK_SIZE);
+    }
+    if (status == HCB_OK) {
+        info->resume = chain->resume;
+        util_fail(error, HCB_OK, "");
+    }
+    hcb_binary_close(chain);
+    return status;
+
+}
+
+// Read the next line of a text chain that is not a comment, without its line break
+static bool next_line(FILE* fp, char** line, size_t* size) {
+    ssize_t length;
+    while ((length = getline(line, size, fp)) >= 0) {
+        while (length > 0 && ((*line)[length - 1] == '\n' || (*line)[length - 1] == '\r')) {
+            (*line)[--length] = '\0';
+        }
+        if (length == 0 || (*line)[0] != '#') {
+            return true;
+        }
+    }
+    return false;
+}
+
+hcb_status hcb_to_binary(const char* text_path, const char* binary_path, const hcb_options* options, hcb_error* error) {
+
+    hcb_chain_info info;
+    BYTE header[HCB_BINARY_HEADER];
+    BYTE record[HCB_BINARY_RECORD];
+    char* line = NULL;
+    size_t size = 0;
+
+    // The chain is known to be valid, so its lines are read without checking them again
+    hcb_status status = hcb_check(text_path, options, &info, error);
+    if (status != HCB_OK) {
+        return status;
+    }
+    if (hcb_is_binary(text_path)) {
+        return util_fail(error, HCB_ERROR_FIRST_LINE, "Error: \"%s\" is already a binary chain", text_path);
+    }
+    FILE* in = fopen(text_path, "r");
+    if (in == NULL) {
+        return util_fail(error, HCB_ERROR_OPEN, "Error: Unable to open file \"%s\"", text_path);
+    }
+    FILE* out = fopen(binary_path, "wb");
+    if (out == NULL) {
+        fclose(in);
+        return util_fail(error, HCB_ERROR_CREATE, "Error: Unable to open file \"%s\"", binary_path);
+    }
+
+    // Header and start message, following the first line
+    next_line(in, &line, &size);
+    next_line(in, &line, &size);
+    memset(header, 0, sizeof(header));
+    memcpy(header, HCB_BINARY_MAGIC, 4);
+    header[4] = 1;
+    header[5] = info.memory != 0 ? 2 : info.hash == &hash_sha256 ? 0 : 1;
+    header[6] = (BYTE)info.hash->id;
+    write_le(header + 8, strlen(line), 4);
+    write_le(header + 12, info.memory, 4);
+    write_le(header + 16, info.blocks, 8);
+    write_le(header + 24, (uint64_t)info.resume, 8);
+    write_le(header + 32, (uint64_t)(info.resume >> 64), 8);
+    bool written = fwrite(header, sizeof(header), 1, out) == 1 && fwrite(line, 1, strlen(line), out) == strlen(line);
+
+    // Blocks: nonce, separator and hash lines
+    for (int block = 0; written && block < info.blocks; block++) {
+        next_line(in, &line, &size);
+        nonce_binary(line, record);
+        next_line(in, &line, &size);
+        next_line(in, &line, &size);
+        verify_read_hex(line, record + SHA256_BLOCK_SIZE);
+        written = fwrite(record, sizeof(record), 1, out) == 1;
+    }
+
+    free(line);
+    fclose(in);
+    if (fclose(out) != 0 || !written) {
+        return util_fail(error, HCB_ERROR_WRITE, "Error: Unable to write file \"%s\"", binary_path);
+    }
+    return util_fail(error, HCB_OK, "");
+
+}
+
+hcb_status hcb_to_text(const char* binary_path, const char* text_path, const hcb_options* options, hcb_error* error) {
+
+    hcb_binary* chain;
+    char header[SHA256_BLOCK_SIZE * 2 + 1];
+    char nonce[SHA256_BLOCK_SIZE * 2 + 1];
+    char hex[SHA256_BLOCK_SIZE * 2 + 1];
+
+    hcb_status status = hcb_binary_check(binary_path, options, NULL, error);
+    if (status != HCB_OK || (status = hcb_binary_open(&chain, binary_path, error)) != HCB_OK) {
+        return status;
+    }
+    FILE* out = fopen(text_path, "w");
+    if (out == NULL) {
+        hcb_binary_close(chain);
+        return util_fail(error, HCB_ERROR_CREATE, "Error: Unable to open file \"%s\"", text_path);
+    }
+
+    // Written like a builder does
+    hcb_header_line(chain->hash, chain->memory, header);
+    fprintf(out, "# File generated by C-HCB\n%s\n%s\n", header, chain->message);
+    for (long long unsigned int n = 0; n < chain->blocks; n++) {
+        char separator[SHA256_BLOCK_SIZE * 2 + 1];
+        int length = sprintf(separator, "%llu ", n);
+        memset(separator + length, '-', sha256_hex_length - length);
+        separator[sha256_hex_length] = '\0';
+        hcb_binary_block(chain, n, nonce, NULL, NULL);
+        byteToHex(chain->records + n * HCB_BINARY_RECORD + SHA256_BLOCK_SIZE, SHA256_BLOCK_SIZE, hex);
+        fprintf(out, "%s\n%s\n%s\n", nonce, separator, hex);
+    }
+    if (chain->resume > 0) {
+        nonce_format(chain->resume, 0, nonce);
+        fprintf(out, "#nonce:%s\n", nonce);
+    }
+
+    hcb_binary_close(chain);
+    if (fclose(out) != 0) {
+        return util_fail(error, HCB_ERROR_WRITE, "Error: Unable to write file \"%s\"", text_path);
+    }
+    return util_fail(error, HCB_OK, "");
+
+}
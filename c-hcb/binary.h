@@ -0,0 +1,68 @@
+#ifndef BINARY_H
+#define BINARY_H
+
+#include <stdbool.h>
+#include "hcb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Binary chain: a header, the start message, then one record per block
+// Header (little-endian): "HCBB", major and minor HCB version (1, 0 for SHA-256, 1, 1 for the
+// other algorithms, 1, 2 for the memory-hard chains), number of the hash algorithm
+// (HASH_ALGORITHM.id), a zero byte, length of the start message (32 bits), scratchpad size in KiB
+// of a memory-hard chain (32 bits, 0 for the others), number of blocks (64 bits), nonce to resume
+// the search of the next block from (128 bits)
+// Record: the nonce as a 256 bits big-endian integer, then the raw hash of the block
+// Every record has the same size, so the block N starts at
+// HCB_BINARY_HEADER + message length + N * HCB_BINARY_RECORD
+#define HCB_BINARY_MAGIC "HCBB"
+#define HCB_BINARY_HEADER 40
+#define HCB_BINARY_RECORD (SHA256_BLOCK_SIZE * 2)
+
+// A binary chain mapped in memory, to read its blocks in any order
+typedef struct hcb_binary hcb_binary;
+
+// Whether the file at path holds a binary chain
+bool hcb_is_binary(const char* path);
+
+// Check the binary chain stored in the file at path, info may be NULL
+// hcb_check calls it for the binary chains
+hcb_status hcb_binary_check(const char* path, const hcb_options* options, hcb_chain_info* info, hcb_error* error);
+
+// Convert the text chain at text_path, which is checked first, to a binary chain at binary_path
+// The comments are not kept, except the nonce to resume the search from
+hcb_status hcb_to_binary(const char* text_path, const char* binary_path, const hcb_options* options, hcb_error* error);
+
+// Convert the binary chain at binary_path, which is checked first, to a text chain at text_path
+hcb_status hcb_to_text(const char* binary_path, const char* text_path, const hcb_options* options, hcb_error* error);
+
+// Open the binary chain at path, only its header and size are checked
+hcb_status hcb_binary_open(hcb_binary** chain, const char* path, hcb_error* error);
+
+// Number of blocks of the chain
+long long unsigned int hcb_binary_blocks(const hcb_binary* chain);
+
+// Start message of the chain, NUL-terminated
+const char* hcb_binary_message(const hcb_binary* chain);
+
+// Hash algorithm of the chain
+const HASH_ALGORITHM* hcb_binary_hash(const hcb_binary* chain);
+
+// Scratchpad size in KiB of a memory-hard chain, 0 for the others
+size_t hcb_binary_memory(const hcb_binary* chain);
+
+// Read the block number n without reading the other ones, nonce receives its 64 decimal digits
+// as written in a text chain and hash its raw hash, either may be NULL
+// Returns HCB_ERROR_BLOCK if n is not below hcb_binary_blocks, HCB_ERROR_NONCE if the nonce does
+// not fit in 64 digits
+hcb_status hcb_binary_block(const hcb_binary* chain, long long unsigned int n, char nonce[], BYTE hash[], hcb_error* error);
+
+void hcb_binary_close(hcb_binary* chain);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   // BINARY_H
@@ -0,0 +1,139 @@
+/*********************************************************************
+* Filename:   blake2b.c
+* Details:    Implementation of BLAKE2b (RFC 7693) without a key, with
+              a 32 byte digest. The twelve rounds are unrolled, so the
+              message permutation of each round is resolved at compile
+              time and the working vector stays in registers.
+              This implementation uses little endian byte order.
+*********************************************************************/
+
+/*************************** HEADER FILES ***************************/
+#include <string.h>
+#include "hash.h"
+
+/****************************** MACROS ******************************/
+#define ROTRIGHT64(a,b) (((a) >> (b)) | ((a) << (64-(b))))
+
+#define G(a,b,c,d,x,y) do { \
+	a = a + b + (x); d = ROTRIGHT64(d ^ a, 32); \
+	c = c + d;       b = ROTRIGHT64(b ^ c, 24); \
+	a = a + b + (y); d = ROTRIGHT64(d ^ a, 16); \
+	c = c + d;       b = ROTRIGHT64(b ^ c, 63); \
+} while (0)
+
+// Mix the columns, then the diagonals, with the message words permuted by sigma[r]
+#define ROUND(r) do { \
+	G(v0, v4, v8,  v12, m[blake2b_sigma[r][0]],  m[blake2b_sigma[r][1]]); \
+	G(v1, v5, v9,  v13, m[blake2b_sigma[r][2]],  m[blake2b_sigma[r][3]]); \
+	G(v2, v6, v10, v14, m[blake2b_sigma[r][4]],  m[blake2b_sigma[r][5]]); \
+	G(v3, v7, v11, v15, m[blake2b_sigma[r][6]],  m[blake2b_sigma[r][7]]); \
+	G(v0, v5, v10, v15, m[blake2b_sigma[r][8]],  m[blake2b_sigma[r][9]]); \
+	G(v1, v6, v11, v12, m[blake2b_sigma[r][10]], m[blake2b_sigma[r][11]]); \
+	G(v2, v7, v8,  v13, m[blake2b_sigma[r][12]], m[blake2b_sigma[r][13]]); \
+	G(v3, v4, v9,  v14, m[blake2b_sigma[r][14]], m[blake2b_sigma[r][15]]); \
+} while (0)
+
+/**************************** VARIABLES *****************************/
+static const uint64_t blake2b_iv[8] = {
+	0x6a09e667f3bcc908ULL,0xbb67ae8584caa73bULL,0x3c6ef372fe94f82bULL,0xa54ff53a5f1d36f1ULL,
+	0x510e527fade682d1ULL,0x9b05688c2b3e6c1fULL,0x1f83d9abfb41bd6bULL,0x5be0cd19137e2179ULL
+};
+
+static const BYTE blake2b_sigma[12][16] = {
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,15},
+	{14,10, 4, 8, 9,15,13, 6, 1,12, 0, 2,11, 7, 5, 3},
+	{11, 8,12, 0, 5, 2,15,13,10,14, 3, 6, 7, 1, 9, 4},
+	{ 7, 9, 3, 1,13,12,11,14, 2, 6, 5,10, 4, 0,15, 8},
+	{ 9, 0, 5, 7, 2, 4,10,15,14, 1,11,12, 6, 8, 3,13},
+	{ 2,12, 6,10, 0,11, 8, 3, 4,13, 7, 5,15,14, 1, 9},
+	{12, 5, 1,15,14,13, 4,10, 0, 7, 6, 3, 9, 2, 8,11},
+	{13,11, 7,14,12, 1, 3, 9, 5, 0,15, 4, 8, 6, 2,10},
+	{ 6,15,14, 9,11, 3, 0, 8,12, 2,13, 7, 1, 4,10, 5},
+	{10, 2, 8, 4, 7, 6, 1, 5,15,11, 9,14, 3,12,13, 0},
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,15},
+	{14,10, 4, 8, 9,15,13, 6, 1,12, 0, 2,11, 7, 5, 3}
+};
+
+/*********************** FUNCTION DEFINITIONS ***********************/
+static void blake2b_compress(uint64_t state[8], const BYTE data[], unsigned long long length, int last)
+{
+	uint64_t m[16], v0, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15;
+	int i;
+
+	for (i = 0; i < 16; ++i) {
+		const BYTE *p = data + i * 8;
+		m[i] = (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24) |
+		       ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) | ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+	}
+
+	v0 = state[0]; v1 = state[1]; v2 = state[2]; v3 = state[3];
+	v4 = state[4]; v5 = state[5]; v6 = state[6]; v7 = state[7];
+	v8 = blake2b_iv[0]; v9 = blake2b_iv[1]; v10 = blake2b_iv[2]; v11 = blake2b_iv[3];
+	v12 = blake2b_iv[4] ^ length;     // The messages are far below 2^64 bytes
+	v13 = blake2b_iv[5];
+	v14 = last ? ~blake2b_iv[6] : blake2b_iv[6];
+	v15 = blake2b_iv[7];
+
+	ROUND(0);
+	ROUND(1);
+	ROUND(2);
+	ROUND(3);
+	ROUND(4);
+	ROUND(5);
+	ROUND(6);
+	ROUND(7);
+	ROUND(8);
+	ROUND(9);
+	ROUND(10);
+	ROUND(11);
+
+	state[0] ^= v0 ^ v8;
+	state[1] ^= v1 ^ v9;
+	state[2] ^= v2 ^ v10;
+	state[3] ^= v3 ^ v11;
+	state[4] ^= v4 ^ v12;
+	state[5] ^= v5 ^ v13;
+	state[6] ^= v6 ^ v14;
+	state[7] ^= v7 ^ v15;
+}
+
+void blake2b_256_init(BLAKE2B_CTX *ctx)
+{
+	int i;
+
+	for (i = 0; i < 8; ++i)
+		ctx->state[i] = blake2b_iv[i];
+	// Parameter block: digest length, no key, fanout and depth of 1
+	ctx->state[0] ^= 0x01010000 ^ HASH_SIZE;
+	ctx->datalen = 0;
+	ctx->length = 0;
+}
+
+void blake2b_update(BLAKE2B_CTX *ctx, const BYTE data[], size_t len)
+{
+	while (len > 0) {
+		// A full block is only compressed once more data follows, the last one is flagged
+		if (ctx->datalen == 128) {
+			ctx->length += 128;
+			blake2b_compress(ctx->state, ctx->data, ctx->length, 0);
+			ctx->datalen = 0;
+		}
+		size_t n = 128 - ctx->datalen < len ? 128 - ctx->datalen : len;
+		memcpy(ctx->data + ctx->datalen, data, n);
+		ctx->datalen += n;
+		data += n;
+		len -= n;
+	}
+}
+
+void blake2b_256_final(BLAKE2B_CTX *ctx, BYTE hash[])
+{
+	size_t i;
+
+	ctx->length += ctx->datalen;
+	memset(ctx->data + ctx->datalen, 0, 128 - ctx->datalen);
+	blake2b_compress(ctx->state, ctx->data, ctx->length, 1);
+
+	for (i = 0; i < HASH_SIZE; ++i)
+		hash[i] = (BYTE)(ctx->state[i / 8] >> (8 * (i % 8)));
+}
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include "bulk.h"
+#include "util.h"
+
+// A bulk check, shared by the threads of its pool
+typedef struct {
+    const char* const* paths;
+    int count;
+    int* order;                           // Indexes of the paths, largest chain first
+    hcb_bulk_result* results;
+    hcb_options options;                  // Options of every check, without cache nor warning
+    int threads;                          // Threads of the pool
+    atomic_int next;                      // Next chain of order to be claimed
+    pthread_mutex_t lock;                 // Serializes the calls of the callback
+    hcb_bulk_callback callback;
+    void* data;
+} bulk_t;
+
+// Size of a chain file, sorting the chains to check
+typedef struct {
+    int index;
+    off_t size;
+} chain_size_t;
+
+// Largest chain first, then in the order of the paths
+static int compare_size(const void* a, const void* b) {
+    const chain_size_t* first = a;
+    const chain_size_t* second = b;
+    if (first->size != second->size) {
+        return first->size > second->size ? -1 : 1;
+    }
+    return first->index - second->index;
+}
+
+// Thread of the pool: checks the next chain until there is none left
+static void* bulk_thread(void* arg) {
+
+    bulk_t* bulk = arg;
+    hcb_options options = bulk->options;
+    int claimed;
+
+    while ((claimed = atomic_fetch_add(&bulk->next, 1)) < bulk->count) {
+
+        // A chain is checked by a single thread while the others are busy, the last ones share
+        // the threads which have nothing left to claim
+        int left = bulk->count - claimed;
+        options.threads = left < bulk->threads ? bulk->threads / left : 1;
+
+        int index = bulk->order[claimed];
+        hcb_bulk_result* result = &bulk->results[index];
+        double start = util_now();
+        hcb_check(bulk->paths[index], &options, &result->info, &result->error);
+        result->seconds = util_now() - start;
+
+        if (bulk->callback != NULL) {
+            pthread_mutex_lock(&bulk->lock);
+            bulk->callback(index, result, bulk->data);
+            pthread_mutex_unlock(&bulk->lock);
+        }
+
+    }
+    return NULL;
+
+}
+
+hcb_status hcb_bulk_check(const char* const paths[], int count, const hcb_options* options, hcb_bulk_result results[], hcb_bulk_callback callback, void* data, hcb_error* error) {
+
+    pthread_t threads[SEARCH_MAX_THREADS];
+    bulk_t bulk;
+    struct stat st;
+
+    memset(&bulk, 0, sizeof(bulk));
+    if (options != NULL) {
+        bulk.options = *options;
+    } else {
+        hcb_options_init(&bulk.options);
+    }
+    bulk.options.cache = false;
+    bulk.options.warning = NULL;
+    bulk.paths = paths;
+    bulk.count = count;
+    bulk.results = results;
+    bulk.callback = callback;
+    bulk.data = data;
+    atomic_init(&bulk.next, 0);
+
+    // The largest chains are checked first, so a long one does not end the check alone
+    chain_size_t* sizes = malloc((count > 0 ? count : 1) * sizeof(chain_size_t));
+    bulk.order = malloc((count > 0 ? count : 1) * sizeof(int));
+    if (sizes == NULL || bulk.order == NULL) {
+        free(sizes);
+        free(bulk.order);
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+    }
+    for (int i = 0; i < count; i++) {
+        sizes[i].index = i;
+        sizes[i].size = stat(paths[i], &st) == 0 ? st.st_size : 0;
+    }
+    qsort(sizes, count, sizeof(chain_size_t), compare_size);
+    for (int i = 0; i < count; i++) {
+        bulk.order[i] = sizes[i].index;
+    }
+    free(sizes);
+
+    bulk.threads = bulk.options.threads;
+    if (bulk.threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        bulk.threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (bulk.threads > SEARCH_MAX_THREADS) {
+        bulk.threads = SEARCH_MAX_THREADS;
+    }
+    pthread_mutex_init(&bulk.lock, NULL);
+
+    // The calling thread is one of the threads of the pool
+    int started = 0;
+    for (; started < bulk.threads - 1 && started < count - 1; started++) {
+        if (pthread_create(&threads[started], NULL, bulk_thread, &bulk) != 0) {
+            break;
+        }
+    }
+    bulk_thread(&bulk);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&bulk.lock);
+    free(bulk.order);
+    return util_fail(error, HCB_OK, "");
+
+}
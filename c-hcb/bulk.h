@@ -0,0 +1,34 @@
+#ifndef BULK_H
+#define BULK_H
+
+#include "hcb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// What the check of a chain of a bulk check found
+typedef struct {
+    hcb_chain_info info;          // Valid blocks and hash of the last one, even if the chain is invalid
+    hcb_error error;              // First error of the chain, HCB_OK if it is valid
+    double seconds;               // Time spent checking it
+} hcb_bulk_result;
+
+// Called after each chain checked, with the index of its path, from the thread that checked it
+// The calls are serialized
+typedef void (*hcb_bulk_callback)(int index, const hcb_bulk_result* result, void* data);
+
+// Check the count chains at paths (text or binary) with one pool of options->threads threads
+// (0 for one per CPU), results[i] receives the result of paths[i], callback may be NULL
+// Each thread checks whole chains, the largest first, so many small chains cost no thread
+// creation and the last chains left are split between the idle threads
+// The cache of options is not used, these chains are usually received from others, and its
+// warning callback is ignored
+// Returns an error only if the chains could not be checked, not if some of them are invalid
+hcb_status hcb_bulk_check(const char* const paths[], int count, const hcb_options* options, hcb_bulk_result results[], hcb_bulk_callback callback, void* data, hcb_error* error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   // BULK_H
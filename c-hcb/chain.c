@@ -0,0 +1,788 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <memory.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "hcb.h"
+#include "binary.h"
+#include "verify.h"
+#include "util.h"
+
+// Number of blocks read before being verified, so the memory used does not grow with the chain
+#define CHECK_WINDOW 4096
+
+// Blocks read from a chain, waiting to be verified
+typedef struct {
+    verify_block_t blocks[CHECK_WINDOW];
+    const char* hash_lines[CHECK_WINDOW]; // Hash of each block as written in the chain
+    int lines[CHECK_WINDOW];              // Line number of the hash of each block in the chain (comments are ignored)
+    int real_lines[CHECK_WINDOW];         // Line number of the hash of each block in the file
+    size_t count;                         // Number of blocks waiting
+    size_t first;                         // Number of the first block waiting
+    scratchpad_t* scratchpad;             // Scratchpad of a memory-hard chain, allocated by the first verification
+} read_blocks_t;
+
+// Prefix of a chain known to be valid, recorded in the verification cache FILE.verified
+typedef struct {
+    size_t offset;                        // Bytes up to the end of the hash line of the last block
+    int blocks;                           // Blocks in the prefix, 0 if nothing is known
+    int real_lines;                       // Lines of the file in the prefix
+} verified_t;
+
+struct hcb_builder {
+    char* path;
+    FILE* out_fp;
+    char* prev_hash;                      // Message of the next block
+    int level;                            // Level of the next block
+    nonce_t resume;                       // Nonce the search of the next block starts from
+    off_t nonce_lines;                    // Offset of the #nonce lines written since the last block, -1 if none
+    pthread_mutex_t lock;                 // Serializes the writes between the search and the checkpoints
+    search_t* search;
+    const HASH_ALGORITHM* hash;           // Hash algorithm of the chain
+    scratchpad_t* scratchpad;             // Verifies the nonces found elsewhere in a memory-hard chain
+    energy_t* energy;                     // Measures the energy of the levels, NULL if unknown
+};
+
+void byteToHex(const BYTE array[], int len, char* result) {
+    char table[16] = "0123456789abcdef";
+    int i;
+    for (i = 0; i < len; i++) {
+        result[i*2]   = table[(array[i]>>4)&0xF];
+        result[i*2+1] = table[ array[i]    &0xF];
+    }
+    result[2*len] = '\0';
+}
+
+// Add right padding to a string, dest must hold length+1 characters
+static void padding_right(const char* source, int length, char chr, char* dest) {
+    int i = strlen(source);
+    strcpy(dest, source);
+    for (; i < length; i++) {
+        dest[i] = chr;
+    }
+    dest[i] = '\0';
+}
+
+// Write the separator line preceding the hash of a block
+static void separator_line(int level, char* dest) {
+    char number[16];
+    sprintf(number, "%d ", level);
+    padding_right(number, nonce_length, '-', dest);
+}
+
+void hcb_options_init(hcb_options* options) {
+    memset(options, 0, sizeof(hcb_options));
+}
+
+void hcb_header_line(const HASH_ALGORITHM* algorithm, size_t memory, char line[]) {
+    char version[64];
+    if (algorithm == NULL) {
+        algorithm = &hash_sha256;
+    }
+    if (memory != 0) {
+        snprintf(version, sizeof(version), "HCB 1.2 %s %zuKiB ", algorithm->name, memory);
+    } else if (algorithm == &hash_sha256) {
+        strcpy(version, "HCB 1.0 ");
+    } else {
+        snprintf(version, sizeof(version), "HCB 1.1 %s ", algorithm->name);
+    }
+    padding_right(version, nonce_length, '-', line);
+}
+
+// Hash algorithm named by the first line of a chain, NULL if it is not a known header, and the
+// scratchpad size of a memory-hard chain in memory (0 for the others)
+static const HASH_ALGORITHM* header_algorithm(const char* line, int len, size_t* memory) {
+    char expected[SHA256_BLOCK_SIZE * 2 + 1];
+    *memory = 0;
+    if (len != nonce_length) {
+        return NULL;
+    }
+
+    // A memory-hard chain names its scratchpad size, the header is then written back to make
+    // sure it has the only accepted form
+    if (memcmp(line, "HCB 1.2 ", 8) == 0) {
+        char name[32];
+        unsigned long long size;
+        memcpy(expected, line, len);
+        expected[len] = '\0';
+        const HASH_ALGORITHM* algorithm = NULL;
+        if (sscanf(expected + 8, "%31[a-z0-9-] %lluKiB", name, &size) == 2 && size >= SCRATCHPAD_MIN_SIZE && size <= SCRATCHPAD_MAX_SIZE) {
+            algorithm = hash_algorithm_find(name);
+        }
+        if (algorithm == NULL) {
+            return NULL;
+        }
+        hcb_header_line(algorithm, size, expected);
+        *memory = size;
+        return memcmp(line, expected, len) == 0 ? algorithm : NULL;
+    }
+
+    for (int i = 0; hash_algorithms[i] != NULL; i++) {
+        hcb_header_line(hash_algorithms[i], 0, expected);
+        if (memcmp(line, expected, len) == 0) {
+            return hash_algorithms[i];
+        }
+    }
+    return NULL;
+}
+
+// Verify the blocks read so far and report the first invalid one like a sequential check would
+// info then only counts the blocks preceding it
+static hcb_status check_blocks(const char* path, read_blocks_t* read, const hcb_options* options, hcb_chain_info* info, hcb_error* error) {
+
+    const SHA256_KERNEL* kernel = options->kernel != NULL ? options->kernel : sha256_kernel_best();
+    if (info->memory != 0 && read->scratchpad == NULL && (read->scratchpad = scratchpad_create(info->memory)) == NULL) {
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory for a scratchpad of %zu KiB", info->memory);
+    }
+    size_t invalid = verify_blocks(read->blocks, read->count, read->first, options->threads, kernel, info->hash, read->scratchpad);
+    if (invalid == read->count) {
+        read->first += read->count;
+        read->count = 0;
+        return HCB_OK;
+    }
+
+    // The message of the invalid block is the hash of the last valid one
+    info->blocks = (int)(read->first + invalid);
+    memset(info->last_hash, 0, SHA256_BLOCK_SIZE);
+    if (info->blocks > 0) {
+        verify_read_hex(read->blocks[invalid].message, info->last_hash);
+    }
+
+    // Hash the invalid block again to describe the error
+    BYTE hash[SHA256_BLOCK_SIZE];
+    char new_hash[SHA256_BLOCK_SIZE * 2 + 1];
+    verify_hash(&read->blocks[invalid], info->hash, read->scratchpad, hash);
+    byteToHex(hash, SHA256_BLOCK_SIZE, new_hash);
+    const char* line = read->hash_lines[invalid];
+    if (memcmp(line, new_hash, sha256_hex_length) != 0) {
+        return util_fail(error, HCB_ERROR_HASH, "Error while checking \"%s\": Hash line #%d expected \"%s\" but got \"%.*s\"", path, read->lines[invalid], new_hash, sha256_hex_length, line);
+    }
+    return util_fail(error, HCB_ERROR_DIFFICULTY, "Error while checking \"%s\": Hash line #%d (\"%.*s\") expected difficulty \"%d\" but got \"%d\"", path, read->real_lines[invalid], sha256_hex_length, line, (int)(read->first + invalid), numberOfZero(hash, SHA256_BLOCK_SIZE));
+
+}
+
+// Checksum of the verified prefix of a chain, it notices a change of the file, not a forgery
+static uint64_t checksum(const char* data, size_t size) {
+    uint64_t sum = size * 0x9E3779B97F4A7C15ULL;
+    uint64_t word;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        memcpy(&word, data + i, 8);
+        sum = (sum ^ word) * 0xFF51AFD7ED558CCDULL;
+        sum ^= sum >> 32;
+    }
+    word = 0;
+    memcpy(&word, data + i, size - i);
+    sum = (sum ^ word) * 0xFF51AFD7ED558CCDULL;
+    return sum ^ (sum >> 29);
+}
+
+// Path of the verification cache of a chain, to be freed
+static char* cache_path(const char* path) {
+    char* cache = malloc(strlen(path) + 10);
+    if (cache != NULL) {
+        sprintf(cache, "%s.verified", path);
+    }
+    return cache;
+}
+
+// Read the verified prefix of a chain recorded in its cache, prefix->blocks is 0 if there is
+// none or if the chain was changed since
+static void cache_read(const char* path, const char* data, size_t size, verified_t* prefix) {
+
+    long long unsigned int offset = 0, sum = 0;
+    char* cache = cache_path(path);
+    FILE* fp = cache != NULL ? fopen(cache, "r") : NULL;
+    memset(prefix, 0, sizeof(verified_t));
+    free(cache);
+    if (fp == NULL) {
+        return;
+    }
+    if (fscanf(fp, "HCB-VERIFIED 1 %llu %d %d %llx", &offset, &prefix->blocks, &prefix->real_lines, &sum) != 4 ||
+        prefix->blocks <= 0 || offset <= sha256_hex_length + 1 || offset > size || data[offset - 1] != '\n' || checksum(data, offset) != sum) {
+        memset(prefix, 0, sizeof(verified_t));
+    } else {
+        prefix->offset = offset;
+    }
+    fclose(fp);
+
+}
+
+// Record the verified prefix of a chain in its cache, written aside then renamed
+// The cache is only an optimization, so it is not an error if it cannot be written
+static void cache_write(const char* path, const char* data, const verified_t* prefix) {
+
+    char* cache = cache_path(path);
+    char* temp_path = cache != NULL ? malloc(strlen(cache) + 5) : NULL;
+    if (temp_path == NULL) {
+        free(cache);
+        return;
+    }
+    sprintf(temp_path, "%s.tmp", cache);
+    FILE* fp = fopen(temp_path, "w");
+    if (fp != NULL) {
+        fprintf(fp, "HCB-VERIFIED 1 %llu %d %d %llx\n", (long long unsigned int)prefix->offset, prefix->blocks, prefix->real_lines,
+            (long long unsigned int)checksum(data, prefix->offset));
+        if (fclose(fp) != 0 || rename(temp_path, cache) != 0) {
+            unlink(temp_path);
+        }
+    }
+    free(temp_path);
+    free(cache);
+
+}
+
+// Check the lines of a chain in place, the hashes of the blocks are verified in parallel every
+// CHECK_WINDOW blocks
+// The lines of prefix, if it holds blocks, are known to be valid and are skipped, prefix then
+// receives the valid blocks ending with a complete line
+static hcb_status check_data(const char* path, const char* data, size_t size, const hcb_options* options, read_blocks_t* read, hcb_chain_info* info, verified_t* prefix, hcb_error* error) {
+
+    // Prepare reading variables
+    int current_line = 1; // The current line number in the chain (comments are ignored)
+    int real_line = 0; // The current line number in the file (every line is counted)
+    hcb_status status;
+
+    // Variables used in the loop
+    char expected_first_line[SHA256_BLOCK_SIZE * 2 + 1];
+    char expected_line[SHA256_BLOCK_SIZE * 2 + 1];
+    hcb_header_line(&hash_sha256, 0, expected_first_line);
+
+    // Read file line by line and check the content
+    const char* last_hash = NULL;
+    int last_hash_length = 0;
+    const char* last_nonce = NULL;
+    const char* nonce_prefix = "#nonce:";
+    const int nonce_prefix_length = strlen(nonce_prefix);
+    size_t next = 0;
+
+    // Resume after the hash line of the last block of the verified prefix, which ends the prefix
+    if (prefix->blocks > 0) {
+        last_hash_length = sha256_hex_length;
+        last_hash = data + prefix->offset - 1 - last_hash_length;
+        if (data[prefix->offset - 2] == '\r') {
+            last_hash--;
+        }
+        verify_read_hex(last_hash, info->last_hash);
+        info->blocks = prefix->blocks;
+        read->first = prefix->blocks;
+        current_line = 3 + 3 * prefix->blocks;
+        real_line = prefix->real_lines;
+        next = prefix->offset;
+
+        // The header, which the prefix holds, names the algorithm of the new blocks
+        for (const char* line = data; line < data + prefix->offset; line = (const char*)memchr(line, '\n', size - (line - data)) + 1) {
+            if (line[0] != '#') {
+                info->hash = header_algorithm(line, strcspn(line, "\r\n"), &info->memory);
+                break;
+            }
+        }
+    }
+
+    while (next < size) {
+
+        // Find the end of the line
+        const char* line = data + next;
+        const char* end = memchr(line, '\n', size - next);
+        int len = (int)(end != NULL ? (size_t)(end - line) : size - next);
+        off_t offset = next;
+        next += len + 1;
+        real_line++;
+
+        // Remove final carriage return
+        if (len > 0 && line[len-1] == '\r') {
+            len--;
+        }
+
+        // Check if line is a comment
+        if (len >= 1 && line[0] == '#') {
+            // Search for a nonce to resume to
+            if (len >= nonce_prefix_length && memcmp(nonce_prefix, line, nonce_prefix_length) == 0) {
+                char string_nonce[SHA256_BLOCK_SIZE * 2 + 1];
+                size_t value_length = (size_t)(len - nonce_prefix_length);
+                if (value_length > sizeof(string_nonce) - 1) {
+                    value_length = sizeof(string_nonce) - 1;
+                }
+                memcpy(string_nonce, line + nonce_prefix_length, value_length);
+                string_nonce[value_length] = '\0';
+                int digits = strspn(string_nonce, "0123456789");
+                if (!nonce_parse(string_nonce, digits, &info->resume)) {
+                    if (options->warning != NULL) {
+                        char message[256];
+                        snprintf(message, sizeof(message), "Warning: incorrect decimal nonce value \"%s\" in file \"%s\" on line #%d", string_nonce, path, real_line);
+                        options->warning(message, options->warning_data);
+                    }
+                    info->resume = 0;
+                }
+                if (info->nonce_lines < 0) {
+                    info->nonce_lines = offset;
+                }
+            } else {
+                info->nonce_lines = -1;
+            }
+            continue;
+        }
+
+        // A nonce to resume to only holds for the level following the last block
+        info->nonce_lines = -1;
+        info->resume = 0;
+
+        // Check if first line is correct, it names the hash algorithm of the chain
+        if (current_line == 1 && (info->hash = header_algorithm(line, len, &info->memory)) == NULL) {
+
+            return util_fail(error, HCB_ERROR_FIRST_LINE, "Error while checking \"%s\": First line expected \"%s\" but got \"%.*s\" on line #%d", path, expected_first_line, len, line, real_line);
+
+        } else if (current_line == 2) {
+
+            // Get the first message
+            last_hash = line;
+            last_hash_length = len;
+
+        } else if (current_line % 3 == 0) {
+
+            // Get a nonce
+
+            // Check the nonce lenght
+            if (len != nonce_length) {
+                if ((status = check_blocks(path, read, options, info, error)) != HCB_OK) {
+                    return status;
+                }
+                return util_fail(error, HCB_ERROR_NONCE_LENGTH, "Error while checking \"%s\": Nonce line #%d must be %d characters long", path, real_line, nonce_length);
+            }
+
+            // Check if the nonce is only numeric
+            for (int i = 0; i < len; i++) {
+                if (line[i] < '0' || line[i] > '9') {
+                    if ((status = check_blocks(path, read, options, info, error)) != HCB_OK) {
+                        return status;
+                    }
+                    return util_fail(error, HCB_ERROR_NONCE, "Error while checking \"%s\": Nonce line #%d must be only numeric but got \"%.*s\"", path, real_line, len, line);
+                }
+            }
+
+            // Save the nonce
+            last_nonce = line;
+
+        } else if (current_line != 1 && current_line % 3 == 1) {
+
+            // Block separator, check if integer is correct
+            separator_line((current_line - 1) / 3 - 1, expected_line);
+
+            if (len != nonce_length || memcmp(line, expected_line, len) != 0) {
+                if ((status = check_blocks(path, read, options, info, error)) != HCB_OK) {
+                    return status;
+                }
+                return util_fail(error, HCB_ERROR_SEPARATOR, "Error while checking \"%s\": Separator line #%d expected \"%s\" but got \"%.*s\"", path, real_line, expected_line, len, line);
+            }
+
+        } else if (current_line % 3 == 2) {
+
+            // Line representing a hash
+
+            // Check the hash lenght
+            if (len != sha256_hex_length) {
+                if ((status = check_blocks(path, read, options, info, error)) != HCB_OK) {
+                    return status;
+                }
+                return util_fail(error, HCB_ERROR_HASH_LENGTH, "Error while checking \"%s\": Hash line #%d must be %d characters long", path, real_line, sha256_hex_length);
+            }
+
+            // Keep the block for the verification of its hash
+            verify_block_t* block = &read->blocks[read->count];
+            block->message = last_hash;
+            block->message_length = last_hash_length;
+            block->nonce = last_nonce;
+            block->hash_valid = verify_read_hex(line, block->hash);
+            memcpy(info->last_hash, block->hash, SHA256_BLOCK_SIZE);
+            read->hash_lines[read->count] = line;
+            read->lines[read->count] = current_line;
+            read->real_lines[read->count] = real_line;
+            read->count++;
+            info->blocks++;
+            if (end != NULL) {
+                prefix->offset = next;
+                prefix->blocks = info->blocks;
+                prefix->real_lines = real_line;
+            }
+            if (read->count == CHECK_WINDOW && (status = check_blocks(path, read, options, info, error)) != HCB_OK) {
+                return status;
+            }
+
+            // The hash is the message of the next block
+            last_hash = line;
+            last_hash_length = len;
+
+        }
+
+        current_line++;
+
+    }
+
+    // Verify the remaining blocks
+    if ((status = check_blocks(path, read, options, info, error)) != HCB_OK) {
+        return status;
+    }
+
+    // Last line must be a hash or a nonce
+    if (current_line % 3 != 0) {
+        return util_fail(error, HCB_ERROR_END, "Error while checking \"%s\": File must end with a hash", path);
+    }
+
+    return HCB_OK;
+
+}
+
+hcb_status hcb_check(const char* path, const hcb_options* options, hcb_chain_info* info, hcb_error* error) {
+
+    hcb_options default_options;
+    hcb_chain_info default_info;
+    if (options == NULL) {
+        hcb_options_init(&default_options);
+        options = &default_options;
+    }
+    if (info == NULL) {
+        info = &default_info;
+    }
+    memset(info, 0, sizeof(hcb_chain_info));
+    info->nonce_lines = -1;
+    util_fail(error, HCB_OK, "");
+
+    // Open and map the file, its lines are read in place
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return util_fail(error, HCB_ERROR_OPEN, "Error: Unable to open file \"%s\"", path);
+    }
+    size_t size = st.st_size;
+
+    // Binary chains have their own reader
+    char magic[4];
+    if (pread(fd, magic, sizeof(magic), 0) == sizeof(magic) && memcmp(magic, HCB_BINARY_MAGIC, sizeof(magic)) == 0) {
+        close(fd);
+        return hcb_binary_check(path, options, info, error);
+    }
+
+    const char* data = "";
+    if (size > 0) {
+        data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return util_fail(error, HCB_ERROR_OPEN, "Error: Unable to open file \"%s\"", path);
+        }
+        madvise((void*)data, size, MADV_SEQUENTIAL);
+    }
+
+    // Only the blocks following the prefix verified by a previous check are verified
+    verified_t prefix;
+    memset(&prefix, 0, sizeof(prefix));
+    if (options->cache && size > 0) {
+        cache_read(path, data, size, &prefix);
+    }
+    int cached_blocks = prefix.blocks;
+
+    hcb_status status = HCB_ERROR_MEMORY;
+    read_blocks_t* read = malloc(sizeof(read_blocks_t));
+    if (read == NULL) {
+        util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+    } else {
+        read->count = 0;
+        read->first = 0;
+        read->scratchpad = NULL;
+        status = check_data(path, data, size, options, read, info, &prefix, error);
+        scratchpad_destroy(read->scratchpad);
+        free(read);
+    }
+    if (status == HCB_OK && options->cache && prefix.blocks > cached_blocks) {
+        cache_write(path, data, &prefix);
+    }
+
+    // Free memory
+    if (size > 0) {
+        munmap((void*)data, size);
+    }
+    close(fd);
+    return status;
+
+}
+
+// Open a chain file to append blocks to it, starting with the given message and level
+// When continuing a chain, the lines from nonce_lines (the #nonce lines of the previous run, -1
+// if none) are removed once the first new block is found
+static hcb_status builder_open(hcb_builder** result, const char* path, const char* message, bool continue_mode, int level, nonce_t resume, off_t nonce_lines, const HASH_ALGORITHM* hash, size_t memory, const hcb_options* options, hcb_error* error) {
+
+    *result = NULL;
+
+    // Check the start message
+    for (size_t i = 0; i < strlen(message); i++) {
+        if (message[i] == '\r' || message[i] == '\n') {
+            return util_fail(error, HCB_ERROR_MESSAGE, "Error: Start message must be over one single line");
+        }
+    }
+
+    hcb_builder* builder = calloc(1, sizeof(hcb_builder));
+    if (builder == NULL || (builder->search = search_create()) == NULL) {
+        free(builder);
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+    }
+    builder->path = strdup(path);
+    builder->prev_hash = malloc(((strlen(message) > sha256_hex_length ? strlen(message) : sha256_hex_length) + 1) * sizeof(char));
+    strcpy(builder->prev_hash, message);
+    builder->level = level;
+    builder->resume = resume;
+    builder->nonce_lines = nonce_lines;
+    builder->hash = hash;
+    pthread_mutex_init(&builder->lock, NULL);
+    search_set_threads(builder->search, options != NULL ? options->threads : 0);
+    if (options != NULL && options->kernel != NULL) {
+        search_set_kernel(builder->search, options->kernel);
+    }
+    search_set_pinned(builder->search, options != NULL && options->pinned);
+    search_set_throttle(builder->search, options != NULL ? options->throttle : NULL);
+    builder->energy = options != NULL ? options->energy : NULL;
+    search_set_hash(builder->search, hash);
+    search_set_position(builder->search, resume);
+    if (!search_set_memory(builder->search, memory)) {
+        hcb_builder_close(builder);
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory for a scratchpad of %zu KiB", memory);
+    }
+
+    // Open file, a continued chain is never rewritten
+    // Everything is appended so the writes follow the truncations of the #nonce lines
+    int fd = open(path, continue_mode ? O_RDWR | O_APPEND : O_RDWR | O_CREAT | O_TRUNC | O_APPEND, 0666);
+    builder->out_fp = fd < 0 ? NULL : fdopen(fd, "a");
+    if (builder->out_fp == NULL) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        hcb_builder_close(builder);
+        return util_fail(error, HCB_ERROR_CREATE, "Error: Unable to open file \"%s\"", path);
+    }
+
+    // The new lines must not be appended to an unfinished last line
+    if (continue_mode) {
+        char last = '\n';
+        off_t size = lseek(fd, 0, SEEK_END);
+        if (size > 0 && pread(fd, &last, 1, size - 1) == 1 && last != '\n') {
+            fputc('\n', builder->out_fp);
+        }
+    }
+
+    // Print the start of the chain
+    if (!continue_mode) {
+        char header[SHA256_BLOCK_SIZE * 2 + 1];
+        hcb_header_line(hash, memory, header);
+        fprintf(builder->out_fp, "# File generated by C-HCB\n%s\n%s\n", header, message);
+    }
+    if (fflush(builder->out_fp) != 0) {
+        hcb_builder_close(builder);
+        return util_fail(error, HCB_ERROR_WRITE, "Error: Unable to write file \"%s\"", path);
+    }
+
+    *result = builder;
+    return util_fail(error, HCB_OK, "");
+
+}
+
+hcb_status hcb_builder_create(hcb_builder** builder, const char* path, const char* message, const hcb_options* options, hcb_error* error) {
+    const HASH_ALGORITHM* hash = options != NULL && options->hash != NULL ? options->hash : &hash_sha256;
+    return builder_open(builder, path, message, false, 0, 0, -1, hash, options != NULL ? options->memory : 0, options, error);
+}
+
+hcb_status hcb_builder_continue(hcb_builder** builder, const char* path, const hcb_options* options, hcb_chain_info* info, hcb_error* error) {
+
+    hcb_chain_info chain;
+    char prev_hash[SHA256_BLOCK_SIZE * 2 + 1];
+
+    // Read the input chain and check it (we won't continue an invalid one)
+    *builder = NULL;
+    hcb_status status = hcb_check(path, options, &chain, error);
+    if (info != NULL) {
+        *info = chain;
+    }
+    if (status != HCB_OK) {
+        return status;
+    }
+
+    // Only text chains are appended to
+    if (hcb_is_binary(path)) {
+        return util_fail(error, HCB_ERROR_FIRST_LINE, "Error: \"%s\" is a binary chain, convert it with --to-text to continue it", path);
+    }
+
+    // Continue the chain
+    byteToHex(chain.last_hash, SHA256_BLOCK_SIZE, prev_hash);
+    return builder_open(builder, path, prev_hash, true, numberOfZero(chain.last_hash, SHA256_BLOCK_SIZE) + 1, chain.resume, chain.nonce_lines, chain.hash, chain.memory, options, error);
+
+}
+
+// Append the block of the current level to the chain, once its nonce is known to be the lowest
+// valid one, cpu_seconds and joules are negative if the CPU time and the energy of the search are
+// unknown
+static hcb_status builder_write(hcb_builder* builder, nonce_t nonce, const BYTE hash[], long long unsigned int attempts, double seconds, double cpu_seconds, double joules, hcb_block* block, hcb_error* error) {
+
+    char separator[SHA256_BLOCK_SIZE * 2 + 1];
+    char string_nonce[SHA256_BLOCK_SIZE * 2 + 1];
+
+    // Saves the current hash
+    byteToHex(hash, SHA256_BLOCK_SIZE, builder->prev_hash);
+
+    pthread_mutex_lock(&builder->lock);
+
+    // The progress saved for this level is now useless
+    if (builder->nonce_lines >= 0) {
+        if (fflush(builder->out_fp) != 0 || ftruncate(fileno(builder->out_fp), builder->nonce_lines) != 0) {
+            pthread_mutex_unlock(&builder->lock);
+            return util_fail(error, HCB_ERROR_WRITE, "Error: Unable to write file \"%s\"", builder->path);
+        }
+        builder->nonce_lines = -1;
+    }
+
+    // Print the found nonce, the block separator, the hash and the history of the level
+    separator_line(builder->level, separator);
+    nonce_format(nonce, nonce_length, string_nonce);
+    fprintf(builder->out_fp, "%s\n%s\n%s\n", string_nonce, separator, builder->prev_hash);
+    fprintf(builder->out_fp, "#stats level:%d attempts:%llu seconds:%.3f hashrate:%.0f", builder->level, attempts, seconds, seconds > 0 ? attempts / seconds : 0);
+    if (cpu_seconds >= 0) {
+        fprintf(builder->out_fp, " cpu:%.3f cpuhashrate:%.0f", cpu_seconds, cpu_seconds > 0 ? attempts / cpu_seconds : 0);
+    }
+    fputc('\n', builder->out_fp);
+    if (joules >= 0) {
+        fprintf(builder->out_fp, "#energy level:%d joules:%.3f watts:%.1f hashesperjoule:%.0f\n", builder->level, joules, seconds > 0 ? joules / seconds : 0, joules > 0 ? attempts / joules : 0);
+    }
+    if (fflush(builder->out_fp) != 0 || fsync(fileno(builder->out_fp)) != 0) {
+        pthread_mutex_unlock(&builder->lock);
+        return util_fail(error, HCB_ERROR_WRITE, "Error: Unable to write file \"%s\"", builder->path);
+    }
+
+    // Reset the resume point before a checkpoint can save the position of the next level
+    builder->resume = 0;
+    search_set_position(builder->search, builder->resume);
+    pthread_mutex_unlock(&builder->lock);
+
+    if (block != NULL) {
+        block->level = builder->level;
+        block->nonce = nonce;
+        memcpy(block->hash, hash, SHA256_BLOCK_SIZE);
+        block->attempts = attempts;
+        block->seconds = seconds;
+        block->cpu_seconds = cpu_seconds;
+        block->joules = joules;
+    }
+
+    // Increment difficulty
+    builder->level++;
+    return util_fail(error, HCB_OK, "");
+
+}
+
+hcb_status hcb_builder_next(hcb_builder* builder, hcb_block* block, hcb_error* error) {
+
+    BYTE hash[SHA256_BLOCK_SIZE];
+    nonce_t nonce;
+
+    // Search the nonce of the current level
+    double start = util_now();
+    double cpu = search_cpu_seconds(builder->search);
+    double joules = builder->energy != NULL ? energy_read(builder->energy) : 0;
+    search_set_position(builder->search, builder->resume);
+    if (search_run(builder->search, builder->prev_hash, builder->level, builder->resume, NONCE_MAX, &nonce, hash) != SEARCH_FOUND) {
+        return util_fail(error, HCB_CANCELLED, "Search of block #%d cancelled", builder->level);
+    }
+    joules = builder->energy != NULL ? energy_read(builder->energy) - joules : -1;
+    return builder_write(builder, nonce, hash, (long long unsigned int)(nonce + 1 - builder->resume), util_now() - start, search_cpu_seconds(builder->search) - cpu, joules, block, error);
+
+}
+
+hcb_status hcb_builder_append(hcb_builder* builder, nonce_t nonce, long long unsigned int attempts, double seconds, hcb_block* block, hcb_error* error) {
+
+    BYTE hash[SHA256_BLOCK_SIZE];
+    char string_nonce[SHA256_BLOCK_SIZE * 2 + 1];
+    verify_block_t candidate;
+
+    // The nonce was found elsewhere, check it before writing it
+    nonce_format(nonce, nonce_length, string_nonce);
+    candidate.message = builder->prev_hash;
+    candidate.message_length = strlen(builder->prev_hash);
+    candidate.nonce = string_nonce;
+    size_t memory = search_get_memory(builder->search);
+    if (memory != 0 && builder->scratchpad == NULL && (builder->scratchpad = scratchpad_create(memory)) == NULL) {
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory for a scratchpad of %zu KiB", memory);
+    }
+    verify_hash(&candidate, builder->hash, builder->scratchpad, hash);
+    if (numberOfZero(hash, SHA256_BLOCK_SIZE) != builder->level) {
+        return util_fail(error, HCB_ERROR_DIFFICULTY, "Error: Nonce \"%s\" is not valid for block #%d", string_nonce, builder->level);
+    }
+    return builder_write(builder, nonce, hash, attempts, seconds, -1, -1, block, error);
+
+}
+
+const char* hcb_builder_message(const hcb_builder* builder) {
+    return builder->prev_hash;
+}
+
+hcb_status hcb_builder_checkpoint(hcb_builder* builder, hcb_error* error) {
+
+    hcb_status status = HCB_OK;
+    char position[NONCE_DIGITS + 1];
+
+    pthread_mutex_lock(&builder->lock);
+    fflush(builder->out_fp);
+    if (builder->nonce_lines < 0) {
+        builder->nonce_lines = lseek(fileno(builder->out_fp), 0, SEEK_END);
+    }
+    nonce_format(search_position(builder->search), 0, position);
+    fprintf(builder->out_fp, "#nonce:%s\n", position);
+    if (fflush(builder->out_fp) != 0 || fdatasync(fileno(builder->out_fp)) != 0) {
+        status = util_fail(error, HCB_ERROR_WRITE, "Error: Unable to write file \"%s\"", builder->path);
+    }
+    pthread_mutex_unlock(&builder->lock);
+    return status == HCB_OK ? util_fail(error, HCB_OK, "") : status;
+
+}
+
+void hcb_builder_cancel(hcb_builder* builder) {
+    search_cancel(builder->search);
+}
+
+int hcb_builder_level(const hcb_builder* builder) {
+    return builder->level;
+}
+
+nonce_t hcb_builder_position(const hcb_builder* builder) {
+    return search_position(builder->search);
+}
+
+search_t* hcb_builder_search(hcb_builder* builder) {
+    return builder->search;
+}
+
+const HASH_ALGORITHM* hcb_builder_hash(const hcb_builder* builder) {
+    return builder->hash;
+}
+
+size_t hcb_builder_memory(hcb_builder* builder) {
+    return search_get_memory(builder->search);
+}
+
+void hcb_builder_close(hcb_builder* builder) {
+    if (builder == NULL) {
+        return;
+    }
+    if (builder->out_fp != NULL) {
+        fclose(builder->out_fp);
+    }
+    pthread_mutex_destroy(&builder->lock);
+    search_destroy(builder->search);
+    scratchpad_destroy(builder->scratchpad);
+    free(builder->prev_hash);
+    free(builder->path);
+    free(builder);
+}
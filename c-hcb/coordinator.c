@@ -0,0 +1,839 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "coordinator.h"
+#include "verify.h"
+#include "util.h"
+
+// Longest message sent by a worker
+#define WORKER_LINE 256
+
+// Seconds between two progress reports of a worker, also the longest wait of the coordinator
+#define PROGRESS_INTERVAL 1
+
+// Messages, one per line:
+//   coordinator -> worker: "LEASE level start end algorithm memory message" to search the nonces
+//                          [start, end) of the level hashed with algorithm, with scratchpads of
+//                          memory KiB (0 if the chain is not memory-hard), "CANCEL" to drop the lease
+//   worker -> coordinator: "PROGRESS level start position" every PROGRESS_INTERVAL seconds,
+//                          "FOUND level start nonce", "DONE level start end" if the lease holds no
+//                          valid nonce, "STOPPED level start position" when the worker is cancelled
+// A lease is named by its level and start, the reports about a lease that was dropped are ignored
+
+// Nonces [start, end) of the current level
+typedef struct {
+    nonce_t start;
+    nonce_t end;
+} range_t;
+
+// A worker connected to the coordinator
+typedef struct {
+    int fd;
+    char line[WORKER_LINE];               // Start of a message not fully received
+    size_t line_length;
+    bool leased;
+    range_t lease;
+    nonce_t position;                     // Lowest nonce of the lease not reported as tested
+    double last_seen;
+} connection_t;
+
+struct hcb_coordinator {
+    hcb_builder* builder;
+    int listen_fd;
+    char* unix_path;                      // Socket file removed when closing, NULL for TCP
+    long long unsigned int lease_size;
+    int lease_timeout;
+    int wake[2];                          // Written by hcb_coordinator_cancel to interrupt the wait
+    atomic_bool cancelled;
+    scratchpad_t* scratchpad;             // Verifies the nonces found in a memory-hard chain
+
+    connection_t workers[COORDINATOR_MAX_WORKERS];
+    int worker_count;
+
+    // Current level
+    int level;
+    nonce_t next;                         // First nonce never leased
+    nonce_t best;                         // Lowest valid nonce reported, NONCE_MAX if none
+
+    // Leases of the lost workers, leased again before any new nonce
+    // There are never more reclaimed and leased ranges than workers, so this cannot overflow
+    range_t reclaimed[COORDINATOR_MAX_WORKERS];
+    int reclaimed_count;
+};
+
+struct hcb_worker {
+    int fd;
+    int threads;
+    const SHA256_KERNEL* kernel;
+    bool pinned;
+    throttle_t* throttle;
+    search_t* search;
+    int wake[2];                          // Written when the search ends or hcb_worker_cancel is called
+    atomic_bool cancelled;
+
+    // Messages of the coordinator not processed yet
+    char* buffer;
+    size_t length;
+    size_t capacity;
+
+    // Lease being searched
+    bool leased;
+    pthread_t thread;
+    atomic_bool searched;                 // The search thread is done
+    char* message;
+    int level;
+    nonce_t start;
+    nonce_t end;
+    int result;
+    nonce_t nonce;
+    BYTE hash[SHA256_BLOCK_SIZE];
+};
+
+// Create a stream socket listening at address, or connected to it, -1 on failure
+// The address is "unix:PATH" or "HOST:PORT", an IPv6 host is written in brackets
+static int address_socket(const char* address, bool listening) {
+
+    int fd;
+    int one = 1;
+
+    if (strncmp(address, "unix:", 5) == 0) {
+        const char* path = address + 5;
+        struct sockaddr_un sun;
+        memset(&sun, 0, sizeof(sun));
+        sun.sun_family = AF_UNIX;
+        if (strlen(path) == 0 || strlen(path) >= sizeof(sun.sun_path) || (fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+            return -1;
+        }
+        strcpy(sun.sun_path, path);
+        if (listening) {
+            // Replace the socket left by a previous coordinator, never another kind of file
+            struct stat st;
+            if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+                unlink(path);
+            }
+            if (bind(fd, (struct sockaddr*)&sun, sizeof(sun)) != 0 || listen(fd, SOMAXCONN) != 0) {
+                close(fd);
+                return -1;
+            }
+        } else if (connect(fd, (struct sockaddr*)&sun, sizeof(sun)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    // The port follows the last colon
+    char host[256];
+    const char* colon = strrchr(address, ':');
+    ptrdiff_t length = colon != NULL ? colon - address : -1;
+    if (length < 0 || (size_t)length >= sizeof(host)) {
+        return -1;
+    }
+    memcpy(host, address, (size_t)length);
+    host[length] = '\0';
+    char* name = host;
+    if (name[0] == '[' && strlen(name) >= 2 && name[strlen(name) - 1] == ']') {
+        name[strlen(name) - 1] = '\0';
+        name++;
+    }
+
+    struct addrinfo hints;
+    struct addrinfo* result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = listening ? AI_PASSIVE : 0;
+    if (getaddrinfo(name[0] != '\0' ? name : NULL, colon + 1, &hints, &result) != 0) {
+        return -1;
+    }
+    fd = -1;
+    for (struct addrinfo* ai = result; ai != NULL && fd < 0; ai = ai->ai_next) {
+        if ((fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)) < 0) {
+            continue;
+        }
+        if (listening) {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            if (bind(fd, ai->ai_addr, ai->ai_addrlen) != 0 || listen(fd, SOMAXCONN) != 0) {
+                close(fd);
+                fd = -1;
+            }
+        } else if (connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(result);
+
+    // The messages are short and answer each other, they must not wait for more data
+    if (fd >= 0 && !listening) {
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+
+}
+
+// Send a line formatted like printf, returns false if the peer is gone
+// A peer leaving never raises SIGPIPE
+static bool send_line(int fd, const char* format, ...) {
+
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    char* line = malloc(length + 1);
+    if (line == NULL) {
+        return false;
+    }
+    va_start(args, format);
+    vsnprintf(line, length + 1, format, args);
+    va_end(args);
+
+    int sent = 0;
+    while (sent < length) {
+        ssize_t written = send(fd, line + sent, length - sent, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            break;
+        }
+        sent += written;
+    }
+    free(line);
+    return sent == length;
+
+}
+
+// Create a pipe whose reads never block, used to wake up a poll from another thread
+static bool wake_pipe(int fds[2]) {
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    return true;
+}
+
+// Empty a wake pipe
+static void drain(int fd) {
+    char buffer[64];
+    while (read(fd, buffer, sizeof(buffer)) > 0);
+}
+
+hcb_status hcb_coordinator_create(hcb_coordinator** result, hcb_builder* builder, const char* address, long long unsigned int lease_size, int lease_timeout, hcb_error* error) {
+
+    *result = NULL;
+    hcb_coordinator* coordinator = calloc(1, sizeof(hcb_coordinator));
+    if (coordinator == NULL) {
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+    }
+    if (!wake_pipe(coordinator->wake)) {
+        free(coordinator);
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+    }
+    size_t memory = hcb_builder_memory(builder);
+    if (memory != 0 && (coordinator->scratchpad = scratchpad_create(memory)) == NULL) {
+        close(coordinator->wake[0]);
+        close(coordinator->wake[1]);
+        free(coordinator);
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory for a scratchpad of %zu KiB", memory);
+    }
+    coordinator->builder = builder;
+    coordinator->lease_size = lease_size > 0 ? lease_size : COORDINATOR_LEASE_SIZE;
+    coordinator->lease_timeout = lease_timeout > 0 ? lease_timeout : COORDINATOR_LEASE_TIMEOUT;
+    if ((coordinator->listen_fd = address_socket(address, true)) < 0) {
+        close(coordinator->wake[0]);
+        close(coordinator->wake[1]);
+        scratchpad_destroy(coordinator->scratchpad);
+        free(coordinator);
+        return util_fail(error, HCB_ERROR_ADDRESS, "Error: Unable to listen to \"%s\"", address);
+    }
+    if (strncmp(address, "unix:", 5) == 0) {
+        coordinator->unix_path = strdup(address + 5);
+    }
+
+    *result = coordinator;
+    return util_fail(error, HCB_OK, "");
+
+}
+
+// Keep the untested nonces of a range to lease them again
+static void coordinator_reclaim(hcb_coordinator* coordinator, nonce_t start, nonce_t end) {
+    if (end > coordinator->best) {
+        end = coordinator->best;
+    }
+    if (start < end) {
+        coordinator->reclaimed[coordinator->reclaimed_count].start = start;
+        coordinator->reclaimed[coordinator->reclaimed_count].end = end;
+        coordinator->reclaimed_count++;
+    }
+}
+
+// Disconnect a worker, its lease is reclaimed
+// The last worker takes its place
+static void coordinator_drop(hcb_coordinator* coordinator, int index) {
+    connection_t* worker = &coordinator->workers[index];
+    if (worker->leased) {
+        coordinator_reclaim(coordinator, worker->position, worker->lease.end);
+    }
+    close(worker->fd);
+    coordinator->worker_count--;
+    if (index != coordinator->worker_count) {
+        *worker = coordinator->workers[coordinator->worker_count];
+    }
+}
+
+// Lowest nonce of the level that may not have been tested, capped by the lowest valid one
+static nonce_t coordinator_position(hcb_coordinator* coordinator) {
+    nonce_t position = coordinator->next < coordinator->best ? coordinator->next : coordinator->best;
+    for (int i = 0; i < coordinator->reclaimed_count; i++) {
+        if (coordinator->reclaimed[i].start < position) {
+            position = coordinator->reclaimed[i].start;
+        }
+    }
+    for (int i = 0; i < coordinator->worker_count; i++) {
+        if (coordinator->workers[i].leased && coordinator->workers[i].position < position) {
+            position = coordinator->workers[i].position;
+        }
+    }
+    return position;
+}
+
+// Lease nonces to the idle workers, the reclaimed ranges first
+// Returns false if a worker was lost, it was dropped and the leases must be given again
+static bool coordinator_lease(hcb_coordinator* coordinator) {
+
+    const char* message = hcb_builder_message(coordinator->builder);
+    char start[NONCE_DIGITS + 1];
+    char end[NONCE_DIGITS + 1];
+
+    for (int i = 0; i < coordinator->worker_count; i++) {
+
+        connection_t* worker = &coordinator->workers[i];
+        if (worker->leased) {
+            continue;
+        }
+
+        // Ranges above the lowest valid nonce are useless
+        while (coordinator->reclaimed_count > 0 && coordinator->reclaimed[coordinator->reclaimed_count - 1].start >= coordinator->best) {
+            coordinator->reclaimed_count--;
+        }
+        if (coordinator->reclaimed_count > 0) {
+            worker->lease = coordinator->reclaimed[--coordinator->reclaimed_count];
+        } else if (coordinator->next < coordinator->best) {
+            worker->lease.start = coordinator->next;
+            worker->lease.end = NONCE_MAX - coordinator->next > coordinator->lease_size ? coordinator->next + coordinator->lease_size : NONCE_MAX;
+            coordinator->next = worker->lease.end;
+        } else {
+            return true;
+        }
+        worker->leased = true;
+        worker->position = worker->lease.start;
+        worker->last_seen = util_now();
+
+        nonce_format(worker->lease.start, 0, start);
+        nonce_format(worker->lease.end, 0, end);
+        if (!send_line(worker->fd, "LEASE %d %s %s %s %zu %s\n", coordinator->level, start, end, hcb_builder_hash(coordinator->builder)->name, hcb_builder_memory(coordinator->builder), message)) {
+            coordinator_drop(coordinator, i);
+            return false;
+        }
+
+    }
+    return true;
+
+}
+
+// Apply a report of a worker, returns false if it is not a valid one
+static bool coordinator_report(hcb_coordinator* coordinator, connection_t* worker, const char* line) {
+
+    char kind[16];
+    char start_text[SHA256_BLOCK_SIZE * 2 + 1];
+    char value_text[SHA256_BLOCK_SIZE * 2 + 1];
+    int level;
+    int length = -1;
+    nonce_t start, value;
+    if (sscanf(line, "%15s %d %64[0-9] %64[0-9]%n", kind, &level, start_text, value_text, &length) != 4 || length < 0 || line[length] != '\0' ||
+        !nonce_parse(start_text, strlen(start_text), &start) || !nonce_parse(value_text, strlen(value_text), &value)) {
+        return false;
+    }
+
+    // Reports about a dropped lease
+    if (!worker->leased || level != coordinator->level || start != worker->lease.start) {
+        return strcmp(kind, "PROGRESS") == 0 || strcmp(kind, "FOUND") == 0 || strcmp(kind, "DONE") == 0 || strcmp(kind, "STOPPED") == 0;
+    }
+
+    if (strcmp(kind, "PROGRESS") == 0) {
+
+        if (value > worker->position && value <= worker->lease.end) {
+            worker->position = value;
+        }
+
+    } else if (strcmp(kind, "DONE") == 0) {
+
+        worker->leased = false;
+
+    } else if (strcmp(kind, "STOPPED") == 0) {
+
+        coordinator_reclaim(coordinator, value > worker->position && value <= worker->lease.end ? value : worker->position, worker->lease.end);
+        worker->leased = false;
+
+    } else if (strcmp(kind, "FOUND") == 0) {
+
+        // The nonce is checked before it can end the level
+        BYTE hash[SHA256_BLOCK_SIZE];
+        char string_nonce[SHA256_BLOCK_SIZE * 2 + 1];
+        verify_block_t candidate;
+        const char* message = hcb_builder_message(coordinator->builder);
+        if (value < worker->lease.start || value >= worker->lease.end) {
+            return false;
+        }
+        nonce_format(value, nonce_length, string_nonce);
+        candidate.message = message;
+        candidate.message_length = strlen(message);
+        candidate.nonce = string_nonce;
+        verify_hash(&candidate, hcb_builder_hash(coordinator->builder), coordinator->scratchpad, hash);
+        if (numberOfZero(hash, SHA256_BLOCK_SIZE) != coordinator->level) {
+            return false;
+        }
+        if (value < coordinator->best) {
+            coordinator->best = value;
+        }
+        worker->leased = false;
+
+    } else {
+
+        return false;
+
+    }
+    return true;
+
+}
+
+// Read the reports of a worker, returns false if it is gone or sent an unexpected message
+static bool coordinator_receive(hcb_coordinator* coordinator, connection_t* worker) {
+
+    ssize_t received = read(worker->fd, worker->line + worker->line_length, sizeof(worker->line) - 1 - worker->line_length);
+    if (received < 0 && errno == EINTR) {
+        return true;
+    }
+    if (received <= 0) {
+        return false;
+    }
+    worker->line_length += received;
+    worker->line[worker->line_length] = '\0';
+    worker->last_seen = util_now();
+
+    char* line = worker->line;
+    char* end;
+    while ((end = strchr(line, '\n')) != NULL) {
+        *end = '\0';
+        if (!coordinator_report(coordinator, worker, line)) {
+            return false;
+        }
+        line = end + 1;
+    }
+
+    // A line filling the buffer is not a report
+    worker->line_length -= line - worker->line;
+    memmove(worker->line, line, worker->line_length);
+    return worker->line_length < sizeof(worker->line) - 1;
+
+}
+
+// Accept a new worker, it is leased nonces by the next call to coordinator_lease
+static void coordinator_accept(hcb_coordinator* coordinator) {
+    int one = 1;
+    int fd = accept(coordinator->listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return;
+    }
+    if (coordinator->worker_count == COORDINATOR_MAX_WORKERS) {
+        close(fd);
+        return;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    connection_t* worker = &coordinator->workers[coordinator->worker_count++];
+    memset(worker, 0, sizeof(connection_t));
+    worker->fd = fd;
+    worker->last_seen = util_now();
+}
+
+// Drop every lease of the level, the workers are told to stop searching them
+static void coordinator_release(hcb_coordinator* coordinator) {
+    for (int i = coordinator->worker_count - 1; i >= 0; i--) {
+        if (coordinator->workers[i].leased) {
+            coordinator->workers[i].leased = false;
+            if (!send_line(coordinator->workers[i].fd, "CANCEL\n")) {
+                coordinator_drop(coordinator, i);
+            }
+        }
+    }
+    coordinator->reclaimed_count = 0;
+}
+
+hcb_status hcb_coordinator_next(hcb_coordinator* coordinator, hcb_block* block, hcb_error* error) {
+
+    struct pollfd fds[COORDINATOR_MAX_WORKERS + 2];
+    search_t* search = hcb_builder_search(coordinator->builder);
+    double start = util_now();
+
+    // Lease the level from the nonce its search resumes from
+    nonce_t resume = hcb_builder_position(coordinator->builder);
+    coordinator->level = hcb_builder_level(coordinator->builder);
+    coordinator->next = resume;
+    coordinator->best = NONCE_MAX;
+    coordinator->reclaimed_count = 0;
+
+    while (1) {
+
+        // The position is kept in the searcher of the builder, for its checkpoints
+        nonce_t position = coordinator_position(coordinator);
+        search_set_position(search, position);
+        if (atomic_load(&coordinator->cancelled)) {
+            coordinator_release(coordinator);
+            return util_fail(error, HCB_CANCELLED, "Search of block #%d cancelled", coordinator->level);
+        }
+
+        // Every nonce below the lowest valid one was tested
+        if (position >= coordinator->best) {
+            break;
+        }
+
+        while (!coordinator_lease(coordinator));
+
+        // Wait for a report, a new worker or a cancellation
+        fds[0].fd = coordinator->wake[0];
+        fds[1].fd = coordinator->listen_fd;
+        for (int i = 0; i < coordinator->worker_count; i++) {
+            fds[i + 2].fd = coordinator->workers[i].fd;
+        }
+        for (int i = 0; i < coordinator->worker_count + 2; i++) {
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+        int count = coordinator->worker_count;
+        if (poll(fds, count + 2, PROGRESS_INTERVAL * 1000) < 0 && errno != EINTR) {
+            coordinator_release(coordinator);
+            return util_fail(error, HCB_ERROR_ADDRESS, "Error: Unable to wait for the workers");
+        }
+        if (fds[0].revents != 0) {
+            drain(coordinator->wake[0]);
+        }
+
+        // From the last worker, so the one replacing a dropped worker was already read
+        double time = util_now();
+        for (int i = count - 1; i >= 0; i--) {
+            connection_t* worker = &coordinator->workers[i];
+            if ((fds[i + 2].revents != 0 && !coordinator_receive(coordinator, worker)) ||
+                (worker->leased && time - worker->last_seen > coordinator->lease_timeout)) {
+                coordinator_drop(coordinator, i);
+            }
+        }
+        if (fds[1].revents != 0) {
+            coordinator_accept(coordinator);
+        }
+
+    }
+
+    // The other workers are stopped and the block is written like a search would
+    coordinator_release(coordinator);
+    return hcb_builder_append(coordinator->builder, coordinator->best, coordinator->best + 1 - resume, util_now() - start, block, error);
+
+}
+
+void hcb_coordinator_cancel(hcb_coordinator* coordinator) {
+    atomic_store(&coordinator->cancelled, true);
+    if (write(coordinator->wake[1], "c", 1) < 0) {
+        // The pipe is already full, the coordinator wakes up anyway
+    }
+}
+
+int hcb_coordinator_workers(const hcb_coordinator* coordinator) {
+    return coordinator->worker_count;
+}
+
+void hcb_coordinator_close(hcb_coordinator* coordinator) {
+    if (coordinator == NULL) {
+        return;
+    }
+    for (int i = 0; i < coordinator->worker_count; i++) {
+        close(coordinator->workers[i].fd);
+    }
+    close(coordinator->listen_fd);
+    if (coordinator->unix_path != NULL) {
+        unlink(coordinator->unix_path);
+        free(coordinator->unix_path);
+    }
+    close(coordinator->wake[0]);
+    close(coordinator->wake[1]);
+    scratchpad_destroy(coordinator->scratchpad);
+    free(coordinator);
+}
+
+hcb_status hcb_worker_create(hcb_worker** result, const char* address, const hcb_options* options, hcb_error* error) {
+
+    *result = NULL;
+    hcb_worker* worker = calloc(1, sizeof(hcb_worker));
+    if (worker == NULL || (worker->search = search_create()) == NULL) {
+        free(worker);
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+    }
+    worker->threads = options != NULL ? options->threads : 0;
+    worker->kernel = options != NULL ? options->kernel : NULL;
+    worker->pinned = options != NULL && options->pinned;
+    worker->throttle = options != NULL ? options->throttle : NULL;
+    search_set_threads(worker->search, worker->threads);
+    search_set_pinned(worker->search, worker->pinned);
+    search_set_throttle(worker->search, worker->throttle);
+    if (worker->kernel != NULL) {
+        search_set_kernel(worker->search, worker->kernel);
+    }
+    if (!wake_pipe(worker->wake)) {
+        search_destroy(worker->search);
+        free(worker);
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+    }
+    if ((worker->fd = address_socket(address, false)) < 0) {
+        close(worker->wake[0]);
+        close(worker->wake[1]);
+        search_destroy(worker->search);
+        free(worker);
+        return util_fail(error, HCB_ERROR_ADDRESS, "Error: Unable to connect to \"%s\"", address);
+    }
+
+    *result = worker;
+    return util_fail(error, HCB_OK, "");
+
+}
+
+// Thread searching the lease, the main thread keeps talking to the coordinator
+static void* worker_search(void* arg) {
+    hcb_worker* worker = arg;
+    worker->result = search_run(worker->search, worker->message, worker->level, worker->start, worker->end, &worker->nonce, worker->hash);
+    atomic_store(&worker->searched, true);
+    if (write(worker->wake[1], "s", 1) < 0) {
+        // The pipe is already full, the main thread wakes up anyway
+    }
+    return NULL;
+}
+
+// Wait for the end of the search of the lease, stopping it first if stop is true
+// A stopped searcher stays cancelled, so it is replaced, returns false if out of memory
+static bool worker_join(hcb_worker* worker, bool stop) {
+    if (stop) {
+        search_cancel(worker->search);
+    }
+    pthread_join(worker->thread, NULL);
+    worker->leased = false;
+    free(worker->message);
+    worker->message = NULL;
+    if (stop) {
+        search_t* search = search_create();
+        if (search == NULL) {
+            return false;
+        }
+        search_set_threads(search, worker->threads);
+        search_set_kernel(search, search_get_kernel(worker->search));
+        search_set_pinned(search, worker->pinned);
+        search_set_throttle(search, worker->throttle);
+        search_destroy(worker->search);
+        worker->search = search;
+    }
+    return true;
+}
+
+// Send a report about the lease to the coordinator: "kind level start value"
+static bool worker_send(hcb_worker* worker, const char* kind, nonce_t value) {
+    char start[NONCE_DIGITS + 1];
+    char text[NONCE_DIGITS + 1];
+    nonce_format(worker->start, 0, start);
+    nonce_format(value, 0, text);
+    return send_line(worker->fd, "%s %d %s %s\n", kind, worker->level, start, text);
+}
+
+// Tell the coordinator how the search of the lease ended
+static bool worker_report(hcb_worker* worker) {
+    switch (worker->result) {
+        case SEARCH_FOUND:
+            return worker_send(worker, "FOUND", worker->nonce);
+        case SEARCH_EXHAUSTED:
+            return worker_send(worker, "DONE", worker->end);
+        default:
+            return worker_send(worker, "STOPPED", search_position(worker->search));
+    }
+}
+
+// Start searching the lease described by a LEASE message
+static hcb_status worker_lease(hcb_worker* worker, const char* line, hcb_error* error) {
+
+    // The message follows a single space, it may start with spaces itself
+    char start[SHA256_BLOCK_SIZE * 2 + 1];
+    char end[SHA256_BLOCK_SIZE * 2 + 1];
+    char algorithm[32];
+    const HASH_ALGORITHM* hash;
+    size_t memory;
+    int offset = -1;
+    if (sscanf(line, "LEASE %d %64[0-9] %64[0-9] %31[a-z0-9-] %zu%n", &worker->level, start, end, algorithm, &memory, &offset) != 5 || offset < 0 || line[offset] != ' ' ||
+        !nonce_parse(start, strlen(start), &worker->start) || !nonce_parse(end, strlen(end), &worker->end) ||
+        (hash = hash_algorithm_find(algorithm)) == NULL || memory > SCRATCHPAD_MAX_SIZE) {
+        return util_fail(error, HCB_ERROR_PROTOCOL, "Error: Unexpected message from the coordinator");
+    }
+    search_set_hash(worker->search, hash);
+    if (!search_set_memory(worker->search, memory)) {
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory for a scratchpad of %zu KiB", memory);
+    }
+    if ((worker->message = strdup(line + offset + 1)) == NULL) {
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+    }
+    atomic_store(&worker->searched, false);
+    if (pthread_create(&worker->thread, NULL, worker_search, worker) != 0) {
+        free(worker->message);
+        worker->message = NULL;
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+    }
+    worker->leased = true;
+    return HCB_OK;
+
+}
+
+// Apply the messages of the coordinator received so far
+static hcb_status worker_receive(hcb_worker* worker, hcb_error* error) {
+
+    hcb_status status;
+    char* line = worker->buffer;
+    char* end;
+    while ((end = memchr(line, '\n', worker->length - (line - worker->buffer))) != NULL) {
+        *end = '\0';
+        if (strcmp(line, "CANCEL") == 0) {
+            if (worker->leased && !worker_join(worker, true)) {
+                return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+            }
+        } else {
+            // A lease always follows the end of the previous one
+            if (worker->leased && !worker_join(worker, true)) {
+                return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+            }
+            if ((status = worker_lease(worker, line, error)) != HCB_OK) {
+                return status;
+            }
+        }
+        line = end + 1;
+    }
+    worker->length -= line - worker->buffer;
+    memmove(worker->buffer, line, worker->length);
+    return HCB_OK;
+
+}
+
+hcb_status hcb_worker_run(hcb_worker* worker, hcb_error* error) {
+
+    hcb_status status = HCB_OK;
+    double last_report = util_now();
+
+    while (1) {
+
+        struct pollfd fds[2] = {{worker->fd, POLLIN, 0}, {worker->wake[0], POLLIN, 0}};
+        if (poll(fds, 2, worker->leased ? PROGRESS_INTERVAL * 1000 : -1) < 0 && errno != EINTR) {
+            status = util_fail(error, HCB_ERROR_ADDRESS, "Error: Unable to wait for the coordinator");
+            break;
+        }
+        if (fds[1].revents != 0) {
+            drain(worker->wake[0]);
+        }
+
+        // Tell the coordinator which nonces of the lease were not tested
+        // The result is only read once the search thread wrote it: a search ending before it
+        // noticed the cancellation reports its nonce, a cancelled one the first untested nonce
+        if (atomic_load(&worker->cancelled)) {
+            if (worker->leased) {
+                search_cancel(worker->search);
+                pthread_join(worker->thread, NULL);
+                worker->leased = false;
+                worker_report(worker);
+            }
+            return util_fail(error, HCB_CANCELLED, "Worker cancelled");
+        }
+
+        // The lease was searched
+        if (worker->leased && atomic_load(&worker->searched)) {
+            worker_join(worker, false);
+            if (!worker_report(worker)) {
+                break;
+            }
+        }
+
+        // Messages of the coordinator, which disconnects once its chain is done
+        if (fds[0].revents != 0) {
+            if (worker->capacity - worker->length < 4096) {
+                char* buffer = realloc(worker->buffer, worker->capacity + 4096);
+                if (buffer == NULL) {
+                    status = util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+                    break;
+                }
+                worker->buffer = buffer;
+                worker->capacity += 4096;
+            }
+            ssize_t received = read(worker->fd, worker->buffer + worker->length, worker->capacity - worker->length);
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received <= 0) {
+                break;
+            }
+            worker->length += received;
+            if ((status = worker_receive(worker, error)) != HCB_OK) {
+                break;
+            }
+        }
+
+        // The progress also tells the coordinator that this worker is alive
+        if (worker->leased && util_now() - last_report >= PROGRESS_INTERVAL) {
+            last_report = util_now();
+            if (!worker_send(worker, "PROGRESS", search_position(worker->search))) {
+                break;
+            }
+        }
+
+    }
+
+    if (worker->leased) {
+        worker_join(worker, true);
+    }
+    return status == HCB_OK ? util_fail(error, HCB_OK, "") : status;
+
+}
+
+void hcb_worker_cancel(hcb_worker* worker) {
+    atomic_store(&worker->cancelled, true);
+    if (write(worker->wake[1], "c", 1) < 0) {
+        // The pipe is already full, the worker wakes up anyway
+    }
+}
+
+void hcb_worker_close(hcb_worker* worker) {
+    if (worker == NULL) {
+        return;
+    }
+    close(worker->fd);
+    close(worker->wake[0]);
+    close(worker->wake[1]);
+    search_destroy(worker->search);
+    free(worker->message);
+    free(worker->buffer);
+    free(worker);
+}
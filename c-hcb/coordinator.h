@@ -0,0 +1,65 @@
+#ifndef COORDINATOR_H
+#define COORDINATOR_H
+
+#include "hcb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default number of nonces leased at once to a worker
+#define COORDINATOR_LEASE_SIZE 10000000ULL
+
+// Default seconds without news from a worker before its lease is given to another one
+#define COORDINATOR_LEASE_TIMEOUT 30
+
+// Maximum number of workers connected at once
+#define COORDINATOR_MAX_WORKERS 256
+
+// Splits the levels of a chain between hcb worker processes: each worker is leased disjoint nonce
+// ranges and reports the first valid nonce of its range, the lowest valid nonce is always kept so
+// the chain is the same as the one a single process would produce
+// The addresses are "unix:PATH" for a Unix domain socket or "HOST:PORT" for TCP
+typedef struct hcb_coordinator hcb_coordinator;
+
+// A process searching the nonces leased by a coordinator
+typedef struct hcb_worker hcb_worker;
+
+// Listen for workers at address, the blocks found are appended to builder
+hcb_status hcb_coordinator_create(hcb_coordinator** coordinator, hcb_builder* builder, const char* address, long long unsigned int lease_size, int lease_timeout, hcb_error* error);
+
+// Lease the nonces of the next block to the workers and append the block to the chain, block may
+// be NULL
+// The search progress is kept in the builder, so hcb_builder_position and hcb_builder_checkpoint
+// can be used while it runs
+// Returns HCB_CANCELLED if hcb_coordinator_cancel was called
+hcb_status hcb_coordinator_next(hcb_coordinator* coordinator, hcb_block* block, hcb_error* error);
+
+// Stop leasing nonces, can be called from any thread
+void hcb_coordinator_cancel(hcb_coordinator* coordinator);
+
+// Number of workers connected
+int hcb_coordinator_workers(const hcb_coordinator* coordinator);
+
+// Disconnect the workers, they exit
+void hcb_coordinator_close(hcb_coordinator* coordinator);
+
+// Connect to the coordinator listening at address, options give the threads, their pinning and
+// the kernel searching the leased nonces
+hcb_status hcb_worker_create(hcb_worker** worker, const char* address, const hcb_options* options, hcb_error* error);
+
+// Search the nonces leased by the coordinator until it disconnects
+// Returns HCB_CANCELLED if hcb_worker_cancel was called, the coordinator is then told which nonces
+// of the lease were not tested
+hcb_status hcb_worker_run(hcb_worker* worker, hcb_error* error);
+
+// Stop the search, can be called from any thread
+void hcb_worker_cancel(hcb_worker* worker);
+
+void hcb_worker_close(hcb_worker* worker);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   // COORDINATOR_H
@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include "energy.h"
+
+// Size of the path of a zone directory, and of a file in it: the longest file name,
+// max_energy_range_uj, fits in the difference
+#define ZONE_PATH_SIZE 1024
+#define FILE_PATH_SIZE (ZONE_PATH_SIZE + 32)
+
+// A package zone: its energy_uj file, kept open, and the last value read from it
+typedef struct {
+    int fd;
+    long long unsigned int range;         // The counter wraps around to 0 after this value
+    long long unsigned int last;
+} zone_t;
+
+struct energy_s {
+    zone_t zones[ENERGY_MAX_ZONES];
+    int count;
+    pthread_mutex_t lock;
+    double joules;                        // Used since energy_open, up to the last read
+};
+
+// Read the integer at the start of the file of fd
+static bool read_counter(int fd, long long unsigned int* value) {
+    char text[32];
+    ssize_t length = pread(fd, text, sizeof(text) - 1, 0);
+    if (length <= 0) {
+        return false;
+    }
+    text[length] = '\0';
+    char* end_ptr = NULL;
+    *value = strtoull(text, &end_ptr, 10);
+    return end_ptr != text;
+}
+
+// Read the integer in the file name of the zone directory, false if it cannot be read
+static bool read_file(const char* directory, const char* name, long long unsigned int* value) {
+    char path[FILE_PATH_SIZE];
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool read = read_counter(fd, value);
+    close(fd);
+    return read;
+}
+
+// Whether the zone directory measures a package, from its name file ("package-0")
+static bool is_package(const char* directory) {
+    char path[FILE_PATH_SIZE];
+    char name[64] = "";
+    snprintf(path, sizeof(path), "%s/name", directory);
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        return false;
+    }
+    bool read = fgets(name, sizeof(name), fp) != NULL;
+    fclose(fp);
+    return read && strncmp(name, "package", 7) == 0;
+}
+
+energy_t* energy_open(const char* root) {
+
+    char directory[ZONE_PATH_SIZE];
+    char path[FILE_PATH_SIZE];
+    if (root == NULL) {
+        root = ENERGY_POWERCAP_ROOT;
+    }
+    DIR* dir = opendir(root);
+    if (dir == NULL) {
+        return NULL;
+    }
+    energy_t* energy = calloc(1, sizeof(energy_t));
+    if (energy == NULL) {
+        closedir(dir);
+        return NULL;
+    }
+
+    // The packages are the top zones of the intel-rapl control type, also used on AMD; the
+    // intel-rapl-mmio zones measure the same packages again
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL && energy->count < ENERGY_MAX_ZONES) {
+        if (strncmp(entry->d_name, "intel-rapl:", 11) != 0) {
+            continue;
+        }
+        snprintf(directory, sizeof(directory), "%s/%s", root, entry->d_name);
+        zone_t* zone = &energy->zones[energy->count];
+        if (!is_package(directory) || !read_file(directory, "max_energy_range_uj", &zone->range)) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/energy_uj", directory);
+        if ((zone->fd = open(path, O_RDONLY)) < 0) {
+            continue;
+        }
+        if (!read_counter(zone->fd, &zone->last)) {
+            close(zone->fd);
+            continue;
+        }
+        energy->count++;
+    }
+    closedir(dir);
+
+    if (energy->count == 0) {
+        free(energy);
+        return NULL;
+    }
+    pthread_mutex_init(&energy->lock, NULL);
+    return energy;
+
+}
+
+void energy_close(energy_t* energy) {
+    if (energy == NULL) {
+        return;
+    }
+    for (int i = 0; i < energy->count; i++) {
+        close(energy->zones[i].fd);
+    }
+    pthread_mutex_destroy(&energy->lock);
+    free(energy);
+}
+
+int energy_zones(const energy_t* energy) {
+    return energy->count;
+}
+
+double energy_read(energy_t* energy) {
+
+    pthread_mutex_lock(&energy->lock);
+    for (int i = 0; i < energy->count; i++) {
+        zone_t* zone = &energy->zones[i];
+        long long unsigned int value;
+        if (!read_counter(zone->fd, &value)) {
+            continue;
+        }
+
+        // A lower value wrapped around once since the last read
+        long long unsigned int used = value >= zone->last ? value - zone->last : zone->range - zone->last + value;
+        energy->joules += used / 1e6;
+        zone->last = value;
+    }
+    double joules = energy->joules;
+    pthread_mutex_unlock(&energy->lock);
+    return joules;
+
+}
@@ -0,0 +1,37 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Directory of the powercap zones of Linux
+#define ENERGY_POWERCAP_ROOT "/sys/class/powercap"
+
+// Most processor packages whose energy is added up
+#define ENERGY_MAX_ZONES 16
+
+// Energy used by the processor packages, from the RAPL zones of powercap
+typedef struct energy_s energy_t;
+
+// Open the package zones of the powercap tree at root (NULL for ENERGY_POWERCAP_ROOT), the
+// directories whose name file starts with "package"
+// NULL if no zone can be read (no RAPL, or energy_uj only readable by root) or if out of memory
+energy_t* energy_open(const char* root);
+
+void energy_close(energy_t* energy);
+
+// Number of packages measured
+int energy_zones(const energy_t* energy);
+
+// Joules used by the packages since energy_open
+// The counters wrap around, after minutes to hours depending on the power: reading them at least
+// once per second, as the monitor of hcb does, never misses a wrap
+// Thread-safe, it reads a few small files and should not be called from the hash loops
+double energy_read(energy_t* energy);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   // ENERGY_H
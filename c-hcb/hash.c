@@ -0,0 +1,114 @@
+/*********************************************************************
+* Filename:   hash.c
+* Details:    Table of the hash algorithms a chain can be built with.
+*********************************************************************/
+
+/*************************** HEADER FILES ***************************/
+#include <string.h>
+#include "hash.h"
+
+/*********************** FUNCTION DEFINITIONS ***********************/
+static void hash_sha256_init(HASH_CTX *ctx)
+{
+	sha256_init(&ctx->sha256);
+}
+
+static void hash_sha256_update(HASH_CTX *ctx, const BYTE data[], size_t len)
+{
+	sha256_update(&ctx->sha256, data, len);
+}
+
+static void hash_sha256_final(HASH_CTX *ctx, BYTE hash[])
+{
+	sha256_final(&ctx->sha256, hash);
+}
+
+static void hash_sha512_256_init(HASH_CTX *ctx)
+{
+	sha512_256_init(&ctx->sha512);
+}
+
+static void hash_sha512_update(HASH_CTX *ctx, const BYTE data[], size_t len)
+{
+	sha512_update(&ctx->sha512, data, len);
+}
+
+static void hash_sha512_256_final(HASH_CTX *ctx, BYTE hash[])
+{
+	sha512_256_final(&ctx->sha512, hash);
+}
+
+static void hash_sha3_256_init(HASH_CTX *ctx)
+{
+	sha3_256_init(&ctx->sha3);
+}
+
+static void hash_sha3_256_update(HASH_CTX *ctx, const BYTE data[], size_t len)
+{
+	sha3_256_update(&ctx->sha3, data, len);
+}
+
+static void hash_sha3_256_final(HASH_CTX *ctx, BYTE hash[])
+{
+	sha3_256_final(&ctx->sha3, hash);
+}
+
+static void hash_blake2b_256_init(HASH_CTX *ctx)
+{
+	blake2b_256_init(&ctx->blake2b);
+}
+
+static void hash_blake2b_update(HASH_CTX *ctx, const BYTE data[], size_t len)
+{
+	blake2b_update(&ctx->blake2b, data, len);
+}
+
+static void hash_blake2b_256_final(HASH_CTX *ctx, BYTE hash[])
+{
+	blake2b_256_final(&ctx->blake2b, hash);
+}
+
+/*************************** ALGORITHMS *****************************/
+const HASH_ALGORITHM hash_sha256 = {"sha256", 0, hash_sha256_init, hash_sha256_update, hash_sha256_final};
+const HASH_ALGORITHM hash_sha512_256 = {"sha512-256", 1, hash_sha512_256_init, hash_sha512_update, hash_sha512_256_final};
+const HASH_ALGORITHM hash_sha3_256 = {"sha3-256", 2, hash_sha3_256_init, hash_sha3_256_update, hash_sha3_256_final};
+const HASH_ALGORITHM hash_blake2b_256 = {"blake2b-256", 3, hash_blake2b_256_init, hash_blake2b_update, hash_blake2b_256_final};
+
+const HASH_ALGORITHM *const hash_algorithms[] = {
+	&hash_sha256,
+	&hash_sha512_256,
+	&hash_sha3_256,
+	&hash_blake2b_256,
+	NULL
+};
+
+const HASH_ALGORITHM *hash_algorithm_find(const char *name)
+{
+	int i;
+
+	for (i = 0; hash_algorithms[i] != NULL; ++i) {
+		if (strcmp(hash_algorithms[i]->name, name) == 0)
+			return hash_algorithms[i];
+	}
+	return NULL;
+}
+
+const HASH_ALGORITHM *hash_algorithm_id(int id)
+{
+	int i;
+
+	for (i = 0; hash_algorithms[i] != NULL; ++i) {
+		if (hash_algorithms[i]->id == id)
+			return hash_algorithms[i];
+	}
+	return NULL;
+}
+
+void hash_digest(const HASH_ALGORITHM *algorithm, const BYTE data[], size_t len, BYTE hash[])
+{
+	HASH_CTX ctx;
+
+	algorithm->init(&ctx);
+	algorithm->update(&ctx, data, len);
+	algorithm->final(&ctx, hash);
+}
@@ -0,0 +1,86 @@
+/*********************************************************************
+* Filename:   hash.h
+* Details:    Defines the hash algorithms a chain can be built with.
+              Every algorithm has a 256 bits digest, so the lines and
+              the records of a chain keep their layout whatever the
+              algorithm, only the header names it.
+*********************************************************************/
+
+#ifndef HASH_H
+#define HASH_H
+
+/*************************** HEADER FILES ***************************/
+#include <stddef.h>
+#include <stdint.h>
+#include "sha256.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************** MACROS ******************************/
+#define HASH_SIZE SHA256_BLOCK_SIZE     // Every algorithm outputs a 32 byte digest
+
+/**************************** DATA TYPES ****************************/
+typedef struct {
+	BYTE data[128];
+	size_t datalen;
+	unsigned long long bitlen;
+	uint64_t state[8];
+} SHA512_CTX;
+
+typedef struct {
+	uint64_t state[25];
+	size_t datalen;                     // Bytes absorbed in the current block of the rate
+} SHA3_CTX;
+
+typedef struct {
+	BYTE data[128];
+	size_t datalen;
+	unsigned long long length;          // Bytes compressed so far
+	uint64_t state[8];
+} BLAKE2B_CTX;
+
+typedef union {
+	SHA256_CTX sha256;
+	SHA512_CTX sha512;
+	SHA3_CTX sha3;
+	BLAKE2B_CTX blake2b;
+} HASH_CTX;
+
+// A hash algorithm of the chains, hashing a message in a streaming context: a copy of the context
+// after the start of a message hashes any of its continuations
+typedef struct {
+	const char *name;                   // Name in the header of a text chain
+	int id;                             // Number in the header of a binary chain, 0 for SHA-256
+	void (*init)(HASH_CTX *ctx);
+	void (*update)(HASH_CTX *ctx, const BYTE data[], size_t len);
+	void (*final)(HASH_CTX *ctx, BYTE hash[]);
+} HASH_ALGORITHM;
+
+/*********************** FUNCTION DECLARATIONS **********************/
+extern const HASH_ALGORITHM hash_sha256;        // The HCB 1.0 chains, searched with the SHA-256 kernels
+extern const HASH_ALGORITHM hash_sha512_256;    // SHA-512/256: the SHA-512 rounds on 64 bits words
+extern const HASH_ALGORITHM hash_sha3_256;      // SHA3-256: the Keccak-f[1600] permutation
+extern const HASH_ALGORITHM hash_blake2b_256;   // BLAKE2b with a 32 byte digest, 64 bits words
+extern const HASH_ALGORITHM *const hash_algorithms[];   // NULL terminated, SHA-256 first
+
+const HASH_ALGORITHM *hash_algorithm_find(const char *name);
+const HASH_ALGORITHM *hash_algorithm_id(int id);
+void hash_digest(const HASH_ALGORITHM *algorithm, const BYTE data[], size_t len, BYTE hash[]);
+
+void sha512_256_init(SHA512_CTX *ctx);
+void sha512_update(SHA512_CTX *ctx, const BYTE data[], size_t len);
+void sha512_256_final(SHA512_CTX *ctx, BYTE hash[]);
+void sha3_256_init(SHA3_CTX *ctx);
+void sha3_256_update(SHA3_CTX *ctx, const BYTE data[], size_t len);
+void sha3_256_final(SHA3_CTX *ctx, BYTE hash[]);
+void blake2b_256_init(BLAKE2B_CTX *ctx);
+void blake2b_update(BLAKE2B_CTX *ctx, const BYTE data[], size_t len);
+void blake2b_256_final(BLAKE2B_CTX *ctx, BYTE hash[]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   // HASH_H
@@ -3,388 +3,863 @@
 #include <stdbool.h>
 #include <memory.h>
 #include <string.h>
-#include <time.h>
 #include <signal.h>
-#include "sha256.h"
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "hcb.h"
+#include "batch.h"
+#include "binary.h"
+#include "bulk.h"
+#include "coordinator.h"
+#include "stats.h"
+#include "tune.h"
 
-// TODO: Check that the nonce is numeric only
+// Number of threads searching the nonces and checking the chains, -1 for the defaults
+static int threads = -1;
 
-// Size of a sha256 hash in hexadecimal ascii characters
-const int sha256_hex_length = SHA256_BLOCK_SIZE * 2;
+// Seconds between two checkpoints of the search progress (0 to only save it on exit)
+static int checkpoint_interval = 60;
 
-// Lenght of the nonce
-const int nonce_length = SHA256_BLOCK_SIZE * 2;
+// File rewritten every second with the statistics of the search, NULL if none
+static const char* stats_path = NULL;
 
-// Counter used to produce the nonce
-long long unsigned int counter = 0;
+// Address the workers connect to, NULL to search the nonces in this process
+static const char* coordinator_address = NULL;
 
-// Output file handle
-FILE* out_fp;
+// Nonces leased at once to a worker and seconds before a silent worker loses its lease
+static long long unsigned int lease_size = COORDINATOR_LEASE_SIZE;
+static int lease_timeout = COORDINATOR_LEASE_TIMEOUT;
 
-// Count the number of zero at left of a BYTE array (little-endian)
-int numberOfZero(BYTE array[], int len) {
-    int number = 0, i, j;
-    for (i = 0; i < len; i++) {
-        // Check in current byte
-        // Little-endian, so decrement
-        for (j = 7; j >= 0; j--) {
-            if (((array[i]>>j)&1) == 0) {
-                number++;
-            } else {
-                return number;
-            }
-        }
-    }
-    return number;
-}
+// Chain being generated, followed by the monitor
+static hcb_builder* builder = NULL;
 
-// Converts a byte array to an hexadecimal string
-char* byteToHex(BYTE array[], int len) {
-    char table[16] = "0123456789abcdef";
-    char *result = malloc((2*len+1)*sizeof(char));
-    int i;
-    for (i = 0; i < len; i++) {
-        result[i*2]   = table[(array[i]>>4)&0xF];
-        result[i*2+1] = table[ array[i]    &0xF];
-    }
-    result[2*len] = '\0';
-    return result;
-}
+// Coordinator leasing the nonces of the chain, NULL if the builder searches them
+static hcb_coordinator* coordinator = NULL;
 
-// Add right padding to a string
-char* padding_right(char* source, int length, char chr) {
-    char* padding = malloc(length * sizeof(char));
-    int i = 0;
-    for (; i < length - strlen(source); i++) {
-        padding[i] = chr;
-    }
-    padding[i] = '\0';
-    char* dest = malloc((length + 1) * sizeof(char));
-    sprintf(dest, "%s%s", source, padding);
-    return dest;
-}
+// Chains generated, &builder unless several chains are generated by a batch
+static hcb_builder** builders = &builder;
+static char** builder_paths = NULL;
+static int builder_count = 1;
+
+// Batch searching the chains of a manifest, NULL for a single chain
+static hcb_batch* batch = NULL;
+
+// Format of the report of --check-all: JSON lines, or CSV
+static bool report_csv = false;
+
+// Use of FILE.verified: --continue and --batch skip the blocks it records unless --full is given,
+// --check only trusts it with --cached as anyone can forge it
+static bool full = false;
+static bool cached = false;
+
+// Run the search in the background: at the idle priority, with a share of the CPUs available to
+// the process, backing off so the host is never busier than max_load
+static bool background = false;
+static double cpu_share = 1;
+static double max_load = 0.75;
+
+// Energy counters of the processor packages, NULL if they cannot be read, and the powercap tree
+// they are read from
+static energy_t* energy = NULL;
+static const char* powercap_root = NULL;
 
 // Print the program usage
 void printUsage() {
-    printf("Usage: hcb MESSAGE FILE | --continue FILE | --check FILE\n\n");
+    printf("Usage: hcb [OPTIONS] [--] MESSAGE FILE | --continue FILE | --check FILE | --worker ADDRESS | --batch MANIFEST\n");
+    printf("           | --to-binary TEXT BINARY | --to-text BINARY TEXT | --autotune | --check-all SOURCE\n\n");
     printf("\tMESSAGE FILE\tStarts a new hash chain with the given MESSAGE and saves it to FILE\n");
     printf("\t--continue FILE\tContinue a hash chain contained in FILE\n");
     printf("\t\t\tThe new blocks will be automatically added to the FILE \n");
-    printf("\t--check FILE\tCheck the validity of a hash chain contained in FILE\n\n");
+    printf("\t--check FILE\tCheck the validity of a hash chain contained in FILE (text or binary)\n");
+    printf("\t--worker ADDRESS\tSearch the nonces leased by the coordinator listening at ADDRESS\n");
+    printf("\t--batch MANIFEST\tGenerate the chains listed in MANIFEST (one \"FILE MESSAGE\" per line) with\n");
+    printf("\t\t\tone pool of threads (one per CPU by default), the existing FILEs are continued\n");
+    printf("\t--to-binary TEXT BINARY\tCheck the text chain TEXT and save it to BINARY in the binary format\n");
+    printf("\t--to-text BINARY TEXT\tCheck the binary chain BINARY and save it to TEXT in the text format\n");
+    printf("\t--autotune\tMeasure the kernels, thread counts and pinning of the search on this host and\n");
+    printf("\t\t\tsave the fastest, used by the searches run without --threads and --kernel\n");
+    printf("\t--check-all SOURCE\tCheck every chain of the directory SOURCE, or listed in the file SOURCE\n");
+    printf("\t\t\t(one path per line, - for the standard input) with one pool of threads, and\n");
+    printf("\t\t\tprint them ranked by number of valid blocks\n\n");
+    printf("Options:\n");
+    printf("\t--threads N\tSearch nonces with N threads (0 for one per CPU, default 1)\n");
+    printf("\t\t\tThe produced chain is the same whatever the number of threads\n");
+    printf("\t\t\tAlso used to check the blocks of a chain (default one per CPU)\n");
+    printf("\t--checkpoint S\tSave the search progress to FILE every S seconds (0 to only save it\n");
+    printf("\t\t\ton SIGINT or SIGTERM, default %d)\n", checkpoint_interval);
+    printf("\t--stats FILE\tRewrite FILE every second with the progress in the Prometheus text format\n");
+    printf("\t\t\tThe progress is also printed on SIGUSR1\n");
+    printf("\t--coordinator ADDRESS\tLease the nonces to the hcb --worker processes connecting to\n");
+    printf("\t\t\tADDRESS instead of searching them (unix:PATH or HOST:PORT)\n");
+    printf("\t--lease N\tNonces leased at once to a worker (default %llu)\n", lease_size);
+    printf("\t--lease-timeout S\tSeconds without news from a worker before its lease is given to\n");
+    printf("\t\t\tanother one (default %d)\n", lease_timeout);
+    printf("\t--full\t\tVerify every block of the chain continued instead of the ones following the\n");
+    printf("\t\t\tblocks recorded in FILE.verified by a previous check\n");
+    printf("\t--cached\tLet --check skip the blocks recorded in FILE.verified, and record them\n");
+    printf("\t\t\t(only for the chains of this host, the file is not protected against a forgery)\n");
+    printf("\t--hash NAME\tHash algorithm of a new chain, named by its header (default sha256, HCB 1.0)\n");
+    printf("\t\t\tAvailable algorithms:");
+    for (int i = 0; hash_algorithms[i] != NULL; i++) {
+        printf(" %s", hash_algorithms[i]->name);
+    }
+    printf("\n");
+    printf("\t--memory SIZE\tMake a new chain memory-hard (HCB 1.2), each level filling a scratchpad of SIZE\n");
+    printf("\t\t\tKiB (or MiB, GiB with an M, G suffix) that every nonce reads %d times at random\n", SCRATCHPAD_ROUNDS);
+    printf("\t--background\tSearch at the idle priority (SCHED_IDLE, or nice 19), pausing the threads\n");
+    printf("\t\t\tso the load of the host with the other processes stays under --max-load\n");
+    printf("\t--cpu-share PERCENT\tUse at most PERCENT of the CPUs available to the process (its\n");
+    printf("\t\t\tcgroup quota, or the CPUs it may run on), implies --background\n");
+    printf("\t--max-load PERCENT\tLoad of the host a background search backs off from (default %.0f)\n", max_load * 100);
+    printf("\t--powercap DIR\tRead the energy of the processor packages from the RAPL zones of the\n");
+    printf("\t\t\tpowercap tree DIR (default %s) and record the joules of each level\n", ENERGY_POWERCAP_ROOT);
+    printf("\t--report FORMAT\tFormat of the report of --check-all: json (one object per line, default) or csv\n");
+    printf("\t--kernel NAME\tForce the SHA-256 kernel used to search nonces (default %s)\n", sha256_kernel_best()->name);
+    printf("\t\t\tAvailable kernels (used by the SHA-256 chains):");
+    for (int i = 0; sha256_kernels[i] != NULL; i++) {
+        printf(" %s%s", sha256_kernels[i]->name, sha256_kernels[i]->supported() ? "" : " (unsupported)");
+    }
+    printf("\n\n");
 }
 
-// Function called on program exit
-void exit_handler(int _) {
-    fprintf(out_fp, "#nonce:%lld\n", counter);
-    fflush(out_fp);
-    exit(0);
+// Print the warnings of the library
+static void print_warning(const char* message, void* data) {
+    (void)data;
+    printf("%s\n", message);
 }
 
-// Generate a chain from a message and a difficulty
-void generate_chain(char* text, char* path, int difficulty, bool continue_mode) {
+// Thread following the search: it measures the hash rate every second, rewrites the statistics
+// file, saves the progress periodically, cancels the search on SIGINT or SIGTERM, and prints the
+// statistics on SIGUSR1
+// The signals are blocked in every other thread, so nothing runs in a signal handler
+static void* monitor_thread(void* signals) {
+
+    struct timespec tick = {1, 0};
+    int elapsed = 0;
 
-    // Check the start message
-    for (int i = 0; i < strlen(text); i++) {
-        if (text[i] == '\r' || text[i] == '\n') {
-            printf("Error: Start message must be over one single line\n\n");
-            exit(13);
+    while (1) {
+
+        int received = sigtimedwait(signals, NULL, &tick);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+
+        // Reading the energy every second also keeps up with the wraps of the counters
+        double joules = energy != NULL ? energy_read(energy) : -1;
+        if (batch == NULL) {
+            stats_sample(hcb_builder_position(builder), joules);
+        }
+        if (received == SIGUSR1) {
+            if (batch == NULL) {
+                stats_print(stderr);
+            }
+            for (int i = 0; batch != NULL && i < builder_count; i++) {
+                char position[NONCE_DIGITS + 1];
+                nonce_format(hcb_builder_position(builders[i]), 0, position);
+                fprintf(stderr, "%s: level %d, searching from nonce %s\n", builder_paths[i], hcb_builder_level(builders[i]), position);
+            }
+            continue;
+        }
+
+        // The main thread saves the progress once the search is stopped
+        if (received >= 0) {
+            if (batch != NULL) {
+                hcb_batch_cancel(batch);
+            } else if (coordinator != NULL) {
+                hcb_coordinator_cancel(coordinator);
+            } else {
+                hcb_builder_cancel(builder);
+            }
+            return NULL;
+        }
+
+        // One more second elapsed
+        if (stats_path != NULL && stats_write(stats_path, search_get_kernel(hcb_builder_search(builder))->name) != 0) {
+            fprintf(stderr, "Warning: Unable to write the statistics file \"%s\"\n", stats_path);
+            stats_path = NULL;
+        }
+        if (checkpoint_interval == 0 || ++elapsed < checkpoint_interval) {
+            continue;
+        }
+        elapsed = 0;
+        for (int i = 0; i < builder_count; i++) {
+            hcb_builder_checkpoint(builders[i], NULL);
         }
-    }
 
-    // Open file
-    out_fp = fopen(path, continue_mode ? "a" : "w");
-    if (out_fp == NULL) {
-        printf("Error: Unable to open file \"%s\"\n\n", path);
-        exit(11);
     }
 
-    // Register exit function
-    signal(SIGINT, exit_handler);
+}
 
-    // Create a SHA256 context
-    SHA256_CTX ctx;
+// Start following the search
+static void start_monitor() {
 
-    // The message that will be hashed
-    // It must have the size of max(len of sha256 hash, len(text)) + len(nonce) + 2
-    // The +2 is for the line break "\n" and the "\0"
-    char* message = malloc(((strlen(text) > sha256_hex_length ? strlen(text) : sha256_hex_length) + nonce_length + 2) * sizeof(char));
+    static sigset_t signals;
+    pthread_t thread;
 
-    // The nonce is the padded string representation of counter
-    char* nonce = malloc((nonce_length + 1) * sizeof(char));
+    // Block the signals before any search thread is created so they inherit the mask
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
 
-    // The previous hash
-    char* prev_hash = malloc(((strlen(text) > sha256_hex_length ? strlen(text) : sha256_hex_length) + 1) * sizeof(char));
+    if (pthread_create(&thread, NULL, monitor_thread, &signals) != 0) {
+        printf("Error: Unable to create the monitor thread\n\n");
+        exit(17);
+    }
+    pthread_detach(thread);
 
-    // By default the previous hash is the original text
-    strcpy(prev_hash, text);
+}
 
-    // The hash
-    BYTE hash[SHA256_BLOCK_SIZE];
+// Generate the blocks of the chain until the search is cancelled, never returns
+static void generate_chain() {
 
-    // Difficulty as a string
-    char* difficulty_str = malloc((nonce_length + 1) * sizeof(char));
+    hcb_error error;
+    hcb_block block;
 
-    // String used in sprintf to format the nonce
-    char* nonce_format = malloc(10 * sizeof(char));
-    sprintf(nonce_format, "%%0%dlld", nonce_length);
+    // The search is single threaded unless asked otherwise
+    if (threads < 0) {
+        search_set_threads(hcb_builder_search(builder), 1);
+    }
 
-    // Print the start of the chain
-    if (!continue_mode) {
-        fprintf(out_fp, "# File generated by C-HCB\n%s\n%s\n", padding_right("HCB 1.0 ", nonce_length, '-'), text);
+    // The nonces are searched by the workers
+    if (coordinator_address != NULL && hcb_coordinator_create(&coordinator, builder, coordinator_address, lease_size, lease_timeout, &error) != HCB_OK) {
+        printf("%s\n\n", error.message);
+        exit(error.status);
     }
 
-    // Iter over difficulty
+    // Save and measure the progress from now on
+    start_monitor();
+
     while (1) {
 
-        // Iter over counter
-        do {
+        stats_level_start(hcb_builder_level(builder), hcb_builder_position(builder), energy != NULL ? energy_read(energy) : -1);
+        hcb_status status = coordinator != NULL ? hcb_coordinator_next(coordinator, &block, &error) : hcb_builder_next(builder, &block, &error);
+        if (status == HCB_CANCELLED) {
+            // Save the progress before exiting
+            if (hcb_builder_checkpoint(builder, &error) != HCB_OK) {
+                printf("%s\n\n", error.message);
+                exit(error.status);
+            }
+            hcb_coordinator_close(coordinator);
+            hcb_builder_close(builder);
+            exit(0);
+        }
+        if (status != HCB_OK) {
+            printf("%s\n\n", error.message);
+            exit(status);
+        }
+        stats_level_done();
 
-            // Prepare the message
-            strcpy(message, prev_hash);
-            strcat(message, "\n");
-            sprintf(nonce, nonce_format, counter);
-            strcat(message, nonce);
+    }
 
-            // Compute its hash
-            sha256_init(&ctx);
-            sha256_update(&ctx, message, strlen(message));
-            sha256_final(&ctx, hash);
+}
 
-            // Increment counter
-            counter++;
+// Generate the blocks of the chains of the batch until it is cancelled, never returns
+static void generate_batch(const hcb_options* options) {
 
-        } while(numberOfZero(hash, SHA256_BLOCK_SIZE) != difficulty);
+    hcb_error error;
 
-        // Saves the current hash
-        strcpy(prev_hash, byteToHex(hash, SHA256_BLOCK_SIZE));
+    if (hcb_batch_create(&batch, builders, builder_count, options, &error) != HCB_OK) {
+        printf("%s\n\n", error.message);
+        exit(error.status);
+    }
 
-        // Print the previous hash, the found nonce and the block separators
-        sprintf(difficulty_str, "%d", difficulty);
-        strcat(difficulty_str, " ");
-        fprintf(out_fp, "%s\n%s\n%s\n", nonce, padding_right(difficulty_str, nonce_length, '-'), prev_hash);
-        fflush(out_fp);
+    // Save the progress from now on
+    start_monitor();
 
-        // Reset the counter and increment difficulty
-        counter = 0;
-        difficulty++;
+    hcb_status status = hcb_batch_run(batch, NULL, NULL, &error);
+    if (status != HCB_CANCELLED) {
+        printf("%s\n\n", error.message);
+        exit(status);
+    }
 
+    // Save the progress of every chain before exiting
+    for (int i = 0; i < builder_count; i++) {
+        if (hcb_builder_checkpoint(builders[i], &error) != HCB_OK) {
+            printf("%s\n\n", error.message);
+            exit(error.status);
+        }
+        hcb_builder_close(builders[i]);
     }
+    hcb_batch_close(batch);
+    exit(0);
 
 }
 
-// Check a chain stored in a file
-BYTE* check_chain(char* path, bool check_for_continue) {
+// Open the chains listed in a manifest, one "FILE MESSAGE" per line: an existing FILE is
+// continued, otherwise it is started with MESSAGE
+// Empty lines and lines starting with # are ignored
+static void open_manifest(const char* path, const hcb_options* options) {
 
-    // Prepare reading variables
-    FILE * fp;
-    char * line = NULL;
-    size_t len = 0;
-    int current_line = 1; // The current line number in the chain (comments are ignored)
-    int real_line = 0; // The current line number in the file (every line is counted)
+    hcb_error error;
+    char* line = NULL;
+    size_t size = 0;
+    ssize_t length;
+    int line_number = 0;
 
-    // Open file
-    fp = fopen(path, "r");
+    FILE* fp = fopen(path, "r");
     if (fp == NULL) {
         printf("Error: Unable to open file \"%s\"\n\n", path);
-        exit(4);
-    }
-    
-    // Variables used in the loop
-    char* expected_first_line = padding_right("HCB 1.0 ", nonce_length, '-');
-    char* message; // Initialized when we'll know the length of the first message
-    char* new_hash = malloc((sha256_hex_length + 1) * sizeof(char));
-
-    // Create a SHA256 context
-    SHA256_CTX ctx;
-
-    // The hash
-    static BYTE hash[SHA256_BLOCK_SIZE];
-
-    // Read file line by line and check the content
-    char* last_hash = malloc((nonce_length + 1) * sizeof(char));
-    char* last_nonce = malloc((nonce_length + 1) * sizeof(char));
-    char* saved_content;
-    char* nonce_prefix = "#nonce:";
-    if (check_for_continue) {
-        // Get file size
-        fseek(fp, 0L, SEEK_END);
-        int size = ftell(fp);
-        rewind(fp);
-        // Allocate a string that can handle the entire file
-        saved_content = malloc((size + 1) * sizeof(char));
-        saved_content[0] = '\0';
-    }
-    while (getline(&line, &len, fp) != -1) {
-
-        real_line++;
-
-        // Remove final line break
-        int len = strlen(line);
-        if (line[len-1] == '\n') {
-            len--;
-            line[len] = '\0';
-        }
-        if (line[len-1] == '\r') {
-            len--;
-            line[len] = '\0';
-        }
-
-        // Check if line is a comment
-        if (len >= 1 && line[0] == '#') {
-            // If continue mode, save the line
-            if (check_for_continue) {
-                strcat(saved_content, line);
-                strcat(saved_content, "\n");
-            }
-            // Search for a nonce to resume to
-            if (strncmp(nonce_prefix, line, strlen(nonce_prefix)) == 0) {
-                char* string_nonce = &line[strlen(nonce_prefix)];
-                char* end_ptr;
-                counter = strtoull(string_nonce, &end_ptr, 10);
-                if (string_nonce == end_ptr) {
-                    printf("Warning: incorrect decimal nonce value \"%s\" in file \"%s\" on line #%d\n", string_nonce, path, real_line);
-                    counter = 0;
-                }
-            }
+        exit(32);
+    }
+    builders = NULL;
+    builder_count = 0;
+    while ((length = getline(&line, &size, fp)) >= 0) {
+
+        line_number++;
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+            line[--length] = '\0';
+        }
+        if (length == 0 || line[0] == '#') {
             continue;
         }
 
-        // Save line if in continue mode
-        if (check_for_continue && len > 0) {
-            strcat(saved_content, line);
-            strcat(saved_content, "\n");
+        // The message follows the first space
+        char* message = strchr(line, ' ');
+        if (message != NULL) {
+            *message++ = '\0';
+        }
+        if (access(line, F_OK) != 0 && message == NULL) {
+            printf("Error: Missing MESSAGE for the new chain \"%s\" on line #%d of \"%s\"\n\n", line, line_number, path);
+            exit(32);
         }
-        
-        // Check if first line is correct
-        if (current_line == 1 && strcmp(line, expected_first_line) != 0) {
 
-            printf("Error while checking \"%s\": First line expected \"%s\" but got \"%s\" on line #%d\n\n", path, expected_first_line, line, real_line);
-            exit(5);
+        builders = realloc(builders, (builder_count + 1) * sizeof(hcb_builder*));
+        builder_paths = realloc(builder_paths, (builder_count + 1) * sizeof(char*));
+        if (builders == NULL || builder_paths == NULL || (builder_paths[builder_count] = strdup(line)) == NULL) {
+            printf("Error: Out of memory\n\n");
+            exit(HCB_ERROR_MEMORY);
+        }
+        hcb_status status = access(line, F_OK) == 0 ?
+            hcb_builder_continue(&builders[builder_count], line, options, NULL, &error) :
+            hcb_builder_create(&builders[builder_count], line, message, options, &error);
+        if (status != HCB_OK) {
+            printf("%s\n\n", error.message);
+            exit(status);
+        }
+        builder_count++;
 
-        } else if (current_line == 2) {
+    }
+    free(line);
+    fclose(fp);
 
-            // Get the first message
-            strcpy(last_hash, line);
+    if (builder_count == 0) {
+        printf("Error: No chain in \"%s\"\n\n", path);
+        exit(32);
+    }
 
-            // Init the message variable used to compute the hashes
-            message = malloc(((strlen(line) > sha256_hex_length ? strlen(line) : sha256_hex_length) + nonce_length + 2) * sizeof(char));
+}
 
-        } else if (current_line % 3 == 0) {
+// Thread cancelling the worker on SIGINT or SIGTERM, the worker then returns its lease
+static void* worker_signal_thread(void* worker) {
+    static sigset_t signals;
+    int received;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    while (sigwait(&signals, &received) != 0);
+    hcb_worker_cancel(worker);
+    return NULL;
+}
 
-            // Get a nonce
+// Search the nonces leased by a coordinator until it disconnects, never returns
+static void run_worker(const char* address, hcb_options* options) {
 
-            // Check the nonce lenght
-            if (strlen(line) != nonce_length) {
-                printf("Error while checking \"%s\": Nonce line #%d must be %d characters long\n\n", path, real_line, nonce_length);
-                exit(15);
-            }
+    hcb_error error;
+    hcb_worker* worker;
+    sigset_t signals;
+    pthread_t thread;
 
-            // Check if the nonce is only numeric
-            for (int i = 0; i < strlen(line); i++) {
-                if (line[i] < '0' || line[i] > '9') {
-                    printf("Error while checking \"%s\": Nonce line #%d must be only numeric but got \"%s\"\n\n", path, real_line, line);
-                    exit(14);
-                }
-            }
+    // The search is single threaded unless asked otherwise
+    if (threads < 0) {
+        options->threads = 1;
+    }
+    if (hcb_worker_create(&worker, address, options, &error) != HCB_OK) {
+        printf("%s\n\n", error.message);
+        exit(error.status);
+    }
 
-            // Save the nonce
-            strcpy(last_nonce, line);
+    // Block the signals before any search thread is created so they inherit the mask
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    if (pthread_create(&thread, NULL, worker_signal_thread, worker) != 0) {
+        printf("Error: Unable to create the monitor thread\n\n");
+        exit(17);
+    }
+    pthread_detach(thread);
 
-        } else if (current_line != 1 && current_line % 3 == 1) {
+    hcb_status status = hcb_worker_run(worker, &error);
+    if (status != HCB_OK && status != HCB_CANCELLED) {
+        printf("%s\n\n", error.message);
+        exit(status);
+    }
+    hcb_worker_close(worker);
+    exit(0);
 
-            // Block separator, check if integer is correct
-            char* expected_line = malloc((nonce_length + 1) * sizeof(char));
-            sprintf(expected_line, "%d ", (current_line - 1) / 3 - 1);
-            expected_line = padding_right(expected_line, nonce_length, '-');
+}
 
-            if (strcmp(line, expected_line) != 0) {
-                printf("Error while checking \"%s\": Separator line #%d expected \"%s\" but got \"%s\"\n\n", path, real_line, expected_line, line);
-                exit(6);
-            }
+// Print a configuration measured by --autotune
+static void print_measure(const hcb_profile* measured, void* data) {
+    (void)data;
+    printf("%-8s %4d threads %-8s %14.0f h/s\n", measured->kernel->name, measured->threads, measured->pinned ? "pinned" : "", measured->hash_rate);
+    fflush(stdout);
+}
 
-        } else if (current_line % 3 == 2) {
+// Measure the search configurations on this host and save the fastest, returns the exit code
+static int autotune() {
 
-            // Line representing a hash
+    hcb_error error;
+    hcb_profile profile;
+    char host[512];
+    char path[4096];
 
-            // Check the hash lenght
-            if (strlen(line) != sha256_hex_length) {
-                printf("Error while checking \"%s\": Hash line #%d must be %d characters long\n\n", path, real_line, sha256_hex_length);
-                exit(16);
-            }
+    if (!hcb_profile_path(path, sizeof(path))) {
+        printf("Error: Neither XDG_CACHE_HOME nor HOME is set, the profile cannot be saved\n\n");
+        return 35;
+    }
+    hcb_profile_host(host, sizeof(host));
+    printf("Tuning the search on %s\n", host);
+    if (hcb_autotune(&profile, HCB_TUNE_SECONDS, print_measure, NULL, &error) != HCB_OK || hcb_profile_save(path, &profile, &error) != HCB_OK) {
+        printf("%s\n\n", error.message);
+        return error.status;
+    }
+    printf("Fastest: kernel %s, %d threads%s, %.0f h/s, saved to \"%s\"\n\n", profile.kernel->name, profile.threads, profile.pinned ? " pinned" : "", profile.hash_rate, path);
+    return 0;
 
-            // First we hash the previous hash and nonce and compare it to the read hash
-            sprintf(message, "%s\n%s", last_hash, last_nonce);
-            sha256_init(&ctx);
-            sha256_update(&ctx, message, strlen(message));
-            sha256_final(&ctx, hash);
-            new_hash = byteToHex(hash, SHA256_BLOCK_SIZE);
-
-            // Compare it
-            if (strcmp(line, new_hash) != 0) {
-                printf("Error while checking \"%s\": Hash line #%d expected \"%s\" but got \"%s\"\n\n", path, current_line, new_hash, line);
-                exit(7);
-            }
+}
 
-            // Check the difficulty
-            int difficulty = numberOfZero(hash, SHA256_BLOCK_SIZE);
-            int expected_difficulty = (current_line - 2) / 3 - 1;
-            if (difficulty != expected_difficulty) {
-                printf("Error while checking \"%s\": Hash line #%d (\"%s\") expected difficulty \"%d\" but got \"%d\"\n\n", path, real_line, line, expected_difficulty, difficulty);
-                exit(8);
+// Search with the profile saved by --autotune for this host, unless --threads or --kernel is given
+static void use_profile(hcb_options* options) {
+    hcb_profile profile;
+    char path[4096];
+    if (threads >= 0 || options->kernel != NULL || !hcb_profile_path(path, sizeof(path)) || !hcb_profile_load(path, &profile)) {
+        return;
+    }
+    threads = profile.threads;
+    options->threads = profile.threads;
+    options->kernel = profile.kernel;
+    options->pinned = profile.pinned;
+    fprintf(stderr, "Using the tuned profile of this host: kernel %s, %d threads%s\n", profile.kernel->name, profile.threads, profile.pinned ? " pinned" : "");
+}
+
+// Add a path to the chains checked by --check-all
+static void add_chain(char*** paths, int* count, const char* path) {
+    *paths = realloc(*paths, (*count + 1) * sizeof(char*));
+    if (*paths == NULL || ((*paths)[*count] = strdup(path)) == NULL) {
+        printf("Error: Out of memory\n\n");
+        exit(HCB_ERROR_MEMORY);
+    }
+    (*count)++;
+}
+
+static int compare_paths(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// Paths of the chains of a source of --check-all: the files of a directory in the order of
+// their names, but the hidden ones and the caches of the checks, or the paths listed in a file
+// (one per line, empty lines and lines starting with # are ignored), - being the standard input
+static char** read_source(const char* source, int* count) {
+
+    char** paths = NULL;
+    struct stat st;
+    *count = 0;
+
+    DIR* dir = opendir(source);
+    if (dir != NULL) {
+        struct dirent* entry;
+        size_t source_length = strlen(source);
+        while ((entry = readdir(dir)) != NULL) {
+            size_t length = strlen(entry->d_name);
+            if (entry->d_name[0] == '.' || (length > 9 && strcmp(entry->d_name + length - 9, ".verified") == 0) ||
+                (length > 4 && strcmp(entry->d_name + length - 4, ".tmp") == 0)) {
+                continue;
+            }
+            char* path = malloc(source_length + length + 2);
+            if (path == NULL) {
+                printf("Error: Out of memory\n\n");
+                exit(HCB_ERROR_MEMORY);
+            }
+            sprintf(path, "%s/%s", source, entry->d_name);
+            if (stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
+                add_chain(&paths, count, path);
             }
+            free(path);
+        }
+        closedir(dir);
+        if (*count > 0) {
+            qsort(paths, *count, sizeof(char*), compare_paths);
+        }
+        return paths;
+    }
 
-            // Saves the hash
-            strcpy(last_hash, new_hash);
+    char* line = NULL;
+    size_t size = 0;
+    ssize_t length;
+    FILE* fp = strcmp(source, "-") == 0 ? stdin : fopen(source, "r");
+    if (fp == NULL) {
+        printf("Error: Unable to open \"%s\"\n\n", source);
+        exit(37);
+    }
+    while ((length = getline(&line, &size, fp)) >= 0) {
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+            line[--length] = '\0';
+        }
+        if (length > 0 && line[0] != '#') {
+            add_chain(&paths, count, line);
+        }
+    }
+    free(line);
+    if (fp != stdin) {
+        fclose(fp);
+    }
+    return paths;
 
+}
+
+// Print a string of the report, quoted for JSON or CSV
+static void print_field(const char* text) {
+    putchar('"');
+    for (; *text != '\0'; text++) {
+        if (report_csv) {
+            printf(*text == '"' ? "\"\"" : "%c", *text);
+        } else if (*text == '"' || *text == '\\') {
+            printf("\\%c", *text);
+        } else if ((unsigned char)*text < 0x20) {
+            printf("\\u%04x", *text);
+        } else {
+            putchar(*text);
         }
+    }
+    putchar('"');
+}
 
-        current_line++;
+// Chains of --check-all and their results, ranked by sort_results
+static char** check_paths;
+static hcb_bulk_result* check_results;
 
+// Most valid blocks first, a valid chain before an invalid one of the same length, then by path
+static int compare_results(const void* a, const void* b) {
+    const hcb_bulk_result* first = &check_results[*(const int*)a];
+    const hcb_bulk_result* second = &check_results[*(const int*)b];
+    if (first->info.blocks != second->info.blocks) {
+        return first->info.blocks > second->info.blocks ? -1 : 1;
     }
+    if ((first->error.status == HCB_OK) != (second->error.status == HCB_OK)) {
+        return first->error.status == HCB_OK ? -1 : 1;
+    }
+    return strcmp(check_paths[*(const int*)a], check_paths[*(const int*)b]);
+}
+
+// Check the chains of a source with one pool of threads and print the leaderboard, returns the
+// exit code: 0 if every chain is valid
+static int check_all(const char* source, const hcb_options* options) {
 
-    // Last line must be a hash or a nonce
-    if (current_line % 3 != 0) {
-        printf("Error while checking \"%s\": File must end with a hash\n\n", path);
-        exit(9);
+    hcb_error error;
+    int count;
+    int invalid = 0;
+    long long unsigned int blocks = 0;
+
+    check_paths = read_source(source, &count);
+    if (count == 0) {
+        printf("Error: No chain in \"%s\"\n\n", source);
+        return 37;
+    }
+    check_results = calloc(count, sizeof(hcb_bulk_result));
+    int* ranking = malloc(count * sizeof(int));
+    if (check_results == NULL || ranking == NULL) {
+        printf("Error: Out of memory\n\n");
+        return HCB_ERROR_MEMORY;
     }
 
-    // Free memory
-    fclose(fp);
-    if (line) {
-        free(line);
+    // Every chain is checked before the ranking is known
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (hcb_bulk_check((const char* const*)check_paths, count, options, check_results, NULL, NULL, &error) != HCB_OK) {
+        printf("%s\n\n", error.message);
+        return error.status;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    for (int i = 0; i < count; i++) {
+        ranking[i] = i;
     }
+    qsort(ranking, count, sizeof(int), compare_results);
 
-    // Print success or file content
-    if (!check_for_continue) {
-        printf("HCB file is valid.\n\n");
-        fflush(stdout);
-    } else {
-        // Remove last line break
-        int len = strlen(saved_content);
-        if (saved_content[len-1] == '\n') {
-            saved_content[len-1] = '\0';
+    // The chains of the same length share their rank
+    if (report_csv) {
+        printf("rank,file,valid,blocks,tip,status,error,seconds\n");
+    }
+    int rank = 0;
+    for (int i = 0; i < count; i++) {
+        const hcb_bulk_result* result = &check_results[ranking[i]];
+        char tip[SHA256_BLOCK_SIZE * 2 + 1] = "";
+        if (i == 0 || result->info.blocks != check_results[ranking[i - 1]].info.blocks) {
+            rank = i + 1;
         }
-        // Open file for writing
-        out_fp = fopen(path, "w");
-        if (out_fp == NULL) {
-            printf("Error: Unable to open file \"%s\"\n\n", path);
-            exit(12);
+        if (result->info.blocks > 0) {
+            byteToHex(result->info.last_hash, SHA256_BLOCK_SIZE, tip);
+        }
+        bool valid = result->error.status == HCB_OK;
+        invalid += valid ? 0 : 1;
+        blocks += result->info.blocks;
+        if (report_csv) {
+            printf("%d,", rank);
+            print_field(check_paths[ranking[i]]);
+            printf(",%s,%d,%s,%d,", valid ? "true" : "false", result->info.blocks, tip, result->error.status);
+            print_field(result->error.message);
+            printf(",%.6f\n", result->seconds);
+        } else {
+            printf("{\"rank\": %d, \"file\": ", rank);
+            print_field(check_paths[ranking[i]]);
+            printf(", \"valid\": %s, \"blocks\": %d, \"tip\": \"%s\", \"status\": %d, \"error\": ", valid ? "true" : "false", result->info.blocks, tip, result->error.status);
+            print_field(result->error.message);
+            printf(", \"seconds\": %.6f}\n", result->seconds);
         }
-        // Saves
-        fprintf(out_fp, "%s\n", saved_content);
-        fflush(out_fp);
-        // Close file
-        fclose(out_fp);
     }
+    fflush(stdout);
+    fprintf(stderr, "%d chains checked, %d invalid, %llu valid blocks in %.3f s\n", count, invalid, blocks,
+        end.tv_sec - start.tv_sec + (end.tv_nsec - start.tv_nsec) / 1e9);
 
-    // Return the last hash if we need to continue
-    return hash;
+    for (int i = 0; i < count; i++) {
+        free(check_paths[i]);
+    }
+    free(check_paths);
+    free(check_results);
+    free(ranking);
+    return invalid == 0 ? 0 : 36;
 
 }
 
+// Whether the argument is a command rather than an option
+static bool is_command(const char* arg) {
+    static const char* commands[] = {"--continue", "--check", "--worker", "--batch", "--to-binary", "--to-text", "--autotune", "--check-all", NULL};
+    for (int i = 0; commands[i] != NULL; i++) {
+        if (strcmp(arg, commands[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 // Main function
 int main(int argc, char** argv) {
 
+    hcb_options options;
+    hcb_error error;
+    hcb_options_init(&options);
+    options.warning = print_warning;
+
+    // Read the options preceding the command
+    int arg = 1;
+    while (arg < argc && strncmp(argv[arg], "--", 2) == 0 && strcmp(argv[arg], "--") != 0 && !is_command(argv[arg])) {
+
+        if (strcmp(argv[arg], "--threads") == 0) {
+
+            char* end_ptr = NULL;
+            long value = arg + 1 < argc ? strtol(argv[arg + 1], &end_ptr, 10) : -1;
+            if (end_ptr == NULL || end_ptr == argv[arg + 1] || *end_ptr != '\0' || value < 0) {
+                printf("Error: --threads expects a positive or zero integer\n\n");
+                printUsage();
+                return 18;
+            }
+            threads = (int)value;
+            options.threads = threads;
+            arg += 2;
+
+        } else if (strcmp(argv[arg], "--checkpoint") == 0) {
+
+            char* end_ptr = NULL;
+            long value = arg + 1 < argc ? strtol(argv[arg + 1], &end_ptr, 10) : -1;
+            if (end_ptr == NULL || end_ptr == argv[arg + 1] || *end_ptr != '\0' || value < 0) {
+                printf("Error: --checkpoint expects a positive or zero number of seconds\n\n");
+                printUsage();
+                return 22;
+            }
+            checkpoint_interval = (int)value;
+            arg += 2;
+
+        } else if (strcmp(argv[arg], "--stats") == 0) {
+
+            if (arg + 1 >= argc) {
+                printf("Error: --stats expects a FILE\n\n");
+                printUsage();
+                return 23;
+            }
+            stats_path = argv[arg + 1];
+            arg += 2;
+
+        } else if (strcmp(argv[arg], "--coordinator") == 0) {
+
+            if (arg + 1 >= argc) {
+                printf("Error: --coordinator expects an ADDRESS\n\n");
+                printUsage();
+                return 28;
+            }
+            coordinator_address = argv[arg + 1];
+            arg += 2;
+
+        } else if (strcmp(argv[arg], "--lease") == 0) {
+
+            char* end_ptr = NULL;
+            long long value = arg + 1 < argc ? strtoll(argv[arg + 1], &end_ptr, 10) : -1;
+            if (end_ptr == NULL || end_ptr == argv[arg + 1] || *end_ptr != '\0' || value <= 0) {
+                printf("Error: --lease expects a positive number of nonces\n\n");
+                printUsage();
+                return 29;
+            }
+            lease_size = (long long unsigned int)value;
+            arg += 2;
+
+        } else if (strcmp(argv[arg], "--lease-timeout") == 0) {
+
+            char* end_ptr = NULL;
+            long value = arg + 1 < argc ? strtol(argv[arg + 1], &end_ptr, 10) : -1;
+            if (end_ptr == NULL || end_ptr == argv[arg + 1] || *end_ptr != '\0' || value <= 0) {
+                printf("Error: --lease-timeout expects a positive number of seconds\n\n");
+                printUsage();
+                return 30;
+            }
+            lease_timeout = (int)value;
+            arg += 2;
+
+        } else if (strcmp(argv[arg], "--full") == 0) {
+
+            full = true;
+            arg++;
+
+        } else if (strcmp(argv[arg], "--cached") == 0) {
+
+            cached = true;
+            arg++;
+
+        } else if (strcmp(argv[arg], "--hash") == 0) {
+
+            const HASH_ALGORITHM* hash = arg + 1 < argc ? hash_algorithm_find(argv[arg + 1]) : NULL;
+            if (hash == NULL) {
+                printf("Error: --hash expects one of the algorithms listed below\n\n");
+                printUsage();
+                return 39;
+            }
+            options.hash = hash;
+            arg += 2;
+
+        } else if (strcmp(argv[arg], "--memory") == 0) {
+
+            // KiB, or MiB and GiB with an M or G suffix
+            char* end_ptr = NULL;
+            long long value = arg + 1 < argc ? strtoll(argv[arg + 1], &end_ptr, 10) : -1;
+            if (end_ptr != NULL && end_ptr != argv[arg + 1] && (strcmp(end_ptr, "M") == 0 || strcmp(end_ptr, "G") == 0) && value <= SCRATCHPAD_MAX_SIZE) {
+                value <<= *end_ptr == 'M' ? 10 : 20;
+                end_ptr++;
+            }
+            if (end_ptr == NULL || end_ptr == argv[arg + 1] || (*end_ptr != '\0' && strcmp(end_ptr, "K") != 0) || value < SCRATCHPAD_MIN_SIZE || value > SCRATCHPAD_MAX_SIZE) {
+                printf("Error: --memory expects a scratchpad size from %d KiB to %d GiB\n\n", SCRATCHPAD_MIN_SIZE, SCRATCHPAD_MAX_SIZE >> 20);
+                printUsage();
+                return 40;
+            }
+            options.memory = (size_t)value;
+            arg += 2;
+
+        } else if (strcmp(argv[arg], "--background") == 0) {
+
+            background = true;
+            arg++;
+
+        } else if (strcmp(argv[arg], "--cpu-share") == 0 || strcmp(argv[arg], "--max-load") == 0) {
+
+            char* end_ptr = NULL;
+            double value = arg + 1 < argc ? strtod(argv[arg + 1], &end_ptr) : -1;
+            if (end_ptr == NULL || end_ptr == argv[arg + 1] || *end_ptr != '\0' || value <= 0 || value > 100) {
+                printf("Error: %s expects a percentage above 0 and up to 100\n\n", argv[arg]);
+                printUsage();
+                return 41;
+            }
+            *(strcmp(argv[arg], "--cpu-share") == 0 ? &cpu_share : &max_load) = value / 100;
+            background = true;
+            arg += 2;
+
+        } else if (strcmp(argv[arg], "--powercap") == 0) {
+
+            if (arg + 1 >= argc) {
+                printf("Error: --powercap expects a DIR\n\n");
+                printUsage();
+                return 42;
+            }
+            powercap_root = argv[arg + 1];
+            arg += 2;
+
+        } else if (strcmp(argv[arg], "--report") == 0) {
+
+            if (arg + 1 >= argc || (strcmp(argv[arg + 1], "json") != 0 && strcmp(argv[arg + 1], "csv") != 0)) {
+                printf("Error: --report expects json or csv\n\n");
+                printUsage();
+                return 38;
+            }
+            report_csv = strcmp(argv[arg + 1], "csv") == 0;
+            arg += 2;
+
+        } else if (strcmp(argv[arg], "--kernel") == 0) {
+
+            const SHA256_KERNEL* kernel = arg + 1 < argc ? sha256_kernel_find(argv[arg + 1]) : NULL;
+            if (kernel == NULL) {
+                printf("Error: --kernel expects one of the kernels listed below\n\n");
+                printUsage();
+                return 20;
+            }
+            if (!kernel->supported()) {
+                printf("Error: Kernel \"%s\" is not supported by this CPU\n\n", kernel->name);
+                return 21;
+            }
+            options.kernel = kernel;
+            arg += 2;
+
+        } else {
+
+            printf("Error: Unknown option \"%s\"\n\n", argv[arg]);
+            printUsage();
+            return 19;
+
+        }
+
+    }
+
+    // Every thread created from now on inherits the idle priority
+    if (background) {
+        if (!throttle_set_idle()) {
+            printf("Warning: Unable to lower the priority of the search\n");
+        }
+        if ((options.throttle = throttle_create(cpu_share, max_load)) == NULL) {
+            printf("Error: Out of memory\n\n");
+            return HCB_ERROR_MEMORY;
+        }
+    }
+
+    // The energy is measured whenever the counters can be read, a tree asked for must be readable
+    energy = energy_open(powercap_root);
+    if (energy == NULL && powercap_root != NULL) {
+        printf("Error: No readable RAPL package zone in \"%s\"\n\n", powercap_root);
+        return 42;
+    }
+    options.energy = energy;
+
+    // "--" ends the options: MESSAGE FILE follow, even if the message starts with "--"
+    bool separator = arg < argc && strcmp(argv[arg], "--") == 0;
+    if (separator) {
+        arg++;
+    }
+
+    // Skip the options so the command starts at argv[1]
+    argc -= arg - 1;
+    argv += arg - 1;
+    const char* command = argc >= 2 && !separator ? argv[1] : "";
+
     // Check the parameters
     if (argc < 2) {
 
@@ -392,7 +867,7 @@ int main(int argc, char** argv) {
         printUsage();
         return 1;
 
-    } else if (strcmp(argv[1], "--continue") == 0) {
+    } else if (strcmp(command, "--continue") == 0) {
 
         if (argc < 3) {
             printf("Error: Missing FILE after --continue\n\n");
@@ -400,13 +875,16 @@ int main(int argc, char** argv) {
             return 2;
         }
 
-        // Read the input chain and check it (we won't continue an invalid one)
-        BYTE* hash = check_chain(argv[2], true);
-
-        // Continue the chain
-        generate_chain(byteToHex(hash, SHA256_BLOCK_SIZE), argv[2], numberOfZero(hash, SHA256_BLOCK_SIZE) + 1, true);
+        // Read the input chain and check it (we won't continue an invalid one), then continue it
+        use_profile(&options);
+        options.cache = !full;
+        if (hcb_builder_continue(&builder, argv[2], &options, NULL, &error) != HCB_OK) {
+            printf("%s\n\n", error.message);
+            return error.status;
+        }
+        generate_chain();
 
-    } else if (strcmp(argv[1], "--check") == 0) {
+    } else if (strcmp(command, "--check") == 0) {
 
         if (argc < 3) {
             printf("Error: Missing FILE after --check\n\n");
@@ -414,12 +892,81 @@ int main(int argc, char** argv) {
             return 3;
         }
 
-        // Read the input chain and check it
-        check_chain(argv[2], false);
+        // Read the input chain and check it, every block of it unless the cache is asked for
+        options.cache = cached && !full;
+        if (hcb_check(argv[2], &options, NULL, &error) != HCB_OK) {
+            printf("%s\n\n", error.message);
+            return error.status;
+        }
+        printf("HCB file is valid.\n\n");
 
         // Exit success
         exit(0);
 
+    } else if (strcmp(command, "--worker") == 0) {
+
+        if (argc < 3) {
+            printf("Error: Missing ADDRESS after --worker\n\n");
+            printUsage();
+            return 28;
+        }
+
+        // Search the nonces leased by the coordinator
+        use_profile(&options);
+        run_worker(argv[2], &options);
+
+    } else if (strcmp(command, "--to-binary") == 0 || strcmp(command, "--to-text") == 0) {
+
+        if (argc < 4) {
+            printf("Error: Missing files after %s\n\n", argv[1]);
+            printUsage();
+            return 34;
+        }
+
+        // Check the chain and convert it
+        hcb_status status = strcmp(argv[1], "--to-binary") == 0 ?
+            hcb_to_binary(argv[2], argv[3], &options, &error) :
+            hcb_to_text(argv[2], argv[3], &options, &error);
+        if (status != HCB_OK) {
+            printf("%s\n\n", error.message);
+            return error.status;
+        }
+        exit(0);
+
+    } else if (strcmp(command, "--autotune") == 0) {
+
+        return autotune();
+
+    } else if (strcmp(command, "--check-all") == 0) {
+
+        if (argc < 3) {
+            printf("Error: Missing SOURCE after --check-all\n\n");
+            printUsage();
+            return 37;
+        }
+
+        // Check the chains with one thread per CPU unless asked otherwise
+        return check_all(argv[2], &options);
+
+    } else if (strcmp(command, "--batch") == 0) {
+
+        if (argc < 3) {
+            printf("Error: Missing MANIFEST after --batch\n\n");
+            printUsage();
+            return 31;
+        }
+        if (coordinator_address != NULL || stats_path != NULL) {
+            printf("Error: --coordinator and --stats cannot be used with --batch\n\n");
+            printUsage();
+            return 33;
+        }
+
+        // Check or create the chains, then search them together
+        use_profile(&options);
+        options.cache = !full;
+        open_manifest(argv[2], &options);
+        generate_batch(&options);
+
     } else {
         
         if (argc < 3) {
@@ -429,7 +976,12 @@ int main(int argc, char** argv) {
         }
 
         // Generate a new chain with input string as start message
-        generate_chain(argv[1], argv[2], 0, false);
+        use_profile(&options);
+        if (hcb_builder_create(&builder, argv[2], argv[1], &options, &error) != HCB_OK) {
+            printf("%s\n\n", error.message);
+            return error.status;
+        }
+        generate_chain();
 
     }
 
@@ -0,0 +1,152 @@
+#ifndef HCB_H
+#define HCB_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include "sha256.h"
+#include "search.h"
+#include "energy.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Status returned by the library, the errors have the values of the exit codes of hcb
+typedef enum {
+    HCB_OK = 0,
+    HCB_ERROR_OPEN = 4,           // The chain could not be opened for reading
+    HCB_ERROR_FIRST_LINE = 5,     // The chain does not start with the HCB header
+    HCB_ERROR_SEPARATOR = 6,      // A block separator does not hold the block number
+    HCB_ERROR_HASH = 7,           // A hash is not the hash of the previous hash and the nonce
+    HCB_ERROR_DIFFICULTY = 8,     // A hash does not start with as many zero bits as its block number
+    HCB_ERROR_END = 9,            // The chain does not end with a hash
+    HCB_ERROR_CREATE = 11,        // The chain could not be opened for writing
+    HCB_ERROR_WRITE = 12,         // The chain could not be written
+    HCB_ERROR_MESSAGE = 13,       // The start message is over several lines
+    HCB_ERROR_NONCE = 14,         // A nonce is not numeric
+    HCB_ERROR_NONCE_LENGTH = 15,  // A nonce does not have the length of a hash
+    HCB_ERROR_HASH_LENGTH = 16,   // A hash line does not have the length of a hash
+    HCB_ERROR_MEMORY = 24,        // Out of memory
+    HCB_CANCELLED = 25,           // The operation was cancelled, this is not an error
+    HCB_ERROR_ADDRESS = 26,       // The coordinator address could not be listened to or connected to
+    HCB_ERROR_PROTOCOL = 27,      // The coordinator or a worker sent an unexpected message
+    HCB_ERROR_BLOCK = 43          // A block number is past the end of the chain
+} hcb_status;
+
+// Description of the status returned by a function
+typedef struct {
+    hcb_status status;
+    char message[512];            // What went wrong, as printed by hcb
+} hcb_error;
+
+// Options of a check or of a generation
+typedef struct {
+    int threads;                  // Threads verifying the blocks or searching the nonces, 0 for one per CPU
+    const SHA256_KERNEL* kernel;  // Kernel hashing the blocks, NULL for the fastest supported one
+    const HASH_ALGORITHM* hash;   // Hash algorithm of the new chains, NULL for SHA-256 (HCB 1.0)
+    size_t memory;                // Scratchpad size in KiB of the new memory-hard chains (HCB 1.2), 0 for regular ones
+    bool pinned;                  // Run each search thread on its own CPU
+    throttle_t* throttle;         // Paces the search threads in the background, NULL for full speed
+    energy_t* energy;             // Measures the energy of the levels searched by a builder, NULL for none
+
+    // Skip the blocks that FILE.verified records as verified by a previous check, and record the
+    // verified blocks in it, the file is trusted as long as the checksum of the prefix matches
+    // Only for the chains checked on this host, a received chain is checked without it
+    bool cache;
+
+    // Called with the warnings about the comments of a chain, which are ignored, may be NULL
+    void (*warning)(const char* message, void* data);
+    void* warning_data;
+} hcb_options;
+
+// What a check learned about a valid chain
+typedef struct {
+    int blocks;                           // Number of blocks
+    BYTE last_hash[SHA256_BLOCK_SIZE];    // Hash of the last block, zero if there is none
+    nonce_t resume;                       // Nonce to resume the search of the next block from
+    off_t nonce_lines;                    // Offset of the #nonce lines ending the file, -1 if none
+    const HASH_ALGORITHM* hash;           // Hash algorithm named by the header, NULL if unknown
+    size_t memory;                        // Scratchpad size in KiB of a memory-hard chain, 0 if regular
+} hcb_chain_info;
+
+// A block found by a builder
+typedef struct {
+    int level;
+    nonce_t nonce;
+    BYTE hash[SHA256_BLOCK_SIZE];
+    long long unsigned int attempts;      // Nonces tested by this builder to find it
+    double seconds;                       // Time spent by this builder to find it
+    double cpu_seconds;                   // CPU time spent by its search threads, negative if unknown
+    double joules;                        // Energy used by the packages meanwhile, negative if unknown
+} hcb_block;
+
+// Builds a chain in a file, block after block
+typedef struct hcb_builder hcb_builder;
+
+// Options with one thread per CPU and the fastest kernel
+void hcb_options_init(hcb_options* options);
+
+// First line of a text chain hashed with algorithm: "HCB 1.0" for SHA-256, "HCB 1.1 NAME" for the
+// others, "HCB 1.2 NAME SIZEKiB" for a memory-hard chain whose scratchpads have memory KiB (not 0),
+// padded with '-' to the length of a hash, line must hold SHA256_BLOCK_SIZE * 2 + 1 characters
+void hcb_header_line(const HASH_ALGORITHM* algorithm, size_t memory, char line[]);
+
+// Check the chain stored in the file at path, info may be NULL
+// On an error, info->blocks and info->last_hash describe the valid blocks preceding it
+hcb_status hcb_check(const char* path, const hcb_options* options, hcb_chain_info* info, hcb_error* error);
+
+// Start a new chain with the given start message in the file at path
+hcb_status hcb_builder_create(hcb_builder** builder, const char* path, const char* message, const hcb_options* options, hcb_error* error);
+
+// Continue the chain stored in the file at path, which is checked first, info may be NULL
+// The new blocks are appended to the file, which is never rewritten
+hcb_status hcb_builder_continue(hcb_builder** builder, const char* path, const hcb_options* options, hcb_chain_info* info, hcb_error* error);
+
+// Search the next block and append it to the chain, block may be NULL
+// Returns HCB_CANCELLED if hcb_builder_cancel was called, the chain can then be saved with
+// hcb_builder_checkpoint
+hcb_status hcb_builder_next(hcb_builder* builder, hcb_block* block, hcb_error* error);
+
+// Append the block of the current level whose nonce was found elsewhere, nonce must be the lowest
+// valid one, attempts and seconds are recorded in its #stats comment, block may be NULL
+// Returns HCB_ERROR_DIFFICULTY if the hash of the nonce does not have the difficulty of the level
+hcb_status hcb_builder_append(hcb_builder* builder, nonce_t nonce, long long unsigned int attempts, double seconds, hcb_block* block, hcb_error* error);
+
+// Append the nonce to resume the search from as a #nonce comment, and flush the file to the disk
+// The #nonce comments of a level are removed once its block is found
+// Can be called from any thread
+hcb_status hcb_builder_checkpoint(hcb_builder* builder, hcb_error* error);
+
+// Stop the running search and every following one
+// Can be called from any thread
+void hcb_builder_cancel(hcb_builder* builder);
+
+// Level whose block is being searched, or will be by the next call to hcb_builder_next
+int hcb_builder_level(const hcb_builder* builder);
+
+// Message of the block being searched: the start message or the hash of the last block
+const char* hcb_builder_message(const hcb_builder* builder);
+
+// Lowest nonce of the current level that has not been tested yet
+// Can be called from any thread
+nonce_t hcb_builder_position(const hcb_builder* builder);
+
+// Searcher used by the builder, to follow its progress or change its kernel
+search_t* hcb_builder_search(hcb_builder* builder);
+
+// Hash algorithm of the chain of the builder
+const HASH_ALGORITHM* hcb_builder_hash(const hcb_builder* builder);
+
+// Scratchpad size in KiB of the chain of the builder, 0 if it is not memory-hard
+size_t hcb_builder_memory(hcb_builder* builder);
+
+void hcb_builder_close(hcb_builder* builder);
+
+// Converts a byte array to an hexadecimal string, result must hold 2*len+1 characters
+void byteToHex(const BYTE array[], int len, char* result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   // HCB_H
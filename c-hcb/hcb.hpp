@@ -0,0 +1,219 @@
+#ifndef HCB_HPP
+#define HCB_HPP
+
+#include <functional>
+#include <string>
+#include <utility>
+#include "hcb.h"
+
+// C++ interface of libhcb, a thin header-only layer over hcb.h
+// Nothing is thrown: the functions return a Result holding either a value or an Error
+namespace hcb {
+
+// Error returned by the library, status is HCB_CANCELLED when a search was cancelled
+struct Error {
+    hcb_status status = HCB_OK;
+    std::string message;
+
+    Error() = default;
+    explicit Error(const hcb_error& error) : status(error.status), message(error.message) {}
+};
+
+// A value, or the error that prevented computing it
+template <typename T>
+class Result {
+public:
+    Result(T value) : value_(std::move(value)) {}
+    Result(Error error) : error_(std::move(error)) {}
+
+    bool ok() const { return error_.status == HCB_OK; }
+    explicit operator bool() const { return ok(); }
+    const Error& error() const { return error_; }
+    T& value() { return value_; }
+    const T& value() const { return value_; }
+    T* operator->() { return &value_; }
+    T& operator*() { return value_; }
+
+private:
+    T value_{};
+    Error error_;
+};
+
+// Result of the functions returning nothing
+struct Done {};
+
+// Options of a check or of a generation
+struct Options {
+    int threads = 0;                                      // 0 for one per CPU
+    const SHA256_KERNEL* kernel = nullptr;                // nullptr for the fastest supported one
+    const HASH_ALGORITHM* hash = nullptr;                 // Hash of a new chain, nullptr for SHA-256
+    size_t memory = 0;                                    // Scratchpad KiB of a new memory-hard chain, 0 for none
+    bool cache = false;                                   // Use and update the FILE.verified cache
+    bool pinned = false;                                  // Run each search thread on its own CPU
+    throttle_t* throttle = nullptr;                       // Paces the search threads, nullptr for full speed
+    energy_t* energy = nullptr;                           // Measures the joules of the levels, nullptr for none
+    std::function<void(const std::string&)> warning;      // Warnings about the comments of a chain
+
+    // Options of the C interface, valid as long as this object
+    hcb_options c_options() const {
+        hcb_options options;
+        hcb_options_init(&options);
+        options.threads = threads;
+        options.kernel = kernel;
+        options.hash = hash;
+        options.memory = memory;
+        options.cache = cache;
+        options.pinned = pinned;
+        options.throttle = throttle;
+        options.energy = energy;
+        if (warning) {
+            options.warning = [](const char* message, void* data) {
+                (*static_cast<const std::function<void(const std::string&)>*>(data))(message);
+            };
+            options.warning_data = const_cast<std::function<void(const std::string&)>*>(&warning);
+        }
+        return options;
+    }
+};
+
+// Fastest kernel supported by this CPU
+inline const SHA256_KERNEL* best_kernel() {
+    return sha256_kernel_best();
+}
+
+// Kernel with the given name, nullptr if unknown
+inline const SHA256_KERNEL* find_kernel(const std::string& name) {
+    return sha256_kernel_find(name.c_str());
+}
+
+// Check the chain stored in the file at path
+inline Result<hcb_chain_info> check(const std::string& path, const Options& options = Options()) {
+    hcb_options c_options = options.c_options();
+    hcb_chain_info info;
+    hcb_error error;
+    if (hcb_check(path.c_str(), &c_options, &info, &error) != HCB_OK) {
+        return Error(error);
+    }
+    return info;
+}
+
+// A nonce found by a Searcher
+struct Found {
+    nonce_t nonce = 0;
+    BYTE hash[SHA256_BLOCK_SIZE] = {};
+};
+
+// Nonce searcher owning its worker threads, several searchers can run at once
+class Searcher {
+public:
+    // Searcher with one thread and the fastest kernel, check valid() as it may be out of memory
+    Searcher() : search_(search_create()) {}
+    ~Searcher() { search_destroy(search_); }
+    Searcher(Searcher&& other) noexcept : search_(other.search_) { other.search_ = nullptr; }
+    Searcher& operator=(Searcher&& other) noexcept { std::swap(search_, other.search_); return *this; }
+    Searcher(const Searcher&) = delete;
+    Searcher& operator=(const Searcher&) = delete;
+
+    bool valid() const { return search_ != nullptr; }
+    int set_threads(int threads) { return search_set_threads(search_, threads); }
+    void set_kernel(const SHA256_KERNEL* kernel) { search_set_kernel(search_, kernel); }
+    const SHA256_KERNEL* kernel() const { return search_get_kernel(search_); }
+
+    // Search the lowest nonce in [start, end) whose hash of "prefix\nnonce" starts with exactly
+    // difficulty zero bits, the error is HCB_CANCELLED if the range holds none or cancel() was called
+    Result<Found> search(const std::string& prefix, int difficulty, nonce_t start = 0, nonce_t end = NONCE_MAX) {
+        Found found;
+        if (search_run(search_, prefix.c_str(), difficulty, start, end, &found.nonce, found.hash) != SEARCH_FOUND) {
+            Error error;
+            error.status = HCB_CANCELLED;
+            error.message = "No nonce found";
+            return error;
+        }
+        return found;
+    }
+
+    // Can be called from any thread
+    void cancel() { search_cancel(search_); }
+    nonce_t position() const { return search_position(search_); }
+
+private:
+    search_t* search_;
+};
+
+// Builds a chain in a file, block after block
+class ChainBuilder {
+public:
+    ChainBuilder(ChainBuilder&& other) noexcept : builder_(other.builder_) { other.builder_ = nullptr; }
+    ChainBuilder& operator=(ChainBuilder&& other) noexcept { std::swap(builder_, other.builder_); return *this; }
+    ChainBuilder(const ChainBuilder&) = delete;
+    ChainBuilder& operator=(const ChainBuilder&) = delete;
+    ~ChainBuilder() { hcb_builder_close(builder_); }
+
+    // Start a new chain with the given start message in the file at path
+    static Result<ChainBuilder> create(const std::string& path, const std::string& message, const Options& options = Options()) {
+        hcb_options c_options = options.c_options();
+        hcb_builder* builder;
+        hcb_error error;
+        if (hcb_builder_create(&builder, path.c_str(), message.c_str(), &c_options, &error) != HCB_OK) {
+            return Error(error);
+        }
+        return ChainBuilder(builder);
+    }
+
+    // Continue the chain stored in the file at path, which is checked first
+    static Result<ChainBuilder> resume(const std::string& path, const Options& options = Options()) {
+        hcb_options c_options = options.c_options();
+        hcb_builder* builder;
+        hcb_error error;
+        if (hcb_builder_continue(&builder, path.c_str(), &c_options, nullptr, &error) != HCB_OK) {
+            return Error(error);
+        }
+        return ChainBuilder(builder);
+    }
+
+    // Search the next block and append it to the chain
+    Result<hcb_block> next() {
+        hcb_block block;
+        hcb_error error;
+        if (hcb_builder_next(builder_, &block, &error) != HCB_OK) {
+            return Error(error);
+        }
+        return block;
+    }
+
+    // Append the block of the current level whose lowest valid nonce was found elsewhere
+    Result<hcb_block> append(nonce_t nonce, long long unsigned int attempts = 0, double seconds = 0) {
+        hcb_block block;
+        hcb_error error;
+        if (hcb_builder_append(builder_, nonce, attempts, seconds, &block, &error) != HCB_OK) {
+            return Error(error);
+        }
+        return block;
+    }
+
+    // Save the nonce to resume the search from, can be called from any thread
+    Result<Done> checkpoint() {
+        hcb_error error;
+        if (hcb_builder_checkpoint(builder_, &error) != HCB_OK) {
+            return Error(error);
+        }
+        return Done();
+    }
+
+    // Can be called from any thread
+    void cancel() { hcb_builder_cancel(builder_); }
+    nonce_t position() const { return hcb_builder_position(builder_); }
+
+    int level() const { return hcb_builder_level(builder_); }
+
+private:
+    ChainBuilder() : builder_(nullptr) {}
+    explicit ChainBuilder(hcb_builder* builder) : builder_(builder) {}
+    template <typename T> friend class Result;
+
+    hcb_builder* builder_;
+};
+
+}   // namespace hcb
+
+#endif   // HCB_HPP
@@ -0,0 +1,167 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "scratchpad.h"
+
+struct scratchpad_s {
+    BYTE* items;
+    size_t count;                         // Number of items of HASH_SIZE bytes
+    size_t size;                          // Size in KiB
+
+    // What the items were filled from, they are only filled again for another level
+    bool filled;
+    const HASH_ALGORITHM* algorithm;
+    BYTE message_hash[HASH_SIZE];
+
+    // Message being filled from
+    const char* message;
+    size_t message_length;
+
+    atomic_int next_segment;              // Next segment to be claimed by a filling thread
+};
+
+// Read a little-endian 64 bits word
+static uint64_t load_word(const BYTE bytes[]) {
+    uint64_t word = 0;
+    for (int i = 7; i >= 0; i--) {
+        word = (word << 8) | bytes[i];
+    }
+    return word;
+}
+
+static void store_word(uint64_t word, BYTE bytes[]) {
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (BYTE)(word >> (i * 8));
+    }
+}
+
+scratchpad_t* scratchpad_create(size_t size) {
+    if (size < SCRATCHPAD_MIN_SIZE || size > SCRATCHPAD_MAX_SIZE) {
+        return NULL;
+    }
+    scratchpad_t* scratchpad = calloc(1, sizeof(scratchpad_t));
+    if (scratchpad == NULL) {
+        return NULL;
+    }
+    scratchpad->size = size;
+    scratchpad->count = size * 1024 / HASH_SIZE;
+    scratchpad->items = aligned_alloc(64, scratchpad->count * HASH_SIZE);
+    if (scratchpad->items == NULL) {
+        free(scratchpad);
+        return NULL;
+    }
+    return scratchpad;
+}
+
+void scratchpad_destroy(scratchpad_t* scratchpad) {
+    if (scratchpad == NULL) {
+        return;
+    }
+    free(scratchpad->items);
+    free(scratchpad);
+}
+
+size_t scratchpad_size(const scratchpad_t* scratchpad) {
+    return scratchpad->size;
+}
+
+// Fill one segment: a hash chain seeded by the message and the segment number
+static void fill_segment(scratchpad_t* scratchpad, int segment) {
+    const HASH_ALGORITHM* algorithm = scratchpad->algorithm;
+    size_t begin = scratchpad->count * segment / SCRATCHPAD_SEGMENTS;
+    size_t end = scratchpad->count * (segment + 1) / SCRATCHPAD_SEGMENTS;
+    if (begin == end) {
+        return;
+    }
+    HASH_CTX ctx;
+    BYTE seed[2] = {0, (BYTE)segment};
+    algorithm->init(&ctx);
+    algorithm->update(&ctx, (const BYTE*)scratchpad->message, scratchpad->message_length);
+    algorithm->update(&ctx, seed, sizeof(seed));
+    algorithm->final(&ctx, &scratchpad->items[begin * HASH_SIZE]);
+    for (size_t i = begin + 1; i < end; i++) {
+        hash_digest(algorithm, &scratchpad->items[(i - 1) * HASH_SIZE], HASH_SIZE, &scratchpad->items[i * HASH_SIZE]);
+    }
+}
+
+// Filling thread: claims segments until none is left
+static void* fill_worker(void* arg) {
+    scratchpad_t* scratchpad = arg;
+    int segment;
+    while ((segment = atomic_fetch_add(&scratchpad->next_segment, 1)) < SCRATCHPAD_SEGMENTS) {
+        fill_segment(scratchpad, segment);
+    }
+    return NULL;
+}
+
+void scratchpad_fill(scratchpad_t* scratchpad, const HASH_ALGORITHM* algorithm, const char* message, size_t length, int threads) {
+
+    pthread_t workers[SCRATCHPAD_SEGMENTS];
+
+    // The message is known by its hash, a long start message is not kept
+    BYTE message_hash[HASH_SIZE];
+    hash_digest(algorithm, (const BYTE*)message, length, message_hash);
+    if (scratchpad->filled && scratchpad->algorithm == algorithm && memcmp(scratchpad->message_hash, message_hash, HASH_SIZE) == 0) {
+        return;
+    }
+    scratchpad->filled = true;
+    scratchpad->algorithm = algorithm;
+    memcpy(scratchpad->message_hash, message_hash, HASH_SIZE);
+    scratchpad->message = message;
+    scratchpad->message_length = length;
+
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads > SCRATCHPAD_SEGMENTS) {
+        threads = SCRATCHPAD_SEGMENTS;
+    }
+    atomic_store(&scratchpad->next_segment, 0);
+
+    // Without any thread, the segments are filled in the calling one
+    int started = 0;
+    for (; threads > 1 && started < threads; started++) {
+        if (pthread_create(&workers[started], NULL, fill_worker, scratchpad) != 0) {
+            break;
+        }
+    }
+    if (started == 0) {
+        fill_worker(scratchpad);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+}
+
+void scratchpad_hash(const scratchpad_t* scratchpad, const HASH_ALGORITHM* algorithm, const BYTE digest[], BYTE hash[]) {
+
+    BYTE block[HASH_SIZE * 2];
+    uint64_t word[4];
+    memcpy(block, digest, HASH_SIZE);
+    for (int j = 0; j < 4; j++) {
+        word[j] = load_word(&digest[j * 8]);
+    }
+
+    // Each item is picked by a word mixed with the previous item, so the reads cannot overlap and
+    // each one costs the latency of the level of the memory hierarchy holding the scratchpad
+    for (int r = 0; r < SCRATCHPAD_ROUNDS; r++) {
+        size_t index = (size_t)(((unsigned __int128)word[r % 4] * scratchpad->count) >> 64);
+        const BYTE* item = &scratchpad->items[index * HASH_SIZE];
+        for (int j = 0; j < 4; j++) {
+            word[j] = (word[j] ^ load_word(&item[j * 8])) * 0x9e3779b97f4a7c15ULL;
+            word[j] ^= word[j] >> 29;
+        }
+    }
+
+    for (int j = 0; j < 4; j++) {
+        store_word(word[j], &block[HASH_SIZE + j * 8]);
+    }
+    hash_digest(algorithm, block, sizeof(block), hash);
+
+}
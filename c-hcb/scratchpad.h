@@ -0,0 +1,50 @@
+#ifndef SCRATCHPAD_H
+#define SCRATCHPAD_H
+
+#include <stddef.h>
+#include "sha256.h"
+#include "hash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Smallest and largest scratchpad of a memory-hard chain, in KiB
+#define SCRATCHPAD_MIN_SIZE 1
+#define SCRATCHPAD_MAX_SIZE (64 * 1024 * 1024)
+
+// Independent parts of a scratchpad, filled in parallel
+#define SCRATCHPAD_SEGMENTS 64
+
+// Dependent reads of the scratchpad for each candidate
+#define SCRATCHPAD_ROUNDS 64
+
+// The scratchpad of a memory-hard chain: HASH_SIZE bytes items derived from the message of a
+// level, read at random by the hash of each candidate of the level
+typedef struct scratchpad_s scratchpad_t;
+
+// Allocate a scratchpad of size KiB, NULL if out of memory
+scratchpad_t* scratchpad_create(size_t size);
+
+void scratchpad_destroy(scratchpad_t* scratchpad);
+
+// Size of the scratchpad in KiB
+size_t scratchpad_size(const scratchpad_t* scratchpad);
+
+// Fill the scratchpad from the message of a level with the given number of threads (0 for one
+// per CPU), unless it was already filled from the same message and algorithm
+// Each segment starts with the hash of the message followed by a zero byte and the segment number,
+// every other item is the hash of the previous one
+void scratchpad_fill(scratchpad_t* scratchpad, const HASH_ALGORITHM* algorithm, const char* message, size_t length, int threads);
+
+// Memory-hard hash of a candidate from digest, the regular hash of "message\nnonce": the four 64
+// bits words of the digest are mixed with SCRATCHPAD_ROUNDS items, each one picked by the words
+// mixed so far, and the digest followed by the mixed words is hashed again
+// hash may be digest
+void scratchpad_hash(const scratchpad_t* scratchpad, const HASH_ALGORITHM* algorithm, const BYTE digest[], BYTE hash[]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   // SCRATCHPAD_H
@@ -0,0 +1,702 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "search.h"
+#include "util.h"
+
+// State of one worker, aligned on a cache line so workers never share one
+typedef struct {
+    _Alignas(64) atomic_ullong position; // Lowest nonce the worker may not have tested yet, relative to first
+    search_t* search;
+    int index;
+    throttle_pace_t pace;
+} worker_t;
+
+struct search_s {
+
+    // Number of worker threads
+    int thread_count;
+
+    // Kernel used to compress the candidates
+    const SHA256_KERNEL* kernel;
+
+    // Hash algorithm of the messages, the kernel is only used for SHA-256
+    const HASH_ALGORITHM* hash;
+
+    // Scratchpad of a memory-hard chain, NULL for a regular one
+    scratchpad_t* scratchpad;
+
+    // Each worker runs on its own CPU, except in the thread calling search_run
+    bool pinned;
+    pthread_t caller;
+
+    // Paces the workers in the background, NULL to run them at full speed
+    throttle_t* throttle;
+
+    // CPU time used by the workers of the finished searches, in nanoseconds
+    atomic_ullong cpu_time;
+
+    worker_t workers[SEARCH_MAX_THREADS];
+
+    // Parameters of the running window of the search, shared by all the workers
+    const char* prefix;
+    int difficulty;
+
+    // First nonce of the epoch containing the start of the window, the other nonces of the window
+    // are 64 bits offsets from it
+    nonce_t first;
+    long long unsigned int start;
+
+    // Hash state after the fixed leading blocks of the message ("prefix\n"), shared by the workers
+    WORD midstate[8];
+
+    // Padded blocks of the message following the midstate, the nonce digits are written at
+    // nonce_offset for every candidate
+    BYTE tail[3][64];
+    int tail_blocks;
+    int nonce_offset;
+
+    // Words of tail holding the last SEARCH_EPOCH_DIGITS digits of the nonce (-1 if unused)
+    int vary_word[2];
+
+    // For each of these digits, which of the two words holds it and at which bit position
+    int digit_slot[SEARCH_EPOCH_DIGITS];
+    int digit_shift[SEARCH_EPOCH_DIGITS];
+
+    // The other algorithms: context after "prefix\n", and digits of the first epoch of the window
+    HASH_CTX prefix_ctx;
+    BYTE digits[SHA256_BLOCK_SIZE * 2];
+
+    // Next chunk to be claimed (relative to first)
+    atomic_ullong next_chunk;
+
+    // Lowest valid nonce found so far, the end of the window if none (relative to first)
+    atomic_ullong found_nonce;
+
+    // Resume point when no search is running
+    nonce_t idle_position;
+
+    // Protects first, running and idle_position, which search_position reads from any thread
+    pthread_mutex_t position_lock;
+    bool running;
+
+    atomic_bool cancelled;
+
+};
+
+// Count the number of zero at left of a BYTE array (little-endian)
+int numberOfZero(BYTE array[], int len) {
+    int number = 0, i, j;
+    for (i = 0; i < len; i++) {
+        // Check in current byte
+        // Little-endian, so decrement
+        for (j = 7; j >= 0; j--) {
+            if (((array[i]>>j)&1) == 0) {
+                number++;
+            } else {
+                return number;
+            }
+        }
+    }
+    return number;
+}
+
+int nonce_format(nonce_t nonce, int width, char text[]) {
+    char digits[NONCE_DIGITS];
+    int count = 0;
+    do {
+        digits[count++] = '0' + (int)(nonce % 10);
+        nonce /= 10;
+    } while (nonce != 0);
+    int length = count > width ? count : width;
+    memset(text, '0', length - count);
+    for (int i = 0; i < count; i++) {
+        text[length - 1 - i] = digits[i];
+    }
+    text[length] = '\0';
+    return length;
+}
+
+bool nonce_parse(const char* text, int length, nonce_t* nonce) {
+    nonce_t value = 0;
+    if (length <= 0) {
+        return false;
+    }
+    for (int i = 0; i < length; i++) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        int digit = text[i] - '0';
+        if (value > (NONCE_MAX - digit) / 10) {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    *nonce = value;
+    return true;
+}
+
+// Add value to the decimal digits of an odometer in place, only the digits which change are written
+static void digits_add(BYTE digits[], int length, long long unsigned int value) {
+    int carry = 0;
+    for (int i = length - 1; i >= 0 && (value != 0 || carry != 0); i--) {
+        int digit = digits[i] - '0' + (int)(value % 10) + carry;
+        value /= 10;
+        carry = digit >= 10;
+        digits[i] = (BYTE)('0' + digit - carry * 10);
+    }
+}
+
+search_t* search_create(void) {
+    search_t* search = aligned_alloc(64, (sizeof(search_t) + 63) / 64 * 64);
+    if (search == NULL) {
+        return NULL;
+    }
+    memset(search, 0, sizeof(search_t));
+    pthread_mutex_init(&search->position_lock, NULL);
+    search->thread_count = 1;
+    search->kernel = sha256_kernel_best();
+    search->hash = &hash_sha256;
+    for (int i = 0; i < SEARCH_MAX_THREADS; i++) {
+        search->workers[i].search = search;
+        search->workers[i].index = i;
+    }
+    return search;
+}
+
+void search_destroy(search_t* search) {
+    if (search == NULL) {
+        return;
+    }
+    pthread_mutex_destroy(&search->position_lock);
+    scratchpad_destroy(search->scratchpad);
+    free(search);
+}
+
+int search_set_threads(search_t* search, int threads) {
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads > SEARCH_MAX_THREADS) {
+        threads = SEARCH_MAX_THREADS;
+    }
+    search->thread_count = threads;
+    return search->thread_count;
+}
+
+// Lower the found nonce to nonce if it is smaller
+static void found_lower(search_t* search, long long unsigned int nonce) {
+    long long unsigned int current = atomic_load(&search->found_nonce);
+    while (nonce < current && !atomic_compare_exchange_weak(&search->found_nonce, &current, nonce));
+}
+
+// Hash "prefix\nnonce" the regular way, streamed like verify_hash
+static void search_hash(search_t* search, nonce_t nonce, BYTE hash[]) {
+    HASH_CTX ctx;
+    char digits[SHA256_BLOCK_SIZE * 2 + 1];
+    nonce_format(nonce, nonce_length, digits);
+    search->hash->init(&ctx);
+    search->hash->update(&ctx, (const BYTE*)search->prefix, strlen(search->prefix));
+    search->hash->update(&ctx, (const BYTE*)"\n", 1);
+    search->hash->update(&ctx, (const BYTE*)digits, nonce_length);
+    search->hash->final(&ctx, hash);
+    if (search->scratchpad != NULL) {
+        scratchpad_hash(search->scratchpad, search->hash, hash, hash);
+    }
+}
+
+// Confirm a candidate reported by the kernel, which only tests the first 64 bits of the digest
+static bool search_confirm(search_t* search, nonce_t nonce) {
+    BYTE hash[SHA256_BLOCK_SIZE];
+    if (search->difficulty < 64) {
+        return true;
+    }
+    search_hash(search, nonce, hash);
+    return numberOfZero(hash, SHA256_BLOCK_SIZE) == search->difficulty;
+}
+
+void search_set_kernel(search_t* search, const SHA256_KERNEL* kernel) {
+    search->kernel = kernel;
+}
+
+const SHA256_KERNEL* search_get_kernel(search_t* search) {
+    return search->kernel;
+}
+
+void search_set_hash(search_t* search, const HASH_ALGORITHM* hash) {
+    search->hash = hash;
+}
+
+const HASH_ALGORITHM* search_get_hash(search_t* search) {
+    return search->hash;
+}
+
+bool search_set_memory(search_t* search, size_t size) {
+    if (size == search_get_memory(search)) {
+        return true;
+    }
+    scratchpad_t* scratchpad = NULL;
+    if (size != 0 && (scratchpad = scratchpad_create(size)) == NULL) {
+        return false;
+    }
+    scratchpad_destroy(search->scratchpad);
+    search->scratchpad = scratchpad;
+    return true;
+}
+
+size_t search_get_memory(search_t* search) {
+    return search->scratchpad != NULL ? scratchpad_size(search->scratchpad) : 0;
+}
+
+void search_set_pinned(search_t* search, bool pinned) {
+    search->pinned = pinned;
+}
+
+bool search_get_pinned(search_t* search) {
+    return search->pinned;
+}
+
+void search_set_throttle(search_t* search, throttle_t* throttle) {
+    search->throttle = throttle;
+}
+
+double search_cpu_seconds(search_t* search) {
+    return atomic_load(&search->cpu_time) / 1e9;
+}
+
+bool search_pin_thread(int index) {
+    cpu_set_t allowed, cpu;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0) {
+        return false;
+    }
+    index %= CPU_COUNT(&allowed);
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (CPU_ISSET(c, &allowed) && index-- == 0) {
+            CPU_ZERO(&cpu);
+            CPU_SET(c, &cpu);
+            return pthread_setaffinity_np(pthread_self(), sizeof(cpu), &cpu) == 0;
+        }
+    }
+    return false;
+}
+
+// Pause the worker while the throttle says it ran over its share of the CPUs
+static void search_pace(worker_t* worker) {
+    search_t* search = worker->search;
+    while (search->throttle != NULL && !atomic_load(&search->cancelled) && throttle_pace(search->throttle, &worker->pace)) {
+    }
+}
+
+// Worker of the algorithms other than SHA-256 and of the memory-hard chains, which have no kernel:
+// the context after the digits that do not change in the epoch is copied for each run of ten
+// nonces, and the context after all but the last digit for each nonce, so the blocks before the
+// last digit are hashed once per run
+static void search_worker_hash(worker_t* worker) {
+
+    search_t* search = worker->search;
+    const HASH_ALGORITHM* algorithm = search->hash;
+    const scratchpad_t* scratchpad = search->scratchpad;
+    BYTE digits[SHA256_BLOCK_SIZE * 2];
+    BYTE hash[HASH_SIZE];
+    HASH_CTX epoch, run, ctx;
+    memcpy(digits, search->digits, sizeof(digits));
+
+    // Offset of the epoch whose digits are in digits, they start with the ones of the window
+    long long unsigned int written = 0;
+
+    while (1) {
+
+        // Claim the next chunk, after the pause the throttle asks for
+        // The position only moves to the chunk once it is going to be tested: a worker stopping
+        // here keeps the end of the chunk it tested last, so a cancelled search never skips nonces
+        search_pace(worker);
+        long long unsigned int first = atomic_fetch_add(&search->next_chunk, 1) * SEARCH_CHUNK_SIZE;
+        if (first >= atomic_load(&search->found_nonce) || atomic_load(&search->cancelled)) {
+            break;
+        }
+        atomic_store_explicit(&worker->position, first < search->start ? search->start : first, memory_order_relaxed);
+        digits_add(digits, nonce_length, first - written);
+        written = first;
+        epoch = search->prefix_ctx;
+        algorithm->update(&epoch, digits, nonce_length - SEARCH_EPOCH_DIGITS);
+
+        // Test the chunk by runs of ten nonces, which only differ by their last digit
+        bool chunk_done = false;
+        long long unsigned int counter;
+        for (counter = first; counter < first + SEARCH_CHUNK_SIZE && !chunk_done; counter += 10) {
+
+            // Another worker already found a lower nonce, or the search is cancelled
+            if (counter >= atomic_load_explicit(&search->found_nonce, memory_order_relaxed) ||
+                atomic_load_explicit(&search->cancelled, memory_order_relaxed)) {
+                break;
+            }
+            atomic_store_explicit(&worker->position, counter < search->start ? search->start : counter, memory_order_relaxed);
+
+            BYTE run_digits[SEARCH_EPOCH_DIGITS];
+            long long unsigned int value = (counter - first) / 10;
+            for (int k = SEARCH_EPOCH_DIGITS - 2; k >= 0; k--, value /= 10) {
+                run_digits[k] = (BYTE)('0' + value % 10);
+            }
+            run = epoch;
+            algorithm->update(&run, run_digits, SEARCH_EPOCH_DIGITS - 1);
+
+            for (int d = 0; d < 10; d++) {
+                BYTE last = (BYTE)('0' + d);
+                ctx = run;
+                algorithm->update(&ctx, &last, 1);
+                algorithm->final(&ctx, hash);
+                if (scratchpad != NULL) {
+                    scratchpad_hash(scratchpad, algorithm, hash, hash);
+                }
+                if (numberOfZero(hash, HASH_SIZE) == search->difficulty && counter + d >= search->start) {
+                    found_lower(search, counter + d);
+                    chunk_done = true;
+                    break;
+                }
+            }
+
+        }
+
+        // Every nonce of the chunk was tested
+        if (counter >= first + SEARCH_CHUNK_SIZE && !chunk_done) {
+            atomic_store_explicit(&worker->position, first + SEARCH_CHUNK_SIZE, memory_order_relaxed);
+        }
+
+    }
+
+}
+
+// Worker of the SHA-256 chains: claims chunks of nonces in increasing order until a valid one is
+// known to be lower than anything left to test
+static void search_worker_kernel(worker_t* worker) {
+
+    search_t* search = worker->search;
+    const SHA256_KERNEL* kernel = search->kernel;
+    int lanes = kernel->lanes;
+
+    // The tail blocks with the digits of the current epoch, and what is precomputed from them
+    BYTE tail[3 * 64];
+    WORD midstate[8];
+    SHA256_SCHEDULE schedule[3];
+    WORD vary_base[2] = {0, 0};
+    int first_block = search->vary_word[0] / 16;
+    memcpy(tail, search->tail, sizeof(tail));
+
+    // Offset of the epoch whose digits are in tail, they start with the ones of the window
+    long long unsigned int written = 0;
+
+    // One state and the changing words of each lane
+    WORD state[SHA256_MAX_LANES][8];
+    WORD vary[SHA256_MAX_LANES][2];
+
+    while (1) {
+
+        // Claim the next chunk, after the pause the throttle asks for
+        // The position only moves to the chunk once it is going to be tested: a worker stopping
+        // here keeps the end of the chunk it tested last, so a cancelled search never skips nonces
+        search_pace(worker);
+        long long unsigned int first = atomic_fetch_add(&search->next_chunk, 1) * SEARCH_CHUNK_SIZE;
+        if (first >= atomic_load(&search->found_nonce) || atomic_load(&search->cancelled)) {
+            break;
+        }
+        atomic_store_explicit(&worker->position, first < search->start ? search->start : first, memory_order_relaxed);
+
+        // A chunk is an epoch: advance the digits of the previous one in place, the last ones
+        // stay to zero
+        digits_add(&tail[search->nonce_offset], nonce_length, first - written);
+        written = first;
+
+        // Fold the blocks preceding the changing words in the midstate, and precompute the schedule
+        // of the other blocks (with the first rounds of the first block)
+        memcpy(midstate, search->midstate, sizeof(midstate));
+        for (int b = 0; b < first_block; b++) {
+            sha256_compress(midstate, &tail[b * 64]);
+        }
+        for (int b = first_block; b < search->tail_blocks; b++) {
+            int vary_index[2];
+            for (int k = 0; k < 2; k++) {
+                vary_index[k] = search->vary_word[k] >= 0 && search->vary_word[k] / 16 == b ? search->vary_word[k] % 16 : -1;
+            }
+            sha256_schedule_init(&schedule[b], &tail[b * 64], vary_index, b == first_block ? midstate : NULL);
+        }
+        for (int k = 0; k < 2; k++) {
+            if (search->vary_word[k] >= 0) {
+                BYTE* word = &tail[search->vary_word[k] * 4];
+                vary_base[k] = (word[0] << 24) | (word[1] << 16) | (word[2] << 8) | word[3];
+            }
+        }
+
+        // The last digits of the lanes are an odometer kept in the changing words: each digit is a
+        // byte of a word, incremented in place and set back to '0' when it carries to the next one
+        int digits[SEARCH_EPOCH_DIGITS] = {0};
+        WORD odometer[2] = {vary_base[0], vary_base[1]};
+
+        // Test the chunk by batches of one nonce per lane
+        bool chunk_done = false;
+        long long unsigned int counter;
+        for (counter = first; counter < first + SEARCH_CHUNK_SIZE && !chunk_done; counter += lanes) {
+
+            // Another worker already found a lower nonce, or the search is cancelled
+            if (counter >= atomic_load_explicit(&search->found_nonce, memory_order_relaxed) ||
+                atomic_load_explicit(&search->cancelled, memory_order_relaxed)) {
+                break;
+            }
+            atomic_store_explicit(&worker->position, counter < search->start ? search->start : counter, memory_order_relaxed);
+
+            // Give each lane the changing words of its nonce, then advance the odometer
+            for (int l = 0; l < lanes; l++) {
+                vary[l][0] = odometer[0];
+                vary[l][1] = odometer[1];
+                for (int j = SEARCH_EPOCH_DIGITS - 1; j >= 0; j--) {
+                    WORD unit = (WORD)1 << search->digit_shift[j];
+                    if (digits[j] < 9) {
+                        digits[j]++;
+                        odometer[search->digit_slot[j]] += unit;
+                        break;
+                    }
+                    digits[j] = 0;
+                    odometer[search->digit_slot[j]] -= 9 * unit;
+                }
+                if (schedule[first_block].rounds == 0) {
+                    memcpy(state[l], midstate, sizeof(midstate));
+                }
+            }
+
+            // Compress the tail blocks of every lane, the last one is directly tested against the difficulty
+            for (int b = first_block; b < search->tail_blocks - 1; b++) {
+                kernel->transform_pre(state, &schedule[b], (const WORD (*)[2])vary);
+            }
+            unsigned int valid = kernel->search_pre((const WORD (*)[8])state, &schedule[search->tail_blocks - 1], (const WORD (*)[2])vary, search->difficulty);
+
+            // Check the lanes by increasing nonce, the first valid one is the lowest of the batch
+            for (int l = 0; l < lanes && valid != 0; l++) {
+                if (((valid >> l) & 1) && counter + l >= search->start && search_confirm(search, search->first + counter + l)) {
+                    found_lower(search, counter + l);
+                    chunk_done = true;
+                    break;
+                }
+            }
+
+        }
+
+        // Every nonce of the chunk was tested
+        if (counter >= first + SEARCH_CHUNK_SIZE && !chunk_done) {
+            atomic_store_explicit(&worker->position, first + SEARCH_CHUNK_SIZE, memory_order_relaxed);
+        }
+
+    }
+
+}
+
+// Worker thread, the position of the worker is kept: when cancelled, it tells where it stopped
+static void* search_worker(void* arg) {
+
+    worker_t* worker = arg;
+    search_t* search = worker->search;
+    double cpu = throttle_thread_cpu();
+    if (search->pinned && !pthread_equal(pthread_self(), search->caller)) {
+        search_pin_thread(worker->index);
+    }
+    if (search->throttle != NULL) {
+        throttle_begin(search->throttle, &worker->pace);
+    }
+
+    if (search->hash != &hash_sha256 || search->scratchpad != NULL) {
+        search_worker_hash(worker);
+    } else {
+        search_worker_kernel(worker);
+    }
+
+    if (search->throttle != NULL) {
+        throttle_end(search->throttle);
+    }
+    atomic_fetch_add(&search->cpu_time, (long long unsigned int)((throttle_thread_cpu() - cpu) * 1e9));
+    return NULL;
+
+}
+
+// Lowest nonce that may not have been tested by the running search: every nonce below the
+// position of all the workers was tested, and nothing above a valid nonce needs to be
+static long long unsigned int running_position(search_t* search) {
+    long long unsigned int position = atomic_load(&search->found_nonce);
+    for (int i = 0; i < search->thread_count; i++) {
+        long long unsigned int current = atomic_load(&search->workers[i].position);
+        if (current < position) {
+            position = current;
+        }
+    }
+    return position;
+}
+
+// Prepare the SHA-256 kernels for the window starting at the epoch first
+static void prepare_tail(search_t* search, const char* prefix, nonce_t first) {
+
+    // Hash once the complete blocks of "prefix\n", they are the same for every nonce of the level
+    SHA256_CTX ctx;
+    size_t prefix_length = strlen(prefix);
+    size_t midstate_length = (prefix_length + 1) / 64 * 64;
+    sha256_init(&ctx);
+    sha256_update(&ctx, (const BYTE*)prefix, midstate_length < prefix_length ? midstate_length : prefix_length);
+    if (midstate_length > prefix_length) {
+        sha256_update(&ctx, (const BYTE*)"\n", 1);
+    }
+    memcpy(search->midstate, ctx.state, sizeof(search->midstate));
+
+    // Prepare the padded tail blocks, with the nonce digits left to the workers
+    size_t message_length = prefix_length + 1 + nonce_length;
+    size_t tail_length = message_length - midstate_length;
+    BYTE* tail = (BYTE*)search->tail;
+    memset(search->tail, 0, sizeof(search->tail));
+    for (size_t i = midstate_length; i < message_length; i++) {
+        tail[i - midstate_length] = i < prefix_length ? prefix[i] : i == prefix_length ? '\n' : '0';
+    }
+    tail[tail_length] = 0x80;
+    search->tail_blocks = (tail_length + 9 + 63) / 64;
+    search->nonce_offset = prefix_length + 1 - midstate_length;
+    for (int i = 0; i < 8; i++) {
+        tail[search->tail_blocks * 64 - 1 - i] = (BYTE)((message_length * 8) >> (i * 8));
+    }
+
+    // Locate the digits changing inside an epoch, they span one or two words
+    int first_digit = search->nonce_offset + nonce_length - SEARCH_EPOCH_DIGITS;
+    int last_digit = search->nonce_offset + nonce_length - 1;
+    search->vary_word[0] = first_digit / 4;
+    search->vary_word[1] = last_digit / 4 != first_digit / 4 ? last_digit / 4 : -1;
+    for (int j = 0; j < SEARCH_EPOCH_DIGITS; j++) {
+        search->digit_slot[j] = (first_digit + j) / 4 == search->vary_word[0] ? 0 : 1;
+        search->digit_shift[j] = (3 - (first_digit + j) % 4) * 8;
+    }
+
+    // The workers start from the digits of the first epoch of the window
+    char digits[SHA256_BLOCK_SIZE * 2 + 1];
+    nonce_format(first, nonce_length, digits);
+    memcpy(&tail[search->nonce_offset], digits, nonce_length);
+
+}
+
+// Prepare the other algorithms for the window starting at the epoch first: each epoch starts from
+// the context after "prefix\n"
+static void prepare_context(search_t* search, const char* prefix, nonce_t first) {
+    char digits[SHA256_BLOCK_SIZE * 2 + 1];
+    search->hash->init(&search->prefix_ctx);
+    search->hash->update(&search->prefix_ctx, (const BYTE*)prefix, strlen(prefix));
+    search->hash->update(&search->prefix_ctx, (const BYTE*)"\n", 1);
+    nonce_format(first, nonce_length, digits);
+    memcpy(search->digits, digits, nonce_length);
+}
+
+// Search the nonces of [start, end), which must not span more than SEARCH_WINDOW_SIZE nonces
+// from the epoch containing start
+static int search_window(search_t* search, const char* prefix, int difficulty, nonce_t start, nonce_t end, nonce_t* found, BYTE hash[]) {
+
+    pthread_t threads[SEARCH_MAX_THREADS];
+
+    nonce_t first = start - start % SEARCH_CHUNK_SIZE;
+    long long unsigned int end_offset = end > first ? (long long unsigned int)(end - first) : 0;
+    search->prefix = prefix;
+    search->difficulty = difficulty;
+    search->start = (long long unsigned int)(start - first);
+    atomic_store(&search->next_chunk, 0);
+
+    // The end of the window behaves like an already found nonce: the workers stop before it
+    atomic_store(&search->found_nonce, end_offset);
+    if (atomic_load(&search->cancelled)) {
+        return SEARCH_CANCELLED;
+    }
+
+    // Precompute what every nonce of the window shares, and the scratchpad of the message
+    if (search->scratchpad != NULL) {
+        scratchpad_fill(search->scratchpad, search->hash, prefix, strlen(prefix), search->thread_count);
+    }
+    if (search->hash == &hash_sha256 && search->scratchpad == NULL) {
+        prepare_tail(search, prefix, first);
+    } else {
+        prepare_context(search, prefix, first);
+    }
+
+    // Mark every worker as busy from the start, so search_position never skips nonces
+    for (int i = 0; i < search->thread_count; i++) {
+        atomic_store(&search->workers[i].position, search->start);
+    }
+    pthread_mutex_lock(&search->position_lock);
+    search->first = first;
+    search->running = true;
+    pthread_mutex_unlock(&search->position_lock);
+
+    // Without any thread, the search runs in the calling one
+    search->caller = pthread_self();
+    int started = 0;
+    for (; started < search->thread_count; started++) {
+        if (pthread_create(&threads[started], NULL, search_worker, &search->workers[started]) != 0) {
+            break;
+        }
+    }
+    if (started == 0) {
+        search_worker(&search->workers[0]);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // Stopped before knowing the lowest valid nonce
+    long long unsigned int nonce = atomic_load(&search->found_nonce);
+    int result = SEARCH_FOUND;
+    if (atomic_load(&search->cancelled) && (nonce == end_offset || running_position(search) < nonce)) {
+        result = SEARCH_CANCELLED;
+        nonce = running_position(search);
+    } else if (nonce == end_offset) {
+        // Every nonce of the window was tested
+        result = SEARCH_EXHAUSTED;
+    } else {
+        // The kernels never write the final digest, so only the winning nonce is fully hashed
+        search_hash(search, first + nonce, hash);
+        *found = first + nonce;
+    }
+
+    pthread_mutex_lock(&search->position_lock);
+    search->idle_position = result == SEARCH_EXHAUSTED ? end : result == SEARCH_FOUND ? first + nonce + 1 : first + nonce;
+    search->running = false;
+    pthread_mutex_unlock(&search->position_lock);
+    return result;
+
+}
+
+int search_run(search_t* search, const char* prefix, int difficulty, nonce_t start, nonce_t end, nonce_t* found, BYTE hash[]) {
+
+    // Every nonce of a window is tested before the next window is started
+    while (1) {
+        nonce_t first = start - start % SEARCH_CHUNK_SIZE;
+        nonce_t window_end = end > first && end - first > SEARCH_WINDOW_SIZE ? first + SEARCH_WINDOW_SIZE : end;
+        int result = search_window(search, prefix, difficulty, start, window_end, found, hash);
+        if (result != SEARCH_EXHAUSTED || window_end == end) {
+            return result;
+        }
+        start = window_end;
+    }
+
+}
+
+void search_cancel(search_t* search) {
+    atomic_store(&search->cancelled, true);
+}
+
+void search_set_position(search_t* search, nonce_t position) {
+    pthread_mutex_lock(&search->position_lock);
+    search->idle_position = position;
+    pthread_mutex_unlock(&search->position_lock);
+}
+
+nonce_t search_position(search_t* search) {
+    pthread_mutex_lock(&search->position_lock);
+    nonce_t position = search->running ? search->first + running_position(search) : search->idle_position;
+    pthread_mutex_unlock(&search->position_lock);
+    return position;
+}
@@ -0,0 +1,125 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <limits.h>
+#include <stdbool.h>
+#include "sha256.h"
+#include "hash.h"
+#include "scratchpad.h"
+#include "throttle.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Count the number of zero at left of a BYTE array (little-endian)
+int numberOfZero(BYTE array[], int len);
+
+// A nonce: the 64 digits of the nonce line hold much more than 64 bits, so the nonces are 128
+// bits wide and a level is never short of nonces
+typedef unsigned __int128 nonce_t;
+#define NONCE_MAX (~(nonce_t)0)
+
+// Number of decimal digits of NONCE_MAX
+#define NONCE_DIGITS 39
+
+// Write the decimal digits of nonce to text, padded with zeros to width digits, and terminate it
+// text must hold at least width + 1 and NONCE_DIGITS + 1 characters, returns the number of digits
+int nonce_format(nonce_t nonce, int width, char text[]);
+
+// Read the decimal nonce of the length first characters of text
+// Returns false if they are not all digits or if the value is above NONCE_MAX
+bool nonce_parse(const char* text, int length, nonce_t* nonce);
+
+// Number of trailing nonce digits that change inside an epoch, everything else in the
+// message is constant for the epoch and precomputed once
+#define SEARCH_EPOCH_DIGITS 4
+
+// Number of consecutive nonces a worker claims at once: one epoch
+#define SEARCH_CHUNK_SIZE 10000
+
+// Nonces searched by the workers before they restart from the end of the previous window, so
+// their positions are 64 bits offsets from the start of the window
+#define SEARCH_WINDOW_SIZE ((nonce_t)(ULLONG_MAX / 2 / SEARCH_CHUNK_SIZE * SEARCH_CHUNK_SIZE))
+
+// Maximum number of worker threads
+#define SEARCH_MAX_THREADS 1024
+
+// Results of search_run
+#define SEARCH_FOUND 0       // A valid nonce was found
+#define SEARCH_EXHAUSTED 1   // No nonce of the range is valid
+#define SEARCH_CANCELLED 2   // search_cancel was called
+
+// A nonce searcher, with its own worker threads: several searches can run at once
+typedef struct search_s search_t;
+
+// Create a searcher using one thread and the fastest supported kernel, NULL if out of memory
+search_t* search_create(void);
+
+void search_destroy(search_t* search);
+
+// Set the number of worker threads (0 means one per online CPU)
+// Returns the number of threads actually used
+int search_set_threads(search_t* search, int threads);
+
+// Force the kernel used to compress the candidates
+void search_set_kernel(search_t* search, const SHA256_KERNEL* kernel);
+
+// Get the kernel used to compress the candidates (the fastest supported one by default)
+const SHA256_KERNEL* search_get_kernel(search_t* search);
+
+// Set the hash algorithm of the searched messages (SHA-256 by default), the kernel only applies
+// to SHA-256
+void search_set_hash(search_t* search, const HASH_ALGORITHM* hash);
+
+const HASH_ALGORITHM* search_get_hash(search_t* search);
+
+// Search a memory-hard chain whose scratchpads have size KiB, or a regular one if size is 0 (the
+// default): the scratchpad is filled by the worker threads when the searched message changes
+// Returns false if the scratchpad could not be allocated, the previous size is then kept
+bool search_set_memory(search_t* search, size_t size);
+
+// Size in KiB of the scratchpads, 0 for a regular chain
+size_t search_get_memory(search_t* search);
+
+// Run each worker thread on its own CPU, among the ones the calling thread may run on (off by
+// default, the threads then go wherever the scheduler puts them)
+void search_set_pinned(search_t* search, bool pinned);
+
+bool search_get_pinned(search_t* search);
+
+// Pace the worker threads with throttle, which may be shared by several searches, or run them
+// at full speed if NULL (the default)
+void search_set_throttle(search_t* search, throttle_t* throttle);
+
+// CPU time used by the worker threads of the finished searches, in seconds
+double search_cpu_seconds(search_t* search);
+
+// Run the calling thread on the CPU number index (modulo their count) among the ones it may run
+// on, the threads it creates afterwards inherit it
+// Returns false if the CPU could not be chosen
+bool search_pin_thread(int index);
+
+// Search the lowest nonce in [start, end) for which the hash of "prefix\nnonce" (its memory-hard
+// hash with a scratchpad) starts with exactly difficulty bits to zero, the nonce and its hash are
+// written in nonce and hash
+// Returns SEARCH_FOUND, SEARCH_EXHAUSTED or SEARCH_CANCELLED
+int search_run(search_t* search, const char* prefix, int difficulty, nonce_t start, nonce_t end, nonce_t* nonce, BYTE hash[]);
+
+// Stop the running search and make every following one return SEARCH_CANCELLED
+// Can be called from any thread
+void search_cancel(search_t* search);
+
+// Get the lowest nonce that has not been tested yet by the running or the last search
+// Every nonce below this one is known to be invalid, so the search can resume from it
+// Can be called from any thread
+nonce_t search_position(search_t* search);
+
+// Set the resume point reported by search_position while no search is running
+void search_set_position(search_t* search, nonce_t position);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   // SEARCH_H
@@ -15,21 +15,49 @@
 /*************************** HEADER FILES ***************************/
 #include <stdlib.h>
 #include <memory.h>
+#include <string.h>
 #include "sha256.h"
 
 /****************************** MACROS ******************************/
 #define ROTLEFT(a,b) (((a) << (b)) | ((a) >> (32-(b))))
 #define ROTRIGHT(a,b) (((a) >> (b)) | ((a) << (32-(b))))
 
-#define CH(x,y,z) (((x) & (y)) ^ (~(x) & (z)))
-#define MAJ(x,y,z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define CH(x,y,z) ((((y) ^ (z)) & (x)) ^ (z))
+#define MAJ(x,y,z) (((x) & (y)) | (((x) | (y)) & (z)))
 #define EP0(x) (ROTRIGHT(x,2) ^ ROTRIGHT(x,13) ^ ROTRIGHT(x,22))
 #define EP1(x) (ROTRIGHT(x,6) ^ ROTRIGHT(x,11) ^ ROTRIGHT(x,25))
 #define SIG0(x) (ROTRIGHT(x,7) ^ ROTRIGHT(x,18) ^ ((x) >> 3))
 #define SIG1(x) (ROTRIGHT(x,17) ^ ROTRIGHT(x,19) ^ ((x) >> 10))
 
+// One round on working variables named by their role in it, so 8 rounds in a row rename them
+// instead of shifting them, kw is the round constant plus the schedule word
+#define ROUND(a,b,c,d,e,f,g,h,kw) \
+	t1 = (h) + EP1(e) + CH(e,f,g) + (kw); \
+	(d) += t1; \
+	(h) = t1 + EP0(a) + MAJ(a,b,c)
+
+#define ROUNDS8(t,KW) \
+	ROUND(a,b,c,d,e,f,g,h, KW((t))); \
+	ROUND(h,a,b,c,d,e,f,g, KW((t) + 1)); \
+	ROUND(g,h,a,b,c,d,e,f, KW((t) + 2)); \
+	ROUND(f,g,h,a,b,c,d,e, KW((t) + 3)); \
+	ROUND(e,f,g,h,a,b,c,d, KW((t) + 4)); \
+	ROUND(d,e,f,g,h,a,b,c, KW((t) + 5)); \
+	ROUND(c,d,e,f,g,h,a,b, KW((t) + 6)); \
+	ROUND(b,c,d,e,f,g,h,a, KW((t) + 7))
+
+// Schedule kept in 16 words, each one replaced in place by the word 16 rounds later
+#define KW_LOAD(t) (sha256_k[t] + w[t])
+#define KW_SCHED(t) (sha256_k[t] + (w[(t) & 15] += SIG1(w[((t) - 2) & 15]) + w[((t) - 7) & 15] + SIG0(w[((t) - 15) & 15])))
+
+#if defined(__GNUC__)
+#define SHA256_INLINE static inline __attribute__((always_inline))
+#else
+#define SHA256_INLINE static inline
+#endif
+
 /**************************** VARIABLES *****************************/
-static const WORD k[64] = {
+const WORD sha256_k[64] = {
 	0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
 	0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
 	0xe49b69c1,0xefbe4786,0x0fc19dc6,0x240ca1cc,0x2de92c6f,0x4a7484aa,0x5cb0a9dc,0x76f988da,
@@ -41,26 +69,190 @@ static const WORD k[64] = {
 };
 
 /*********************** FUNCTION DEFINITIONS ***********************/
+// Big-endian word of the message, loaded at once where the compiler knows how
+SHA256_INLINE WORD sha256_load(const BYTE *p)
+{
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	WORD w;
+	memcpy(&w, p, 4);
+	return __builtin_bswap32(w);
+#elif defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	WORD w;
+	memcpy(&w, p, 4);
+	return w;
+#else
+	return ((WORD)p[0] << 24) | ((WORD)p[1] << 16) | ((WORD)p[2] << 8) | p[3];
+#endif
+}
+
+// Compression of the block whose words are in w, which ends up holding the last 16 schedule words
+// Always inlined: the callers passing constant words get the rounds and the schedule folded
+SHA256_INLINE void sha256_compress_words(WORD state[8], WORD w[16])
+{
+	WORD a, b, c, d, e, f, g, h, t1;
+
+	a = state[0];
+	b = state[1];
+	c = state[2];
+	d = state[3];
+	e = state[4];
+	f = state[5];
+	g = state[6];
+	h = state[7];
+
+	ROUNDS8(0, KW_LOAD);
+	ROUNDS8(8, KW_LOAD);
+	ROUNDS8(16, KW_SCHED);
+	ROUNDS8(24, KW_SCHED);
+	ROUNDS8(32, KW_SCHED);
+	ROUNDS8(40, KW_SCHED);
+	ROUNDS8(48, KW_SCHED);
+	ROUNDS8(56, KW_SCHED);
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+	state[5] += f;
+	state[6] += g;
+	state[7] += h;
+}
+
+void sha256_compress_scalar(WORD state[8], const BYTE data[])
+{
+	WORD w[16];
+	int i;
+
+	for (i = 0; i < 16; ++i)
+		w[i] = sha256_load(&data[i * 4]);
+	sha256_compress_words(state, w);
+}
+
+// Last block of a 129 bytes message: its last byte, then the padding and the length, constant
+static void sha256_compress_tail129(WORD state[8], BYTE last)
+{
+	WORD w[16] = {((WORD)last << 24) | 0x00800000, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 129 * 8};
+
+	sha256_compress_words(state, w);
+}
+
+// Pick the fastest single buffer compression on first use
+static void sha256_compress_resolve(WORD state[8], const BYTE data[]);
+static void (*sha256_compress_fn)(WORD state[8], const BYTE data[]) = sha256_compress_resolve;
+
+static void sha256_compress_resolve(WORD state[8], const BYTE data[])
+{
+	sha256_compress_fn = sha256_shani_supported() ? sha256_compress_shani : sha256_compress_scalar;
+	sha256_compress_fn(state, data);
+}
+
+void sha256_compress(WORD state[8], const BYTE data[])
+{
+	sha256_compress_fn(state, data);
+}
+
 void sha256_transform(SHA256_CTX *ctx, const BYTE data[])
 {
-	WORD a, b, c, d, e, f, g, h, i, j, t1, t2, m[64];
+	sha256_compress_fn(ctx->state, data);
+}
+
+void sha256_digest_hcb_scalar(const BYTE message[], const BYTE nonce[], BYTE hash[])
+{
+	WORD state[8];
+	BYTE block[64];
+
+	sha256_init_state(state);
+	sha256_compress_scalar(state, message);
+	block[0] = '\n';
+	memcpy(&block[1], nonce, 63);
+	sha256_compress_scalar(state, block);
+	sha256_compress_tail129(state, nonce[63]);
+	sha256_state_digest(state, hash);
+}
+
+void sha256_digest_hcb(const BYTE message[], const BYTE nonce[], BYTE hash[])
+{
+	WORD state[8];
+	BYTE block[64];
+
+	// The scalar compression folds the constant words of the last block, the others hash it whole
+	if (sha256_compress_fn == sha256_compress_scalar) {
+		sha256_digest_hcb_scalar(message, nonce, hash);
+		return;
+	}
+	sha256_init_state(state);
+	sha256_compress(state, message);
+	block[0] = '\n';
+	memcpy(&block[1], nonce, 63);
+	sha256_compress(state, block);
+	memset(block, 0, sizeof(block));
+	block[0] = nonce[63];
+	block[1] = 0x80;
+	block[62] = (129 * 8) >> 8;
+	block[63] = (BYTE)(129 * 8);
+	sha256_compress(state, block);
+	sha256_state_digest(state, hash);
+}
+
+static void sha256_transform_x1(WORD state[][8], const BYTE data[][64])
+{
+	sha256_compress_scalar(state[0], data[0]);
+}
+
+static unsigned int sha256_search_x1(const WORD state[][8], const BYTE data[][64], int difficulty)
+{
+	return sha256_search_lanes(sha256_transform_x1, 1, state, data, difficulty);
+}
 
-	for (i = 0, j = 0; i < 16; ++i, j += 4)
-		m[i] = (data[j] << 24) | (data[j + 1] << 16) | (data[j + 2] << 8) | (data[j + 3]);
-	for ( ; i < 64; ++i)
-		m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
+static unsigned int sha256_search_shani(const WORD state[][8], const BYTE data[][64], int difficulty)
+{
+	return sha256_search_lanes(sha256_transform_shani, 2, state, data, difficulty);
+}
 
-	a = ctx->state[0];
-	b = ctx->state[1];
-	c = ctx->state[2];
-	d = ctx->state[3];
-	e = ctx->state[4];
-	f = ctx->state[5];
-	g = ctx->state[6];
-	h = ctx->state[7];
+void sha256_schedule_init(SHA256_SCHEDULE *s, const BYTE block[64], const int vary[2], const WORD base[8])
+{
+	WORD a, b, c, d, e, f, g, h, t1, t2;
+	int t, k;
 
-	for (i = 0; i < 64; ++i) {
-		t1 = h + EP1(e) + CH(e,f,g) + k[i] + m[i];
+	for (t = 0; t < 16; ++t) {
+		s->w[t] = (block[t * 4] << 24) | (block[t * 4 + 1] << 16) | (block[t * 4 + 2] << 8) | (block[t * 4 + 3]);
+		s->dyn[t] = 0;
+	}
+	for (k = 0; k < 2; ++k) {
+		if (vary[k] >= 0) {
+			s->dyn[vary[k]] = k == 0 ? SHA256_DYN_VARY0 : SHA256_DYN_VARY1;
+			s->w[vary[k]] = 0;
+		}
+	}
+
+	// Split every schedule word between its constant terms and the ones depending on a changing word
+	for (t = 16; t < 64; ++t) {
+		s->dyn[t] = 0;
+		s->w[t] = 0;
+		if (s->dyn[t - 2]) s->dyn[t] |= SHA256_DYN_SIG1; else s->w[t] += SIG1(s->w[t - 2]);
+		if (s->dyn[t - 7]) s->dyn[t] |= SHA256_DYN_M7; else s->w[t] += s->w[t - 7];
+		if (s->dyn[t - 15]) s->dyn[t] |= SHA256_DYN_SIG0; else s->w[t] += SIG0(s->w[t - 15]);
+		if (s->dyn[t - 16]) s->dyn[t] |= SHA256_DYN_M16; else s->w[t] += s->w[t - 16];
+	}
+	for (t = 0; t < 64; ++t)
+		s->kw[t] = sha256_k[t] + s->w[t];
+
+	// With a common chaining value, apply once the rounds preceding the first changing word
+	s->rounds = 0;
+	if (base == NULL)
+		return;
+	memcpy(s->base, base, sizeof(s->base));
+	a = base[0];
+	b = base[1];
+	c = base[2];
+	d = base[3];
+	e = base[4];
+	f = base[5];
+	g = base[6];
+	h = base[7];
+	for (t = 0; t < 64 && s->dyn[t] == 0; ++t) {
+		t1 = h + EP1(e) + CH(e,f,g) + s->kw[t];
 		t2 = EP0(a) + MAJ(a,b,c);
 		h = g;
 		g = f;
@@ -71,88 +263,321 @@ void sha256_transform(SHA256_CTX *ctx, const BYTE data[])
 		b = a;
 		a = t1 + t2;
 	}
+	s->rounds = t;
+	s->state[0] = a;
+	s->state[1] = b;
+	s->state[2] = c;
+	s->state[3] = d;
+	s->state[4] = e;
+	s->state[5] = f;
+	s->state[6] = g;
+	s->state[7] = h;
+}
+
+void sha256_schedule_block(const SHA256_SCHEDULE *s, const WORD vary[2], BYTE block[64])
+{
+	WORD w;
+	int t;
 
-	ctx->state[0] += a;
-	ctx->state[1] += b;
-	ctx->state[2] += c;
-	ctx->state[3] += d;
-	ctx->state[4] += e;
-	ctx->state[5] += f;
-	ctx->state[6] += g;
-	ctx->state[7] += h;
+	for (t = 0; t < 16; ++t) {
+		w = s->dyn[t] & SHA256_DYN_VARY0 ? vary[0] : s->dyn[t] & SHA256_DYN_VARY1 ? vary[1] : s->w[t];
+		block[t * 4] = w >> 24;
+		block[t * 4 + 1] = w >> 16;
+		block[t * 4 + 2] = w >> 8;
+		block[t * 4 + 3] = w;
+	}
+}
+
+// Precomputed schedules for kernels that can only take whole blocks: rebuild the blocks
+void sha256_transform_pre_lanes(void (*transform)(WORD state[][8], const BYTE data[][64]), int lanes,
+                                WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2])
+{
+	BYTE data[SHA256_MAX_LANES][64];
+	int l;
+
+	for (l = 0; l < lanes; ++l) {
+		sha256_schedule_block(s, vary[l], data[l]);
+		if (s->rounds > 0)
+			memcpy(state[l], s->base, sizeof(s->base));
+	}
+	transform(state, (const BYTE (*)[64])data);
+}
+
+unsigned int sha256_search_pre_lanes(void (*transform)(WORD state[][8], const BYTE data[][64]), int lanes,
+                                     const WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2], int difficulty)
+{
+	BYTE data[SHA256_MAX_LANES][64];
+	WORD in[SHA256_MAX_LANES][8];
+	int l;
+
+	for (l = 0; l < lanes; ++l) {
+		sha256_schedule_block(s, vary[l], data[l]);
+		memcpy(in[l], s->rounds > 0 ? s->base : state[l], sizeof(in[l]));
+	}
+	return sha256_search_lanes(transform, lanes, (const WORD (*)[8])in, (const BYTE (*)[64])data, difficulty);
+}
+
+// Run the rounds left by a precomputed schedule on the working variables v
+static void sha256_rounds_pre(WORD v[8], const SHA256_SCHEDULE *s, const WORD vary[2])
+{
+	WORD a, b, c, d, e, f, g, h, t1, m[64], kw[64];
+	int t;
+
+	// Complete the dynamic schedule words first, so the rounds only read kw
+	for (t = s->rounds; t < 64; ++t) {
+		if (s->dyn[t] == 0) {
+			kw[t] = s->kw[t];
+			continue;
+		}
+		if (s->dyn[t] & SHA256_DYN_VARY0)
+			m[t] = vary[0];
+		else if (s->dyn[t] & SHA256_DYN_VARY1)
+			m[t] = vary[1];
+		else {
+			m[t] = s->w[t];
+			if (s->dyn[t] & SHA256_DYN_SIG1) m[t] += SIG1(m[t - 2]);
+			if (s->dyn[t] & SHA256_DYN_M7) m[t] += m[t - 7];
+			if (s->dyn[t] & SHA256_DYN_SIG0) m[t] += SIG0(m[t - 15]);
+			if (s->dyn[t] & SHA256_DYN_M16) m[t] += m[t - 16];
+		}
+		kw[t] = sha256_k[t] + m[t];
+	}
+
+	a = v[0];
+	b = v[1];
+	c = v[2];
+	d = v[3];
+	e = v[4];
+	f = v[5];
+	g = v[6];
+	h = v[7];
+
+	// Shift the variables up to a multiple of 8 rounds, the rest is unrolled
+	for (t = s->rounds; t % 8 != 0; ++t) {
+		ROUND(a,b,c,d,e,f,g,h, kw[t]);
+		t1 = h;
+		h = g;
+		g = f;
+		f = e;
+		e = d;
+		d = c;
+		c = b;
+		b = a;
+		a = t1;
+	}
+#define KW_PRE(t) kw[t]
+	for (; t < 64; t += 8) {
+		ROUNDS8(t, KW_PRE);
+	}
+#undef KW_PRE
+
+	v[0] = a;
+	v[1] = b;
+	v[2] = c;
+	v[3] = d;
+	v[4] = e;
+	v[5] = f;
+	v[6] = g;
+	v[7] = h;
+}
+
+static void sha256_transform_pre_x1(WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2])
+{
+	WORD v[8];
+	int i;
+
+	memcpy(v, s->rounds > 0 ? s->state : state[0], sizeof(v));
+	sha256_rounds_pre(v, s, vary[0]);
+	for (i = 0; i < 8; ++i)
+		state[0][i] = (s->rounds > 0 ? s->base[i] : state[0][i]) + v[i];
+}
+
+static unsigned int sha256_search_pre_x1(const WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2], int difficulty)
+{
+	const WORD *in = s->rounds > 0 ? s->base : state[0];
+	WORD v[8], mask[2], expected[2];
+
+	memcpy(v, s->rounds > 0 ? s->state : state[0], sizeof(v));
+	sha256_rounds_pre(v, s, vary[0]);
+	sha256_difficulty_mask(difficulty, mask, expected);
+	return ((in[0] + v[0]) & mask[0]) == expected[0] && ((in[1] + v[1]) & mask[1]) == expected[1];
+}
+
+static void sha256_transform_pre_shani(WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2])
+{
+	sha256_transform_pre_lanes(sha256_transform_shani, 2, state, s, vary);
+}
+
+static unsigned int sha256_search_pre_shani(const WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2], int difficulty)
+{
+	return sha256_search_pre_lanes(sha256_transform_shani, 2, state, s, vary, difficulty);
+}
+
+static int sha256_scalar_supported(void)
+{
+	return 1;
+}
+
+/**************************** KERNELS *******************************/
+static const SHA256_KERNEL sha256_kernel_scalar = {"scalar", 1, sha256_scalar_supported, sha256_transform_x1, sha256_search_x1,
+                                                 sha256_transform_pre_x1, sha256_search_pre_x1};
+static const SHA256_KERNEL sha256_kernel_shani = {"shani", 2, sha256_shani_supported, sha256_transform_shani, sha256_search_shani,
+                                                sha256_transform_pre_shani, sha256_search_pre_shani};
+static const SHA256_KERNEL sha256_kernel_avx2 = {"avx2", 8, sha256_avx2_supported, sha256_transform_avx2, sha256_search_avx2,
+                                               sha256_transform_pre_avx2, sha256_search_pre_avx2};
+static const SHA256_KERNEL sha256_kernel_avx512 = {"avx512", 16, sha256_avx512_supported, sha256_transform_avx512, sha256_search_avx512,
+                                                 sha256_transform_pre_avx512, sha256_search_pre_avx512};
+
+// Known kernels, by order of preference
+const SHA256_KERNEL *const sha256_kernels[] = {
+	&sha256_kernel_avx512,
+	&sha256_kernel_shani,
+	&sha256_kernel_avx2,
+	&sha256_kernel_scalar,
+	NULL
+};
+
+void sha256_difficulty_mask(int difficulty, WORD mask[2], WORD expected[2])
+{
+	// The digest must start with `difficulty` zero bits followed by a one bit
+	if (difficulty < 32) {
+		mask[0] = 0xffffffff << (31 - difficulty);
+		expected[0] = 0x80000000 >> difficulty;
+		mask[1] = expected[1] = 0;
+	}
+	else if (difficulty < 64) {
+		mask[0] = 0xffffffff;
+		expected[0] = 0;
+		mask[1] = 0xffffffff << (63 - difficulty);
+		expected[1] = 0x80000000 >> (difficulty - 32);
+	}
+	else {
+		// Beyond the first two words, only reject what is certainly wrong
+		mask[0] = mask[1] = 0xffffffff;
+		expected[0] = expected[1] = 0;
+	}
+}
+
+unsigned int sha256_search_lanes(void (*transform)(WORD state[][8], const BYTE data[][64]), int lanes,
+                                 const WORD state[][8], const BYTE data[][64], int difficulty)
+{
+	WORD out[SHA256_MAX_LANES][8], mask[2], expected[2];
+	unsigned int found = 0;
+	int l;
+
+	memcpy(out, state, lanes * sizeof(out[0]));
+	transform(out, data);
+	sha256_difficulty_mask(difficulty, mask, expected);
+	for (l = 0; l < lanes; ++l) {
+		if ((out[l][0] & mask[0]) == expected[0] && (out[l][1] & mask[1]) == expected[1])
+			found |= 1u << l;
+	}
+	return found;
+}
+
+const SHA256_KERNEL *sha256_kernel_best(void)
+{
+	int i;
+
+	for (i = 0; sha256_kernels[i] != NULL; ++i) {
+		if (sha256_kernels[i]->supported())
+			return sha256_kernels[i];
+	}
+	return &sha256_kernel_scalar;
+}
+
+const SHA256_KERNEL *sha256_kernel_find(const char *name)
+{
+	int i;
+
+	for (i = 0; sha256_kernels[i] != NULL; ++i) {
+		if (strcmp(sha256_kernels[i]->name, name) == 0)
+			return sha256_kernels[i];
+	}
+	return NULL;
 }
 
 void sha256_init(SHA256_CTX *ctx)
 {
 	ctx->datalen = 0;
 	ctx->bitlen = 0;
-	ctx->state[0] = 0x6a09e667;
-	ctx->state[1] = 0xbb67ae85;
-	ctx->state[2] = 0x3c6ef372;
-	ctx->state[3] = 0xa54ff53a;
-	ctx->state[4] = 0x510e527f;
-	ctx->state[5] = 0x9b05688c;
-	ctx->state[6] = 0x1f83d9ab;
-	ctx->state[7] = 0x5be0cd19;
+	sha256_init_state(ctx->state);
 }
 
-void sha256_update(SHA256_CTX *ctx, const BYTE data[], size_t len)
+void sha256_init_state(WORD state[8])
+{
+	state[0] = 0x6a09e667;
+	state[1] = 0xbb67ae85;
+	state[2] = 0x3c6ef372;
+	state[3] = 0xa54ff53a;
+	state[4] = 0x510e527f;
+	state[5] = 0x9b05688c;
+	state[6] = 0x1f83d9ab;
+	state[7] = 0x5be0cd19;
+}
+
+void sha256_state_digest(const WORD state[8], BYTE hash[])
 {
 	WORD i;
 
-	for (i = 0; i < len; ++i) {
-		ctx->data[ctx->datalen] = data[i];
-		ctx->datalen++;
-		if (ctx->datalen == 64) {
-			sha256_transform(ctx, ctx->data);
-			ctx->bitlen += 512;
-			ctx->datalen = 0;
-		}
+	for (i = 0; i < 4; ++i) {
+		hash[i]      = (state[0] >> (24 - i * 8)) & 0x000000ff;
+		hash[i + 4]  = (state[1] >> (24 - i * 8)) & 0x000000ff;
+		hash[i + 8]  = (state[2] >> (24 - i * 8)) & 0x000000ff;
+		hash[i + 12] = (state[3] >> (24 - i * 8)) & 0x000000ff;
+		hash[i + 16] = (state[4] >> (24 - i * 8)) & 0x000000ff;
+		hash[i + 20] = (state[5] >> (24 - i * 8)) & 0x000000ff;
+		hash[i + 24] = (state[6] >> (24 - i * 8)) & 0x000000ff;
+		hash[i + 28] = (state[7] >> (24 - i * 8)) & 0x000000ff;
 	}
 }
 
-void sha256_final(SHA256_CTX *ctx, BYTE hash[])
+void sha256_update(SHA256_CTX *ctx, const BYTE data[], size_t len)
 {
-	WORD i;
+	size_t fill;
 
-	i = ctx->datalen;
-
-	// Pad whatever data is left in the buffer.
-	if (ctx->datalen < 56) {
-		ctx->data[i++] = 0x80;
-		while (i < 56)
-			ctx->data[i++] = 0x00;
+	// Complete the buffered block, then hash the whole blocks in place
+	if (ctx->datalen > 0) {
+		fill = 64 - ctx->datalen < len ? 64 - ctx->datalen : len;
+		memcpy(&ctx->data[ctx->datalen], data, fill);
+		ctx->datalen += fill;
+		data += fill;
+		len -= fill;
+		if (ctx->datalen < 64)
+			return;
+		sha256_transform(ctx, ctx->data);
+		ctx->bitlen += 512;
+		ctx->datalen = 0;
 	}
-	else {
-		ctx->data[i++] = 0x80;
-		while (i < 64)
-			ctx->data[i++] = 0x00;
+	for (; len >= 64; data += 64, len -= 64) {
+		sha256_transform(ctx, data);
+		ctx->bitlen += 512;
+	}
+	memcpy(ctx->data, data, len);
+	ctx->datalen = len;
+}
+
+void sha256_final(SHA256_CTX *ctx, BYTE hash[])
+{
+	WORD i = ctx->datalen;
+	int j;
+
+	// Pad whatever data is left in the buffer, with a block more if the length does not fit.
+	ctx->data[i++] = 0x80;
+	if (i > 56) {
+		memset(&ctx->data[i], 0, 64 - i);
 		sha256_transform(ctx, ctx->data);
-		memset(ctx->data, 0, 56);
+		i = 0;
 	}
+	memset(&ctx->data[i], 0, 56 - i);
 
 	// Append to the padding the total message's length in bits and transform.
 	ctx->bitlen += ctx->datalen * 8;
-	ctx->data[63] = ctx->bitlen;
-	ctx->data[62] = ctx->bitlen >> 8;
-	ctx->data[61] = ctx->bitlen >> 16;
-	ctx->data[60] = ctx->bitlen >> 24;
-	ctx->data[59] = ctx->bitlen >> 32;
-	ctx->data[58] = ctx->bitlen >> 40;
-	ctx->data[57] = ctx->bitlen >> 48;
-	ctx->data[56] = ctx->bitlen >> 56;
+	for (j = 0; j < 8; ++j)
+		ctx->data[63 - j] = (BYTE)(ctx->bitlen >> (j * 8));
 	sha256_transform(ctx, ctx->data);
 
 	// Since this implementation uses little endian byte ordering and SHA uses big endian,
 	// reverse all the bytes when copying the final state to the output hash.
-	for (i = 0; i < 4; ++i) {
-		hash[i]      = (ctx->state[0] >> (24 - i * 8)) & 0x000000ff;
-		hash[i + 4]  = (ctx->state[1] >> (24 - i * 8)) & 0x000000ff;
-		hash[i + 8]  = (ctx->state[2] >> (24 - i * 8)) & 0x000000ff;
-		hash[i + 12] = (ctx->state[3] >> (24 - i * 8)) & 0x000000ff;
-		hash[i + 16] = (ctx->state[4] >> (24 - i * 8)) & 0x000000ff;
-		hash[i + 20] = (ctx->state[5] >> (24 - i * 8)) & 0x000000ff;
-		hash[i + 24] = (ctx->state[6] >> (24 - i * 8)) & 0x000000ff;
-		hash[i + 28] = (ctx->state[7] >> (24 - i * 8)) & 0x000000ff;
-	}
+	sha256_state_digest(ctx->state, hash);
 }
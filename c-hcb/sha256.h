@@ -12,8 +12,13 @@
 /*************************** HEADER FILES ***************************/
 #include <stddef.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /****************************** MACROS ******************************/
 #define SHA256_BLOCK_SIZE 32            // SHA256 outputs a 32 byte digest
+#define SHA256_MAX_LANES 16             // Widest multi-buffer kernel
 
 /**************************** DATA TYPES ****************************/
 typedef unsigned char BYTE;             // 8-bit byte
@@ -26,9 +31,88 @@ typedef struct {
 	WORD state[8];
 } SHA256_CTX;
 
+// Message schedule of a block where only one or two words change from one lane to another.
+// Everything that does not depend on them is computed once by sha256_schedule_init:
+// the constant schedule words already added to their round constant, the constant part of
+// the other schedule words, and the rounds that come before the first changing word.
+#define SHA256_DYN_SIG1  0x01           // w[t] depends on SIG1(w[t-2])
+#define SHA256_DYN_M7    0x02           // w[t] depends on w[t-7]
+#define SHA256_DYN_SIG0  0x04           // w[t] depends on SIG0(w[t-15])
+#define SHA256_DYN_M16   0x08           // w[t] depends on w[t-16]
+#define SHA256_DYN_VARY0 0x10           // w[t] is the first changing word
+#define SHA256_DYN_VARY1 0x20           // w[t] is the second changing word
+
+typedef struct {
+	int rounds;                         // Rounds already applied to state, 0 if every lane has its own state
+	WORD base[8];                       // Chaining value shared by every lane when rounds > 0
+	WORD state[8];                      // Working variables after the first `rounds` rounds
+	BYTE dyn[64];                       // SHA256_DYN_* flags, 0 for a constant word
+	WORD w[64];                         // Constant word, or constant part of a dynamic one
+	WORD kw[64];                        // sha256_k[t] + w[t]
+} SHA256_SCHEDULE;
+
+// Compression kernel hashing one block for each of `lanes` independent states at once
+typedef struct {
+	const char *name;
+	int lanes;
+	int (*supported)(void);
+	void (*transform)(WORD state[][8], const BYTE data[][64]);
+	// Compresses the last block of each lane and returns the mask of the lanes whose digest
+	// starts with exactly `difficulty` zero bits, without writing the states back.
+	// Only the first 64 bits of the digest are tested, so a difficulty of 64 or more only
+	// reports candidates that must be confirmed on the full digest.
+	unsigned int (*search)(const WORD state[][8], const BYTE data[][64], int difficulty);
+	// Same as transform and search for a block described by a precomputed schedule, vary[l]
+	// holding the changing words of lane l. The input states are ignored when s->rounds > 0.
+	void (*transform_pre)(WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2]);
+	unsigned int (*search_pre)(const WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2], int difficulty);
+} SHA256_KERNEL;
+
 /*********************** FUNCTION DECLARATIONS **********************/
 void sha256_init(SHA256_CTX *ctx);
 void sha256_update(SHA256_CTX *ctx, const BYTE data[], size_t len);
 void sha256_final(SHA256_CTX *ctx, BYTE hash[]);
+void sha256_init_state(WORD state[8]);
+void sha256_state_digest(const WORD state[8], BYTE hash[]);
+void sha256_compress(WORD state[8], const BYTE data[]);   // Fastest single buffer compression
+void sha256_compress_scalar(WORD state[8], const BYTE data[]);
+void sha256_digest_hcb(const BYTE message[], const BYTE nonce[], BYTE hash[]);  // "message\nnonce", 64 bytes each
+void sha256_digest_hcb_scalar(const BYTE message[], const BYTE nonce[], BYTE hash[]);   // Same, scalar with the last block folded
+
+/***************************** KERNELS ******************************/
+extern const WORD sha256_k[64];
+extern const SHA256_KERNEL *const sha256_kernels[];   // NULL terminated, by order of preference
+
+const SHA256_KERNEL *sha256_kernel_best(void);        // Fastest kernel supported by the CPU
+const SHA256_KERNEL *sha256_kernel_find(const char *name);
+
+void sha256_difficulty_mask(int difficulty, WORD mask[2], WORD expected[2]);   // Test for the first two state words
+unsigned int sha256_search_lanes(void (*transform)(WORD state[][8], const BYTE data[][64]), int lanes,
+                                 const WORD state[][8], const BYTE data[][64], int difficulty);
+
+void sha256_schedule_init(SHA256_SCHEDULE *s, const BYTE block[64], const int vary[2], const WORD base[8]);
+void sha256_schedule_block(const SHA256_SCHEDULE *s, const WORD vary[2], BYTE block[64]);
+void sha256_transform_pre_lanes(void (*transform)(WORD state[][8], const BYTE data[][64]), int lanes,
+                                WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2]);
+unsigned int sha256_search_pre_lanes(void (*transform)(WORD state[][8], const BYTE data[][64]), int lanes,
+                                     const WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2], int difficulty);
+
+int sha256_shani_supported(void);
+void sha256_compress_shani(WORD state[8], const BYTE data[]);
+void sha256_transform_shani(WORD state[][8], const BYTE data[][64]);
+int sha256_avx2_supported(void);
+void sha256_transform_avx2(WORD state[][8], const BYTE data[][64]);
+unsigned int sha256_search_avx2(const WORD state[][8], const BYTE data[][64], int difficulty);
+void sha256_transform_pre_avx2(WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2]);
+unsigned int sha256_search_pre_avx2(const WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2], int difficulty);
+int sha256_avx512_supported(void);
+void sha256_transform_avx512(WORD state[][8], const BYTE data[][64]);
+unsigned int sha256_search_avx512(const WORD state[][8], const BYTE data[][64], int difficulty);
+void sha256_transform_pre_avx512(WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2]);
+unsigned int sha256_search_pre_avx512(const WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2], int difficulty);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif   // SHA256_H
@@ -0,0 +1,262 @@
+/*********************************************************************
+* Filename:   sha256_avx2.c
+* Details:    Multi-buffer SHA-256 compression using AVX2.
+              Each 32-bit lane of a 256-bit register holds the same
+              word of a different message, so 8 independent blocks
+              are compressed by one call. The output is identical to
+              sha256_compress applied to each block.
+*********************************************************************/
+
+/*************************** HEADER FILES ***************************/
+#include "sha256.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+/****************************** MACROS ******************************/
+#define LANES 8
+#define AVX2 __attribute__((target("avx2")))
+
+#define ADD(a,b) _mm256_add_epi32((a),(b))
+#define XOR(a,b) _mm256_xor_si256((a),(b))
+#define AND(a,b) _mm256_and_si256((a),(b))
+#define OR(a,b) _mm256_or_si256((a),(b))
+#define ROTRIGHT(a,b) OR(_mm256_srli_epi32((a),(b)), _mm256_slli_epi32((a),32-(b)))
+
+#define CH(x,y,z) XOR(AND((x),(y)), _mm256_andnot_si256((x),(z)))
+#define MAJ(x,y,z) OR(AND((x),(y)), AND((z), OR((x),(y))))
+#define EP0(x) XOR(XOR(ROTRIGHT(x,2),ROTRIGHT(x,13)),ROTRIGHT(x,22))
+#define EP1(x) XOR(XOR(ROTRIGHT(x,6),ROTRIGHT(x,11)),ROTRIGHT(x,25))
+#define SIG0(x) XOR(XOR(ROTRIGHT(x,7),ROTRIGHT(x,18)),_mm256_srli_epi32((x),3))
+#define SIG1(x) XOR(XOR(ROTRIGHT(x,17),ROTRIGHT(x,19)),_mm256_srli_epi32((x),10))
+
+/*********************** FUNCTION DEFINITIONS ***********************/
+int sha256_avx2_supported(void)
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+}
+
+// Run the 64 rounds on the working variables v[0..7] (a..h) for one block per lane
+AVX2 static inline void sha256_rounds_avx2(__m256i v[8], const BYTE data[][64])
+{
+	__m256i a, b, c, d, e, f, g, h, t1, t2, m[16];
+	const __m256i bswap = _mm256_set_epi8(12,13,14,15, 8,9,10,11, 4,5,6,7, 0,1,2,3,
+	                                      12,13,14,15, 8,9,10,11, 4,5,6,7, 0,1,2,3);
+	const __m256i block_index = _mm256_setr_epi32(0, 16, 32, 48, 64, 80, 96, 112);
+	int i;
+
+	// Gather word i of every block, converting it from big endian
+	for (i = 0; i < 16; ++i)
+		m[i] = _mm256_shuffle_epi8(_mm256_i32gather_epi32((const int *)data + i, block_index, 4), bswap);
+
+	a = v[0];
+	b = v[1];
+	c = v[2];
+	d = v[3];
+	e = v[4];
+	f = v[5];
+	g = v[6];
+	h = v[7];
+
+	for (i = 0; i < 64; ++i) {
+		if (i >= 16)
+			m[i & 15] = ADD(ADD(SIG1(m[(i - 2) & 15]), m[(i - 7) & 15]), ADD(SIG0(m[(i - 15) & 15]), m[i & 15]));
+		t1 = ADD(ADD(ADD(h, EP1(e)), ADD(CH(e,f,g), _mm256_set1_epi32(sha256_k[i]))), m[i & 15]);
+		t2 = ADD(EP0(a), MAJ(a,b,c));
+		h = g;
+		g = f;
+		f = e;
+		e = ADD(d, t1);
+		d = c;
+		c = b;
+		b = a;
+		a = ADD(t1, t2);
+	}
+
+	v[0] = a;
+	v[1] = b;
+	v[2] = c;
+	v[3] = d;
+	v[4] = e;
+	v[5] = f;
+	v[6] = g;
+	v[7] = h;
+}
+
+AVX2 void sha256_transform_avx2(WORD state[][8], const BYTE data[][64])
+{
+	__m256i s[8], v[8];
+	const __m256i state_index = _mm256_setr_epi32(0, 8, 16, 24, 32, 40, 48, 56);
+	WORD out[LANES];
+	int i, l;
+
+	for (i = 0; i < 8; ++i)
+		v[i] = s[i] = _mm256_i32gather_epi32((const int *)state + i, state_index, 4);
+
+	sha256_rounds_avx2(v, data);
+
+	// Scatter the new states back to their lanes
+	for (i = 0; i < 8; ++i) {
+		_mm256_storeu_si256((__m256i *)out, ADD(s[i], v[i]));
+		for (l = 0; l < LANES; ++l)
+			state[l][i] = out[l];
+	}
+}
+
+AVX2 unsigned int sha256_search_avx2(const WORD state[][8], const BYTE data[][64], int difficulty)
+{
+	__m256i s[8], v[8], ok;
+	const __m256i state_index = _mm256_setr_epi32(0, 8, 16, 24, 32, 40, 48, 56);
+	WORD mask[2], expected[2];
+	int i;
+
+	for (i = 0; i < 8; ++i)
+		v[i] = s[i] = _mm256_i32gather_epi32((const int *)state + i, state_index, 4);
+
+	sha256_rounds_avx2(v, data);
+
+	// Only the first two words of the digest can decide the difficulty
+	sha256_difficulty_mask(difficulty, mask, expected);
+	ok = _mm256_cmpeq_epi32(AND(ADD(s[0], v[0]), _mm256_set1_epi32(mask[0])), _mm256_set1_epi32(expected[0]));
+	if (mask[1] != 0)
+		ok = AND(ok, _mm256_cmpeq_epi32(AND(ADD(s[1], v[1]), _mm256_set1_epi32(mask[1])), _mm256_set1_epi32(expected[1])));
+	return (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(ok));
+}
+
+// Run the rounds left by a precomputed schedule on the working variables v[0..7]
+AVX2 static inline void sha256_rounds_pre_avx2(__m256i v[8], const SHA256_SCHEDULE *s, const WORD vary[][2])
+{
+	__m256i a, b, c, d, e, f, g, h, t1, t2, kw, vary0, vary1, m[64];
+	const __m256i vary_index = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+	int t;
+
+	vary0 = _mm256_i32gather_epi32((const int *)vary, vary_index, 4);
+	vary1 = _mm256_i32gather_epi32((const int *)vary + 1, vary_index, 4);
+
+	a = v[0];
+	b = v[1];
+	c = v[2];
+	d = v[3];
+	e = v[4];
+	f = v[5];
+	g = v[6];
+	h = v[7];
+
+	for (t = s->rounds; t < 64; ++t) {
+		if (s->dyn[t] == 0) {
+			kw = _mm256_set1_epi32(s->kw[t]);
+		}
+		else {
+			if (s->dyn[t] & SHA256_DYN_VARY0)
+				m[t] = vary0;
+			else if (s->dyn[t] & SHA256_DYN_VARY1)
+				m[t] = vary1;
+			else {
+				m[t] = _mm256_set1_epi32(s->w[t]);
+				if (s->dyn[t] & SHA256_DYN_SIG1) m[t] = ADD(m[t], SIG1(m[t - 2]));
+				if (s->dyn[t] & SHA256_DYN_M7) m[t] = ADD(m[t], m[t - 7]);
+				if (s->dyn[t] & SHA256_DYN_SIG0) m[t] = ADD(m[t], SIG0(m[t - 15]));
+				if (s->dyn[t] & SHA256_DYN_M16) m[t] = ADD(m[t], m[t - 16]);
+			}
+			kw = ADD(m[t], _mm256_set1_epi32(sha256_k[t]));
+		}
+		t1 = ADD(ADD(h, EP1(e)), ADD(CH(e,f,g), kw));
+		t2 = ADD(EP0(a), MAJ(a,b,c));
+		h = g;
+		g = f;
+		f = e;
+		e = ADD(d, t1);
+		d = c;
+		c = b;
+		b = a;
+		a = ADD(t1, t2);
+	}
+
+	v[0] = a;
+	v[1] = b;
+	v[2] = c;
+	v[3] = d;
+	v[4] = e;
+	v[5] = f;
+	v[6] = g;
+	v[7] = h;
+}
+
+// Input states of the lanes: the common chaining value when rounds were precomputed
+AVX2 static inline void sha256_load_pre_avx2(__m256i in[8], __m256i v[8], const WORD state[][8], const SHA256_SCHEDULE *s)
+{
+	const __m256i state_index = _mm256_setr_epi32(0, 8, 16, 24, 32, 40, 48, 56);
+	int i;
+
+	for (i = 0; i < 8; ++i) {
+		if (s->rounds > 0) {
+			in[i] = _mm256_set1_epi32(s->base[i]);
+			v[i] = _mm256_set1_epi32(s->state[i]);
+		}
+		else
+			v[i] = in[i] = _mm256_i32gather_epi32((const int *)state + i, state_index, 4);
+	}
+}
+
+AVX2 void sha256_transform_pre_avx2(WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2])
+{
+	__m256i in[8], v[8];
+	WORD out[LANES];
+	int i, l;
+
+	sha256_load_pre_avx2(in, v, (const WORD (*)[8])state, s);
+	sha256_rounds_pre_avx2(v, s, vary);
+	for (i = 0; i < 8; ++i) {
+		_mm256_storeu_si256((__m256i *)out, ADD(in[i], v[i]));
+		for (l = 0; l < LANES; ++l)
+			state[l][i] = out[l];
+	}
+}
+
+AVX2 unsigned int sha256_search_pre_avx2(const WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2], int difficulty)
+{
+	__m256i in[8], v[8], ok;
+	WORD mask[2], expected[2];
+
+	sha256_load_pre_avx2(in, v, state, s);
+	sha256_rounds_pre_avx2(v, s, vary);
+	sha256_difficulty_mask(difficulty, mask, expected);
+	ok = _mm256_cmpeq_epi32(AND(ADD(in[0], v[0]), _mm256_set1_epi32(mask[0])), _mm256_set1_epi32(expected[0]));
+	if (mask[1] != 0)
+		ok = AND(ok, _mm256_cmpeq_epi32(AND(ADD(in[1], v[1]), _mm256_set1_epi32(mask[1])), _mm256_set1_epi32(expected[1])));
+	return (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(ok));
+}
+
+#else
+
+int sha256_avx2_supported(void)
+{
+	return 0;
+}
+
+void sha256_transform_avx2(WORD state[][8], const BYTE data[][64])
+{
+	int l;
+
+	for (l = 0; l < 8; ++l)
+		sha256_compress_scalar(state[l], data[l]);
+}
+
+unsigned int sha256_search_avx2(const WORD state[][8], const BYTE data[][64], int difficulty)
+{
+	return sha256_search_lanes(sha256_transform_avx2, 8, state, data, difficulty);
+}
+
+void sha256_transform_pre_avx2(WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2])
+{
+	sha256_transform_pre_lanes(sha256_transform_avx2, 8, state, s, vary);
+}
+
+unsigned int sha256_search_pre_avx2(const WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2], int difficulty)
+{
+	return sha256_search_pre_lanes(sha256_transform_avx2, 8, state, s, vary, difficulty);
+}
+
+#endif
@@ -0,0 +1,264 @@
+/*********************************************************************
+* Filename:   sha256_avx512.c
+* Details:    Multi-buffer SHA-256 compression using AVX-512.
+              Same layout as sha256_avx2.c with 16 lanes, native
+              rotations and ternary logic for the CH and MAJ
+              functions.
+*********************************************************************/
+
+/*************************** HEADER FILES ***************************/
+#include "sha256.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+/****************************** MACROS ******************************/
+#define LANES 16
+#define AVX512 __attribute__((target("avx512f")))
+
+#define ADD(a,b) _mm512_add_epi32((a),(b))
+#define ROTRIGHT(a,b) _mm512_ror_epi32((a),(b))
+#define XOR3(a,b,c) _mm512_ternarylogic_epi32((a),(b),(c),0x96)
+
+#define CH(x,y,z) _mm512_ternarylogic_epi32((x),(y),(z),0xCA)
+#define MAJ(x,y,z) _mm512_ternarylogic_epi32((x),(y),(z),0xE8)
+#define EP0(x) XOR3(ROTRIGHT(x,2),ROTRIGHT(x,13),ROTRIGHT(x,22))
+#define EP1(x) XOR3(ROTRIGHT(x,6),ROTRIGHT(x,11),ROTRIGHT(x,25))
+#define SIG0(x) XOR3(ROTRIGHT(x,7),ROTRIGHT(x,18),_mm512_srli_epi32((x),3))
+#define SIG1(x) XOR3(ROTRIGHT(x,17),ROTRIGHT(x,19),_mm512_srli_epi32((x),10))
+
+/*********************** FUNCTION DEFINITIONS ***********************/
+int sha256_avx512_supported(void)
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx512f");
+}
+
+// Convert the 16 words of a register from big endian (AVX-512F has no byte shuffle)
+AVX512 static inline __m512i bswap(__m512i x)
+{
+	x = _mm512_or_si512(_mm512_slli_epi32(x, 16), _mm512_srli_epi32(x, 16));
+	return _mm512_or_si512(_mm512_slli_epi32(_mm512_and_si512(x, _mm512_set1_epi32(0x00ff00ff)), 8),
+	                       _mm512_and_si512(_mm512_srli_epi32(x, 8), _mm512_set1_epi32(0x00ff00ff)));
+}
+
+// Run the 64 rounds on the working variables v[0..7] (a..h) for one block per lane
+AVX512 static inline void sha256_rounds_avx512(__m512i v[8], const BYTE data[][64])
+{
+	__m512i a, b, c, d, e, f, g, h, t1, t2, m[16];
+	const __m512i block_index = _mm512_setr_epi32(0, 16, 32, 48, 64, 80, 96, 112,
+	                                              128, 144, 160, 176, 192, 208, 224, 240);
+	int i;
+
+	// Gather word i of every block, converting it from big endian
+	for (i = 0; i < 16; ++i)
+		m[i] = bswap(_mm512_i32gather_epi32(block_index, (const int *)data + i, 4));
+
+	a = v[0];
+	b = v[1];
+	c = v[2];
+	d = v[3];
+	e = v[4];
+	f = v[5];
+	g = v[6];
+	h = v[7];
+
+	for (i = 0; i < 64; ++i) {
+		if (i >= 16)
+			m[i & 15] = ADD(ADD(SIG1(m[(i - 2) & 15]), m[(i - 7) & 15]), ADD(SIG0(m[(i - 15) & 15]), m[i & 15]));
+		t1 = ADD(ADD(ADD(h, EP1(e)), ADD(CH(e,f,g), _mm512_set1_epi32(sha256_k[i]))), m[i & 15]);
+		t2 = ADD(EP0(a), MAJ(a,b,c));
+		h = g;
+		g = f;
+		f = e;
+		e = ADD(d, t1);
+		d = c;
+		c = b;
+		b = a;
+		a = ADD(t1, t2);
+	}
+
+	v[0] = a;
+	v[1] = b;
+	v[2] = c;
+	v[3] = d;
+	v[4] = e;
+	v[5] = f;
+	v[6] = g;
+	v[7] = h;
+}
+
+AVX512 void sha256_transform_avx512(WORD state[][8], const BYTE data[][64])
+{
+	__m512i s[8], v[8];
+	const __m512i state_index = _mm512_setr_epi32(0, 8, 16, 24, 32, 40, 48, 56,
+	                                              64, 72, 80, 88, 96, 104, 112, 120);
+	int i;
+
+	for (i = 0; i < 8; ++i)
+		v[i] = s[i] = _mm512_i32gather_epi32(state_index, (const int *)state + i, 4);
+
+	sha256_rounds_avx512(v, data);
+
+	for (i = 0; i < 8; ++i)
+		_mm512_i32scatter_epi32((int *)state + i, state_index, ADD(s[i], v[i]), 4);
+}
+
+AVX512 unsigned int sha256_search_avx512(const WORD state[][8], const BYTE data[][64], int difficulty)
+{
+	__m512i s[8], v[8];
+	const __m512i state_index = _mm512_setr_epi32(0, 8, 16, 24, 32, 40, 48, 56,
+	                                              64, 72, 80, 88, 96, 104, 112, 120);
+	__mmask16 ok;
+	WORD mask[2], expected[2];
+	int i;
+
+	for (i = 0; i < 8; ++i)
+		v[i] = s[i] = _mm512_i32gather_epi32(state_index, (const int *)state + i, 4);
+
+	sha256_rounds_avx512(v, data);
+
+	// Only the first two words of the digest can decide the difficulty
+	sha256_difficulty_mask(difficulty, mask, expected);
+	ok = _mm512_cmpeq_epi32_mask(_mm512_and_si512(ADD(s[0], v[0]), _mm512_set1_epi32(mask[0])), _mm512_set1_epi32(expected[0]));
+	if (mask[1] != 0)
+		ok &= _mm512_cmpeq_epi32_mask(_mm512_and_si512(ADD(s[1], v[1]), _mm512_set1_epi32(mask[1])), _mm512_set1_epi32(expected[1]));
+	return ok;
+}
+
+// Run the rounds left by a precomputed schedule on the working variables v[0..7]
+AVX512 static inline void sha256_rounds_pre_avx512(__m512i v[8], const SHA256_SCHEDULE *s, const WORD vary[][2])
+{
+	__m512i a, b, c, d, e, f, g, h, t1, t2, kw, vary0, vary1, m[64];
+	const __m512i vary_index = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+	int t;
+
+	vary0 = _mm512_i32gather_epi32(vary_index, (const int *)vary, 4);
+	vary1 = _mm512_i32gather_epi32(vary_index, (const int *)vary + 1, 4);
+
+	a = v[0];
+	b = v[1];
+	c = v[2];
+	d = v[3];
+	e = v[4];
+	f = v[5];
+	g = v[6];
+	h = v[7];
+
+	for (t = s->rounds; t < 64; ++t) {
+		if (s->dyn[t] == 0) {
+			kw = _mm512_set1_epi32(s->kw[t]);
+		}
+		else {
+			if (s->dyn[t] & SHA256_DYN_VARY0)
+				m[t] = vary0;
+			else if (s->dyn[t] & SHA256_DYN_VARY1)
+				m[t] = vary1;
+			else {
+				m[t] = _mm512_set1_epi32(s->w[t]);
+				if (s->dyn[t] & SHA256_DYN_SIG1) m[t] = ADD(m[t], SIG1(m[t - 2]));
+				if (s->dyn[t] & SHA256_DYN_M7) m[t] = ADD(m[t], m[t - 7]);
+				if (s->dyn[t] & SHA256_DYN_SIG0) m[t] = ADD(m[t], SIG0(m[t - 15]));
+				if (s->dyn[t] & SHA256_DYN_M16) m[t] = ADD(m[t], m[t - 16]);
+			}
+			kw = ADD(m[t], _mm512_set1_epi32(sha256_k[t]));
+		}
+		t1 = ADD(ADD(h, EP1(e)), ADD(CH(e,f,g), kw));
+		t2 = ADD(EP0(a), MAJ(a,b,c));
+		h = g;
+		g = f;
+		f = e;
+		e = ADD(d, t1);
+		d = c;
+		c = b;
+		b = a;
+		a = ADD(t1, t2);
+	}
+
+	v[0] = a;
+	v[1] = b;
+	v[2] = c;
+	v[3] = d;
+	v[4] = e;
+	v[5] = f;
+	v[6] = g;
+	v[7] = h;
+}
+
+// Input states of the lanes: the common chaining value when rounds were precomputed
+AVX512 static inline void sha256_load_pre_avx512(__m512i in[8], __m512i v[8], const WORD state[][8], const SHA256_SCHEDULE *s)
+{
+	const __m512i state_index = _mm512_setr_epi32(0, 8, 16, 24, 32, 40, 48, 56,
+	                                              64, 72, 80, 88, 96, 104, 112, 120);
+	int i;
+
+	for (i = 0; i < 8; ++i) {
+		if (s->rounds > 0) {
+			in[i] = _mm512_set1_epi32(s->base[i]);
+			v[i] = _mm512_set1_epi32(s->state[i]);
+		}
+		else
+			v[i] = in[i] = _mm512_i32gather_epi32(state_index, (const int *)state + i, 4);
+	}
+}
+
+AVX512 void sha256_transform_pre_avx512(WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2])
+{
+	__m512i in[8], v[8];
+	const __m512i state_index = _mm512_setr_epi32(0, 8, 16, 24, 32, 40, 48, 56,
+	                                              64, 72, 80, 88, 96, 104, 112, 120);
+	int i;
+
+	sha256_load_pre_avx512(in, v, (const WORD (*)[8])state, s);
+	sha256_rounds_pre_avx512(v, s, vary);
+	for (i = 0; i < 8; ++i)
+		_mm512_i32scatter_epi32((int *)state + i, state_index, ADD(in[i], v[i]), 4);
+}
+
+AVX512 unsigned int sha256_search_pre_avx512(const WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2], int difficulty)
+{
+	__m512i in[8], v[8];
+	__mmask16 ok;
+	WORD mask[2], expected[2];
+
+	sha256_load_pre_avx512(in, v, state, s);
+	sha256_rounds_pre_avx512(v, s, vary);
+	sha256_difficulty_mask(difficulty, mask, expected);
+	ok = _mm512_cmpeq_epi32_mask(_mm512_and_si512(ADD(in[0], v[0]), _mm512_set1_epi32(mask[0])), _mm512_set1_epi32(expected[0]));
+	if (mask[1] != 0)
+		ok &= _mm512_cmpeq_epi32_mask(_mm512_and_si512(ADD(in[1], v[1]), _mm512_set1_epi32(mask[1])), _mm512_set1_epi32(expected[1]));
+	return ok;
+}
+
+#else
+
+int sha256_avx512_supported(void)
+{
+	return 0;
+}
+
+void sha256_transform_avx512(WORD state[][8], const BYTE data[][64])
+{
+	int l;
+
+	for (l = 0; l < 16; ++l)
+		sha256_compress_scalar(state[l], data[l]);
+}
+
+unsigned int sha256_search_avx512(const WORD state[][8], const BYTE data[][64], int difficulty)
+{
+	return sha256_search_lanes(sha256_transform_avx512, 16, state, data, difficulty);
+}
+
+void sha256_transform_pre_avx512(WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2])
+{
+	sha256_transform_pre_lanes(sha256_transform_avx512, 16, state, s, vary);
+}
+
+unsigned int sha256_search_pre_avx512(const WORD state[][8], const SHA256_SCHEDULE *s, const WORD vary[][2], int difficulty)
+{
+	return sha256_search_pre_lanes(sha256_transform_avx512, 16, state, s, vary, difficulty);
+}
+
+#endif
@@ -0,0 +1,143 @@
+/*********************************************************************
+* Filename:   sha256_shani.c
+* Details:    SHA-256 compression using the x86 SHA extensions.
+              The state is kept as the ABEF/CDGH register pair the
+              SHA256RNDS2 instruction works on, and the message
+              schedule is computed with SHA256MSG1/SHA256MSG2.
+*********************************************************************/
+
+/*************************** HEADER FILES ***************************/
+#include "sha256.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+/****************************** MACROS ******************************/
+#define SHANI __attribute__((target("sha,sse4.1")))
+
+/*********************** FUNCTION DEFINITIONS ***********************/
+int sha256_shani_supported(void)
+{
+	unsigned int eax, ebx, ecx, edx;
+
+	__builtin_cpu_init();
+	if (!__builtin_cpu_supports("sse4.1"))
+		return 0;
+	if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+		return 0;
+	return (ebx >> 29) & 1;
+}
+
+SHANI void sha256_compress_shani(WORD state[8], const BYTE data[])
+{
+	__m128i state0, state1, abef, cdgh, msg, tmp, m[4];
+	const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+	int j;
+
+	// Load the state as ABEF and CDGH
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xB1);
+	state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1B);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+	abef = state0;
+	cdgh = state1;
+
+	// Four rounds per iteration, m[j & 3] holds the message words of the current group
+#pragma GCC unroll 16
+	for (j = 0; j < 16; ++j) {
+		if (j < 4)
+			m[j] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16 * j)), bswap);
+		msg = _mm_add_epi32(m[j & 3], _mm_loadu_si128((const __m128i *)&sha256_k[4 * j]));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		if (j >= 3 && j < 15) {
+			tmp = _mm_alignr_epi8(m[j & 3], m[(j + 3) & 3], 4);
+			m[(j + 1) & 3] = _mm_add_epi32(m[(j + 1) & 3], tmp);
+			m[(j + 1) & 3] = _mm_sha256msg2_epu32(m[(j + 1) & 3], m[j & 3]);
+		}
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+		if (j >= 1 && j < 13)
+			m[(j + 3) & 3] = _mm_sha256msg1_epu32(m[(j + 3) & 3], m[j & 3]);
+	}
+
+	state0 = _mm_add_epi32(state0, abef);
+	state1 = _mm_add_epi32(state1, cdgh);
+
+	// Store the state back as ABCD and EFGH
+	tmp = _mm_shuffle_epi32(state0, 0x1B);
+	state1 = _mm_shuffle_epi32(state1, 0xB1);
+	_mm_storeu_si128((__m128i *)&state[0], _mm_blend_epi16(tmp, state1, 0xF0));
+	_mm_storeu_si128((__m128i *)&state[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+
+// Two independent blocks at once: SHA256RNDS2 has a long latency, interleaving two
+// dependency chains keeps the SHA unit busy
+SHANI void sha256_transform_shani(WORD state[][8], const BYTE data[][64])
+{
+	__m128i state0[2], state1[2], abef[2], cdgh[2], msg[2], tmp[2], m[2][4];
+	const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+	int i, j;
+
+	for (i = 0; i < 2; ++i) {
+		tmp[i] = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[i][0]), 0xB1);
+		state1[i] = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[i][4]), 0x1B);
+		state0[i] = _mm_alignr_epi8(tmp[i], state1[i], 8);
+		state1[i] = _mm_blend_epi16(state1[i], tmp[i], 0xF0);
+		abef[i] = state0[i];
+		cdgh[i] = state1[i];
+	}
+
+#pragma GCC unroll 16
+	for (j = 0; j < 16; ++j) {
+#pragma GCC unroll 2
+		for (i = 0; i < 2; ++i) {
+			if (j < 4)
+				m[i][j] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data[i] + 16 * j)), bswap);
+			msg[i] = _mm_add_epi32(m[i][j & 3], _mm_loadu_si128((const __m128i *)&sha256_k[4 * j]));
+			state1[i] = _mm_sha256rnds2_epu32(state1[i], state0[i], msg[i]);
+		}
+#pragma GCC unroll 2
+		for (i = 0; i < 2; ++i) {
+			if (j >= 3 && j < 15) {
+				tmp[i] = _mm_alignr_epi8(m[i][j & 3], m[i][(j + 3) & 3], 4);
+				m[i][(j + 1) & 3] = _mm_add_epi32(m[i][(j + 1) & 3], tmp[i]);
+				m[i][(j + 1) & 3] = _mm_sha256msg2_epu32(m[i][(j + 1) & 3], m[i][j & 3]);
+			}
+			msg[i] = _mm_shuffle_epi32(msg[i], 0x0E);
+			state0[i] = _mm_sha256rnds2_epu32(state0[i], state1[i], msg[i]);
+			if (j >= 1 && j < 13)
+				m[i][(j + 3) & 3] = _mm_sha256msg1_epu32(m[i][(j + 3) & 3], m[i][j & 3]);
+		}
+	}
+
+	for (i = 0; i < 2; ++i) {
+		state0[i] = _mm_add_epi32(state0[i], abef[i]);
+		state1[i] = _mm_add_epi32(state1[i], cdgh[i]);
+		tmp[i] = _mm_shuffle_epi32(state0[i], 0x1B);
+		state1[i] = _mm_shuffle_epi32(state1[i], 0xB1);
+		_mm_storeu_si128((__m128i *)&state[i][0], _mm_blend_epi16(tmp[i], state1[i], 0xF0));
+		_mm_storeu_si128((__m128i *)&state[i][4], _mm_alignr_epi8(state1[i], tmp[i], 8));
+	}
+}
+
+#else
+
+int sha256_shani_supported(void)
+{
+	return 0;
+}
+
+void sha256_compress_shani(WORD state[8], const BYTE data[])
+{
+	sha256_compress_scalar(state, data);
+}
+
+void sha256_transform_shani(WORD state[][8], const BYTE data[][64])
+{
+	sha256_compress_scalar(state[0], data[0]);
+	sha256_compress_scalar(state[1], data[1]);
+}
+
+#endif
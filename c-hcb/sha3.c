@@ -0,0 +1,143 @@
+/*********************************************************************
+* Filename:   sha3.c
+* Details:    Implementation of SHA3-256 (FIPS 202): the Keccak-f[1600]
+              permutation over 25 lanes of 64 bits, with a rate of
+              136 bytes. The steps of a round are unrolled, with the
+              rho rotations and the pi moves resolved at compile time.
+              This implementation uses little endian byte order.
+*********************************************************************/
+
+/*************************** HEADER FILES ***************************/
+#include <string.h>
+#include "hash.h"
+
+/****************************** MACROS ******************************/
+#define ROTLEFT64(a,b) (((a) << (b)) | ((a) >> (64-(b))))
+#define SHA3_256_RATE 136
+
+/**************************** VARIABLES *****************************/
+static const uint64_t keccak_rc[24] = {
+	0x0000000000000001ULL,0x0000000000008082ULL,0x800000000000808aULL,0x8000000080008000ULL,
+	0x000000000000808bULL,0x0000000080000001ULL,0x8000000080008081ULL,0x8000000000008009ULL,
+	0x000000000000008aULL,0x0000000000000088ULL,0x0000000080008009ULL,0x000000008000000aULL,
+	0x000000008000808bULL,0x800000000000008bULL,0x8000000000008089ULL,0x8000000000008003ULL,
+	0x8000000000008002ULL,0x8000000000000080ULL,0x000000000000800aULL,0x800000008000000aULL,
+	0x8000000080008081ULL,0x8000000000008080ULL,0x0000000080000001ULL,0x8000000080008008ULL
+};
+
+/*********************** FUNCTION DEFINITIONS ***********************/
+static void keccak_f1600(uint64_t s[25])
+{
+	uint64_t b[25], c0, c1, c2, c3, c4, d0, d1, d2, d3, d4;
+	int round;
+
+	for (round = 0; round < 24; ++round) {
+		// Theta
+		c0 = s[0] ^ s[5] ^ s[10] ^ s[15] ^ s[20];
+		c1 = s[1] ^ s[6] ^ s[11] ^ s[16] ^ s[21];
+		c2 = s[2] ^ s[7] ^ s[12] ^ s[17] ^ s[22];
+		c3 = s[3] ^ s[8] ^ s[13] ^ s[18] ^ s[23];
+		c4 = s[4] ^ s[9] ^ s[14] ^ s[19] ^ s[24];
+		d0 = c4 ^ ROTLEFT64(c1, 1);
+		d1 = c0 ^ ROTLEFT64(c2, 1);
+		d2 = c1 ^ ROTLEFT64(c3, 1);
+		d3 = c2 ^ ROTLEFT64(c4, 1);
+		d4 = c3 ^ ROTLEFT64(c0, 1);
+		// Rho and pi: the lane (x, y) moves to (y, 2x + 3y)
+		b[0] = s[0] ^ d0;
+		b[16] = ROTLEFT64(s[5] ^ d0, 36);
+		b[7] = ROTLEFT64(s[10] ^ d0, 3);
+		b[23] = ROTLEFT64(s[15] ^ d0, 41);
+		b[14] = ROTLEFT64(s[20] ^ d0, 18);
+		b[10] = ROTLEFT64(s[1] ^ d1, 1);
+		b[1] = ROTLEFT64(s[6] ^ d1, 44);
+		b[17] = ROTLEFT64(s[11] ^ d1, 10);
+		b[8] = ROTLEFT64(s[16] ^ d1, 45);
+		b[24] = ROTLEFT64(s[21] ^ d1, 2);
+		b[20] = ROTLEFT64(s[2] ^ d2, 62);
+		b[11] = ROTLEFT64(s[7] ^ d2, 6);
+		b[2] = ROTLEFT64(s[12] ^ d2, 43);
+		b[18] = ROTLEFT64(s[17] ^ d2, 15);
+		b[9] = ROTLEFT64(s[22] ^ d2, 61);
+		b[5] = ROTLEFT64(s[3] ^ d3, 28);
+		b[21] = ROTLEFT64(s[8] ^ d3, 55);
+		b[12] = ROTLEFT64(s[13] ^ d3, 25);
+		b[3] = ROTLEFT64(s[18] ^ d3, 21);
+		b[19] = ROTLEFT64(s[23] ^ d3, 56);
+		b[15] = ROTLEFT64(s[4] ^ d4, 27);
+		b[6] = ROTLEFT64(s[9] ^ d4, 20);
+		b[22] = ROTLEFT64(s[14] ^ d4, 39);
+		b[13] = ROTLEFT64(s[19] ^ d4, 8);
+		b[4] = ROTLEFT64(s[24] ^ d4, 14);
+		// Chi, then iota
+		s[0] = b[0] ^ (~b[1] & b[2]);
+		s[1] = b[1] ^ (~b[2] & b[3]);
+		s[2] = b[2] ^ (~b[3] & b[4]);
+		s[3] = b[3] ^ (~b[4] & b[0]);
+		s[4] = b[4] ^ (~b[0] & b[1]);
+		s[5] = b[5] ^ (~b[6] & b[7]);
+		s[6] = b[6] ^ (~b[7] & b[8]);
+		s[7] = b[7] ^ (~b[8] & b[9]);
+		s[8] = b[8] ^ (~b[9] & b[5]);
+		s[9] = b[9] ^ (~b[5] & b[6]);
+		s[10] = b[10] ^ (~b[11] & b[12]);
+		s[11] = b[11] ^ (~b[12] & b[13]);
+		s[12] = b[12] ^ (~b[13] & b[14]);
+		s[13] = b[13] ^ (~b[14] & b[10]);
+		s[14] = b[14] ^ (~b[10] & b[11]);
+		s[15] = b[15] ^ (~b[16] & b[17]);
+		s[16] = b[16] ^ (~b[17] & b[18]);
+		s[17] = b[17] ^ (~b[18] & b[19]);
+		s[18] = b[18] ^ (~b[19] & b[15]);
+		s[19] = b[19] ^ (~b[15] & b[16]);
+		s[20] = b[20] ^ (~b[21] & b[22]);
+		s[21] = b[21] ^ (~b[22] & b[23]);
+		s[22] = b[22] ^ (~b[23] & b[24]);
+		s[23] = b[23] ^ (~b[24] & b[20]);
+		s[24] = b[24] ^ (~b[20] & b[21]);
+		s[0] ^= keccak_rc[round];
+	}
+}
+
+void sha3_256_init(SHA3_CTX *ctx)
+{
+	memset(ctx->state, 0, sizeof(ctx->state));
+	ctx->datalen = 0;
+}
+
+// XOR the bytes into the lanes of the state, from the byte offset of the rate
+static void sha3_absorb(SHA3_CTX *ctx, size_t offset, const BYTE data[], size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; ++i)
+		ctx->state[(offset + i) / 8] ^= (uint64_t)data[i] << (8 * ((offset + i) % 8));
+}
+
+void sha3_256_update(SHA3_CTX *ctx, const BYTE data[], size_t len)
+{
+	while (len > 0) {
+		size_t n = SHA3_256_RATE - ctx->datalen < len ? SHA3_256_RATE - ctx->datalen : len;
+		sha3_absorb(ctx, ctx->datalen, data, n);
+		ctx->datalen += n;
+		data += n;
+		len -= n;
+		if (ctx->datalen == SHA3_256_RATE) {
+			keccak_f1600(ctx->state);
+			ctx->datalen = 0;
+		}
+	}
+}
+
+void sha3_256_final(SHA3_CTX *ctx, BYTE hash[])
+{
+	size_t i;
+
+	// Domain separation bits 01, then the pad10*1 padding
+	ctx->state[ctx->datalen / 8] ^= (uint64_t)0x06 << (8 * (ctx->datalen % 8));
+	ctx->state[(SHA3_256_RATE - 1) / 8] ^= (uint64_t)0x80 << (8 * ((SHA3_256_RATE - 1) % 8));
+	keccak_f1600(ctx->state);
+
+	for (i = 0; i < HASH_SIZE; ++i)
+		hash[i] = (BYTE)(ctx->state[i / 8] >> (8 * (i % 8)));
+}
@@ -0,0 +1,157 @@
+/*********************************************************************
+* Filename:   sha512.c
+* Details:    Implementation of SHA-512/256: the SHA-512 compression
+              on 64 bits words, with its own initial state, and the
+              digest truncated to 256 bits (FIPS 180-4).
+              The rounds are unrolled by eight, so the working
+              variables never move, and the message schedule is kept
+              in a ring of 16 words.
+*********************************************************************/
+
+/*************************** HEADER FILES ***************************/
+#include <string.h>
+#include "hash.h"
+
+/****************************** MACROS ******************************/
+#define ROTRIGHT64(a,b) (((a) >> (b)) | ((a) << (64-(b))))
+
+#define CH(x,y,z) (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x,y,z) (((x) & (y)) | ((z) & ((x) | (y))))
+#define EP0(x) (ROTRIGHT64(x,28) ^ ROTRIGHT64(x,34) ^ ROTRIGHT64(x,39))
+#define EP1(x) (ROTRIGHT64(x,14) ^ ROTRIGHT64(x,18) ^ ROTRIGHT64(x,41))
+#define SIG0(x) (ROTRIGHT64(x,1) ^ ROTRIGHT64(x,8) ^ ((x) >> 7))
+#define SIG1(x) (ROTRIGHT64(x,19) ^ ROTRIGHT64(x,61) ^ ((x) >> 6))
+
+// Schedule word t (t >= 16) computed in place in the ring of the last 16 words
+#define SCHEDULE(t) (m[(t) & 15] += SIG1(m[((t) - 2) & 15]) + m[((t) - 7) & 15] + SIG0(m[((t) - 15) & 15]))
+
+#define ROUND(a,b,c,d,e,f,g,h,t,w) do { \
+	uint64_t t1 = (h) + EP1(e) + CH(e,f,g) + sha512_k[t] + (w); \
+	(d) += t1; \
+	(h) = t1 + EP0(a) + MAJ(a,b,c); \
+} while (0)
+
+#define ROUNDS8(t,W) do { \
+	ROUND(a,b,c,d,e,f,g,h,(t),W((t))); \
+	ROUND(h,a,b,c,d,e,f,g,(t)+1,W((t)+1)); \
+	ROUND(g,h,a,b,c,d,e,f,(t)+2,W((t)+2)); \
+	ROUND(f,g,h,a,b,c,d,e,(t)+3,W((t)+3)); \
+	ROUND(e,f,g,h,a,b,c,d,(t)+4,W((t)+4)); \
+	ROUND(d,e,f,g,h,a,b,c,(t)+5,W((t)+5)); \
+	ROUND(c,d,e,f,g,h,a,b,(t)+6,W((t)+6)); \
+	ROUND(b,c,d,e,f,g,h,a,(t)+7,W((t)+7)); \
+} while (0)
+
+#define LOADED(t) m[(t)]
+
+/**************************** VARIABLES *****************************/
+static const uint64_t sha512_k[80] = {
+	0x428a2f98d728ae22ULL,0x7137449123ef65cdULL,0xb5c0fbcfec4d3b2fULL,0xe9b5dba58189dbbcULL,
+	0x3956c25bf348b538ULL,0x59f111f1b605d019ULL,0x923f82a4af194f9bULL,0xab1c5ed5da6d8118ULL,
+	0xd807aa98a3030242ULL,0x12835b0145706fbeULL,0x243185be4ee4b28cULL,0x550c7dc3d5ffb4e2ULL,
+	0x72be5d74f27b896fULL,0x80deb1fe3b1696b1ULL,0x9bdc06a725c71235ULL,0xc19bf174cf692694ULL,
+	0xe49b69c19ef14ad2ULL,0xefbe4786384f25e3ULL,0x0fc19dc68b8cd5b5ULL,0x240ca1cc77ac9c65ULL,
+	0x2de92c6f592b0275ULL,0x4a7484aa6ea6e483ULL,0x5cb0a9dcbd41fbd4ULL,0x76f988da831153b5ULL,
+	0x983e5152ee66dfabULL,0xa831c66d2db43210ULL,0xb00327c898fb213fULL,0xbf597fc7beef0ee4ULL,
+	0xc6e00bf33da88fc2ULL,0xd5a79147930aa725ULL,0x06ca6351e003826fULL,0x142929670a0e6e70ULL,
+	0x27b70a8546d22ffcULL,0x2e1b21385c26c926ULL,0x4d2c6dfc5ac42aedULL,0x53380d139d95b3dfULL,
+	0x650a73548baf63deULL,0x766a0abb3c77b2a8ULL,0x81c2c92e47edaee6ULL,0x92722c851482353bULL,
+	0xa2bfe8a14cf10364ULL,0xa81a664bbc423001ULL,0xc24b8b70d0f89791ULL,0xc76c51a30654be30ULL,
+	0xd192e819d6ef5218ULL,0xd69906245565a910ULL,0xf40e35855771202aULL,0x106aa07032bbd1b8ULL,
+	0x19a4c116b8d2d0c8ULL,0x1e376c085141ab53ULL,0x2748774cdf8eeb99ULL,0x34b0bcb5e19b48a8ULL,
+	0x391c0cb3c5c95a63ULL,0x4ed8aa4ae3418acbULL,0x5b9cca4f7763e373ULL,0x682e6ff3d6b2b8a3ULL,
+	0x748f82ee5defb2fcULL,0x78a5636f43172f60ULL,0x84c87814a1f0ab72ULL,0x8cc702081a6439ecULL,
+	0x90befffa23631e28ULL,0xa4506cebde82bde9ULL,0xbef9a3f7b2c67915ULL,0xc67178f2e372532bULL,
+	0xca273eceea26619cULL,0xd186b8c721c0c207ULL,0xeada7dd6cde0eb1eULL,0xf57d4f7fee6ed178ULL,
+	0x06f067aa72176fbaULL,0x0a637dc5a2c898a6ULL,0x113f9804bef90daeULL,0x1b710b35131c471bULL,
+	0x28db77f523047d84ULL,0x32caab7b40c72493ULL,0x3c9ebe0a15c9bebcULL,0x431d67c49c100d4cULL,
+	0x4cc5d4becb3e42b6ULL,0x597f299cfc657e2aULL,0x5fcb6fab3ad6faecULL,0x6c44198c4a475817ULL
+};
+
+/*********************** FUNCTION DEFINITIONS ***********************/
+static void sha512_compress(uint64_t state[8], const BYTE data[])
+{
+	uint64_t a, b, c, d, e, f, g, h, m[16];
+	int i, t;
+
+	for (i = 0; i < 16; ++i) {
+		const BYTE *p = data + i * 8;
+		m[i] = ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) | ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+		       ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) | ((uint64_t)p[6] << 8) | (uint64_t)p[7];
+	}
+
+	a = state[0];
+	b = state[1];
+	c = state[2];
+	d = state[3];
+	e = state[4];
+	f = state[5];
+	g = state[6];
+	h = state[7];
+
+	ROUNDS8(0, LOADED);
+	ROUNDS8(8, LOADED);
+	for (t = 16; t < 80; t += 8)
+		ROUNDS8(t, SCHEDULE);
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+	state[5] += f;
+	state[6] += g;
+	state[7] += h;
+}
+
+void sha512_256_init(SHA512_CTX *ctx)
+{
+	ctx->datalen = 0;
+	ctx->bitlen = 0;
+	ctx->state[0] = 0x22312194fc2bf72cULL;
+	ctx->state[1] = 0x9f555fa3c84c64c2ULL;
+	ctx->state[2] = 0x2393b86b6f53b151ULL;
+	ctx->state[3] = 0x963877195940eabdULL;
+	ctx->state[4] = 0x96283ee2a88effe3ULL;
+	ctx->state[5] = 0xbe5e1e2553863992ULL;
+	ctx->state[6] = 0x2b0199fc2c85b8aaULL;
+	ctx->state[7] = 0x0eb72ddc81c52ca2ULL;
+}
+
+void sha512_update(SHA512_CTX *ctx, const BYTE data[], size_t len)
+{
+	while (len > 0) {
+		size_t n = 128 - ctx->datalen < len ? 128 - ctx->datalen : len;
+		memcpy(ctx->data + ctx->datalen, data, n);
+		ctx->datalen += n;
+		data += n;
+		len -= n;
+		if (ctx->datalen == 128) {
+			sha512_compress(ctx->state, ctx->data);
+			ctx->bitlen += 1024;
+			ctx->datalen = 0;
+		}
+	}
+}
+
+void sha512_256_final(SHA512_CTX *ctx, BYTE hash[])
+{
+	unsigned long long bitlen = ctx->bitlen + ctx->datalen * 8;
+	size_t i = ctx->datalen;
+
+	// Pad with a one bit, zeros, then the length as a 128 bits integer whose high half is zero
+	ctx->data[i++] = 0x80;
+	if (i > 112) {
+		memset(ctx->data + i, 0, 128 - i);
+		sha512_compress(ctx->state, ctx->data);
+		i = 0;
+	}
+	memset(ctx->data + i, 0, 120 - i);
+	for (i = 0; i < 8; ++i)
+		ctx->data[127 - i] = (BYTE)(bitlen >> (i * 8));
+	sha512_compress(ctx->state, ctx->data);
+
+	// The first four words, big-endian
+	for (i = 0; i < HASH_SIZE; ++i)
+		hash[i] = (BYTE)(ctx->state[i / 8] >> (56 - 8 * (i % 8)));
+}
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "stats.h"
+#include "util.h"
+
+// Progress of the search, protected by stats_lock
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static int stats_level = -1;                       // Level being searched, -1 between two levels
+static nonce_t level_start_nonce;                  // Nonce the level was started from in this run
+static double level_start_time;
+static nonce_t sample_position;                    // Position of the search at the last sample
+static double sample_time;
+static double hash_rate;                           // Moving average, 0 before the first sample
+static double sample_cpu;                          // CPU time of the process at the last sample
+static double cpu_hash_rate;                       // Moving average of the hashes per CPU second
+static double level_start_joules = -1;             // Energy read when the level started, negative if unknown
+static double sample_joules = -1;                  // Energy read at the last sample, negative if unknown
+static double power;                               // Moving average of the power of the packages in watts
+static long long unsigned int blocks_found;        // Blocks found in this run
+
+// CPU time used by every thread of the process, so a throttled search is measured by what it
+// actually costs to the host
+static double process_cpu() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Average number of nonces to test before finding the block of a level: a hash starts with
+// exactly level zero bits with a probability of 2^-(level+1)
+static double expected_attempts(int level) {
+    double attempts = 2;
+    for (int i = 0; i < level; i++) {
+        attempts *= 2;
+    }
+    return attempts;
+}
+
+// Seconds before the next block is expected, -1 if the hash rate is not known yet
+// Nonces are independent, so this does not depend on the nonces already tested
+static double expected_seconds() {
+    return hash_rate > 0 && stats_level >= 0 ? expected_attempts(stats_level) / hash_rate : -1;
+}
+
+// Joules used by the current level, -1 if unknown
+static double level_joules() {
+    return stats_level >= 0 && level_start_joules >= 0 && sample_joules >= 0 ? sample_joules - level_start_joules : -1;
+}
+
+void stats_level_start(int level, nonce_t start, double joules) {
+    pthread_mutex_lock(&stats_lock);
+    stats_level = level;
+    level_start_joules = sample_joules = joules;
+    level_start_nonce = sample_position = start;
+    level_start_time = sample_time = util_now();
+    sample_cpu = process_cpu();
+    pthread_mutex_unlock(&stats_lock);
+}
+
+void stats_level_done(void) {
+    pthread_mutex_lock(&stats_lock);
+    blocks_found++;
+    stats_level = -1;
+    pthread_mutex_unlock(&stats_lock);
+}
+
+void stats_sample(nonce_t position, double joules) {
+    pthread_mutex_lock(&stats_lock);
+    double time = util_now();
+    double cpu = process_cpu();
+    if (stats_level >= 0 && position >= sample_position && time > sample_time) {
+        double rate = (double)(position - sample_position) / (time - sample_time);
+        double alpha = (time - sample_time) / (STATS_RATE_WINDOW + time - sample_time);
+        hash_rate = hash_rate == 0 ? rate : hash_rate + alpha * (rate - hash_rate);
+        if (cpu > sample_cpu) {
+            double cpu_rate = (double)(position - sample_position) / (cpu - sample_cpu);
+            cpu_hash_rate = cpu_hash_rate == 0 ? cpu_rate : cpu_hash_rate + alpha * (cpu_rate - cpu_hash_rate);
+        }
+        if (joules >= 0 && sample_joules >= 0 && joules >= sample_joules) {
+            double watts = (joules - sample_joules) / (time - sample_time);
+            power = power == 0 ? watts : power + alpha * (watts - power);
+        }
+        sample_position = position;
+        sample_time = time;
+        sample_cpu = cpu;
+        sample_joules = joules;
+    }
+    pthread_mutex_unlock(&stats_lock);
+}
+
+void stats_print(FILE* fp) {
+    pthread_mutex_lock(&stats_lock);
+    if (stats_level < 0) {
+        fprintf(fp, "Between two levels, %llu blocks found\n", blocks_found);
+    } else {
+        fprintf(fp, "Level %d: %llu nonces tested in %.1f s, %.0f h/s (%.0f per CPU second), next block expected in %.0f s\n",
+            stats_level, (long long unsigned int)(sample_position - level_start_nonce), util_now() - level_start_time, hash_rate, cpu_hash_rate, expected_seconds());
+        if (level_joules() >= 0) {
+            fprintf(fp, "Level %d: %.1f J used, %.1f W, %.0f hashes per joule\n", stats_level, level_joules(), power, power > 0 ? hash_rate / power : 0);
+        }
+    }
+    fflush(fp);
+    pthread_mutex_unlock(&stats_lock);
+}
+
+int stats_write(const char* path, const char* kernel) {
+
+    // Written aside then renamed, so a reader never sees a partial file
+    char* temp_path = malloc(strlen(path) + 5);
+    if (temp_path == NULL) {
+        return -1;
+    }
+    sprintf(temp_path, "%s.tmp", path);
+    FILE* fp = fopen(temp_path, "w");
+    if (fp == NULL) {
+        free(temp_path);
+        return -1;
+    }
+
+    pthread_mutex_lock(&stats_lock);
+    fprintf(fp, "# HELP hcb_level Level being searched, -1 between two levels\n# TYPE hcb_level gauge\nhcb_level %d\n", stats_level);
+    fprintf(fp, "# HELP hcb_level_attempts Nonces tested at the current level in this run\n# TYPE hcb_level_attempts gauge\nhcb_level_attempts %llu\n",
+        stats_level >= 0 ? (long long unsigned int)(sample_position - level_start_nonce) : 0);
+    fprintf(fp, "# HELP hcb_level_seconds Time spent on the current level in this run\n# TYPE hcb_level_seconds gauge\nhcb_level_seconds %.3f\n",
+        stats_level >= 0 ? util_now() - level_start_time : 0);
+    fprintf(fp, "# HELP hcb_hash_rate Moving average of the hashes per second over %.0f seconds\n# TYPE hcb_hash_rate gauge\nhcb_hash_rate %.0f\n", STATS_RATE_WINDOW, hash_rate);
+    fprintf(fp, "# HELP hcb_cpu_hash_rate Moving average of the hashes per CPU second of the process\n# TYPE hcb_cpu_hash_rate gauge\nhcb_cpu_hash_rate %.0f\n", cpu_hash_rate);
+    fprintf(fp, "# HELP hcb_cpu_seconds_total CPU time used by the process\n# TYPE hcb_cpu_seconds_total counter\nhcb_cpu_seconds_total %.3f\n", process_cpu());
+    if (sample_joules >= 0) {
+        fprintf(fp, "# HELP hcb_energy_joules_total Energy used by the processor packages (RAPL)\n# TYPE hcb_energy_joules_total counter\nhcb_energy_joules_total %.3f\n", sample_joules);
+        fprintf(fp, "# HELP hcb_level_joules Energy used by the packages on the current level in this run\n# TYPE hcb_level_joules gauge\nhcb_level_joules %.3f\n", level_joules() >= 0 ? level_joules() : 0);
+        fprintf(fp, "# HELP hcb_power_watts Moving average of the power of the packages over %.0f seconds\n# TYPE hcb_power_watts gauge\nhcb_power_watts %.1f\n", STATS_RATE_WINDOW, power);
+        fprintf(fp, "# HELP hcb_hashes_per_joule Hash rate divided by the power of the packages\n# TYPE hcb_hashes_per_joule gauge\nhcb_hashes_per_joule %.0f\n", power > 0 ? hash_rate / power : 0);
+    }
+    fprintf(fp, "# HELP hcb_expected_seconds Expected time before the next block, -1 if unknown\n# TYPE hcb_expected_seconds gauge\nhcb_expected_seconds %.0f\n", expected_seconds());
+    fprintf(fp, "# HELP hcb_blocks_found_total Blocks found in this run\n# TYPE hcb_blocks_found_total counter\nhcb_blocks_found_total %llu\n", blocks_found);
+    fprintf(fp, "# HELP hcb_info Kernel used by the search\n# TYPE hcb_info gauge\nhcb_info{kernel=\"%s\"} 1\n", kernel);
+    pthread_mutex_unlock(&stats_lock);
+
+    int result = fclose(fp) == 0 && rename(temp_path, path) == 0 ? 0 : -1;
+    free(temp_path);
+    return result;
+
+}
@@ -0,0 +1,30 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include "search.h"
+
+// Time constant in seconds of the moving average of the hash rate
+#define STATS_RATE_WINDOW 10.0
+
+// Start measuring a level searched from the nonce start, joules is the energy read from
+// energy_read, negative if unknown
+void stats_level_start(int level, nonce_t start, double joules);
+
+// Stop measuring the current level, once its block is found
+void stats_level_done(void);
+
+// Update the moving averages of the hash rate and of the power from the position of the running
+// search and the energy read from energy_read, negative if unknown
+// Called periodically, the search itself is never slowed down by the measures
+void stats_sample(nonce_t position, double joules);
+
+// Print a one line summary of the progress to fp
+void stats_print(FILE* fp);
+
+// Rewrite the file at path with the progress in the Prometheus text format, kernel is the name
+// of the kernel used by the search
+// Returns 0 on success, -1 if the file could not be written
+int stats_write(const char* path, const char* kernel);
+
+#endif   // STATS_H
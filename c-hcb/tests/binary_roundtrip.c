@@ -0,0 +1,103 @@
+// A text chain converted to the binary format and back must be unchanged, but for its #stats
+// comments: the header of a memory-hard or non SHA-256 chain, the nonces and a #nonce checkpoint
+// above 2^64 are all kept
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "binary.h"
+#include "test.h"
+
+#define TEST_BLOCKS 10
+
+// Checkpoint of the next level, above 2^64 so it needs both halves of the header
+#define TEST_RESUME "18446744073709563961"
+
+// Round trip of a chain generated with options, ended by a #nonce checkpoint
+static int round_trip(const char* name, const hcb_options* options) {
+
+    int failed = 0;
+    char* text_path = test_temp_path("hcb-text");
+    char* binary_path = test_temp_path("hcb-binary");
+    char* back_path = test_temp_path("hcb-back");
+    test_chain(text_path, name, TEST_BLOCKS, options);
+    FILE* fp = fopen(text_path, "a");
+    if (fp == NULL || fputs("#nonce:" TEST_RESUME "\n", fp) < 0 || fclose(fp) != 0) {
+        printf("Error: Unable to write %s\n", text_path);
+        exit(2);
+    }
+
+    // The text expected back: the chain without its #stats lines
+    size_t size;
+    char* text = test_read_file(text_path, &size);
+    char* expected = malloc(size + 1);
+    size_t length = 0;
+    for (char* line = text; line < text + size; line = strchr(line, '\n') + 1) {
+        size_t line_length = strchr(line, '\n') + 1 - line;
+        if (strncmp(line, "#stats", 6) != 0) {
+            memcpy(expected + length, line, line_length);
+            length += line_length;
+        }
+    }
+
+    hcb_error error;
+    hcb_binary* binary;
+    if (hcb_to_binary(text_path, binary_path, NULL, &error) != HCB_OK || hcb_to_text(binary_path, back_path, NULL, &error) != HCB_OK) {
+        printf("FAIL %s: %s\n", name, error.message);
+        failed++;
+    } else {
+        size_t back_size;
+        char* back = test_read_file(back_path, &back_size);
+        if (back == NULL || back_size != length || memcmp(back, expected, length) != 0) {
+            printf("FAIL %s: the text converted back differs\n--- expected\n%.*s--- got\n%s", name, (int)length, expected, back != NULL ? back : "");
+            failed++;
+        }
+        free(back);
+    }
+
+    // The blocks can be read one by one, but not past the end
+    if (hcb_binary_open(&binary, binary_path, &error) != HCB_OK) {
+        printf("FAIL %s: %s\n", name, error.message);
+        failed++;
+    } else {
+        char nonce[SHA256_BLOCK_SIZE * 2 + 1];
+        if (hcb_binary_blocks(binary) != TEST_BLOCKS || hcb_binary_memory(binary) != options->memory || hcb_binary_hash(binary) != (options->hash != NULL ? options->hash : &hash_sha256) ||
+            strcmp(hcb_binary_message(binary), name) != 0 || hcb_binary_block(binary, TEST_BLOCKS - 1, nonce, NULL, &error) != HCB_OK ||
+            hcb_binary_block(binary, TEST_BLOCKS, nonce, NULL, &error) != HCB_ERROR_BLOCK) {
+            printf("FAIL %s: wrong binary header or blocks\n", name);
+            failed++;
+        }
+        hcb_binary_close(binary);
+    }
+
+    free(expected);
+    free(text);
+    unlink(text_path);
+    unlink(binary_path);
+    unlink(back_path);
+    free(text_path);
+    free(binary_path);
+    free(back_path);
+    return failed;
+
+}
+
+int main(void) {
+
+    int failed = 0;
+    hcb_options options;
+
+    hcb_options_init(&options);
+    failed += round_trip("regular chain", &options);
+
+    options.hash = &hash_sha3_256;
+    failed += round_trip("sha3-256 chain", &options);
+
+    options.hash = &hash_blake2b_256;
+    options.memory = 64;
+    failed += round_trip("memory-hard chain", &options);
+
+    printf("%d failures\n", failed);
+    return failed == 0 ? 0 : 1;
+
+}
@@ -0,0 +1,131 @@
+// hcb_check must return the status of the first error of a broken chain, the exit code of
+// hcb --check
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+
+#define TEST_BLOCKS 8
+
+// Lines of a chain without its comments: the header, the message, then the nonce, separator and
+// hash of each block
+#define NONCE_LINE(block) (2 + 3 * (block))
+#define SEPARATOR_LINE(block) (3 + 3 * (block))
+#define HASH_LINE(block) (4 + 3 * (block))
+#define CHAIN_LINES (2 + 3 * TEST_BLOCKS)
+
+static char lines[CHAIN_LINES][256];
+static char variant[CHAIN_LINES][256];
+static char* path;
+
+// Check the variant made of its first count lines
+static int expect(const char* name, int count, hcb_status expected) {
+    FILE* fp = fopen(path, "w");
+    for (int i = 0; fp != NULL && i < count; i++) {
+        fprintf(fp, "%s\n", variant[i]);
+    }
+    if (fp == NULL || fclose(fp) != 0) {
+        printf("Error: Unable to write %s\n", path);
+        exit(2);
+    }
+    hcb_chain_info info;
+    hcb_error error;
+    hcb_status status = hcb_check(path, NULL, &info, &error);
+    memcpy(variant, lines, sizeof(lines));
+    if (status != expected) {
+        printf("FAIL %s: status %d instead of %d (%s)\n", name, status, expected, status != HCB_OK ? error.message : "valid");
+        return 1;
+    }
+    return 0;
+}
+
+// Leading zero bits of a hash
+static int zero_bits(const BYTE hash[]) {
+    int bits = 0;
+    for (int i = 0; i < SHA256_BLOCK_SIZE && hash[i] == 0; i++) {
+        bits += 8;
+    }
+    for (int i = bits / 8, bit = 7; i < SHA256_BLOCK_SIZE && bit >= 0 && (hash[i] >> bit & 1) == 0; bit--) {
+        bits++;
+    }
+    return bits;
+}
+
+int main(void) {
+
+    int failed = 0;
+    path = test_temp_path("hcb-check");
+    test_chain(path, "broken chains", TEST_BLOCKS, NULL);
+
+    // Keep the lines of the chain, without the comments
+    size_t size;
+    char* data = test_read_file(path, &size);
+    int count = 0;
+    for (char* line = strtok(data, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+        if (line[0] != '#' && count < CHAIN_LINES) {
+            snprintf(lines[count++], sizeof(lines[0]), "%s", line);
+        }
+    }
+    free(data);
+    if (count != CHAIN_LINES) {
+        printf("Error: %d lines instead of %d in %s\n", count, CHAIN_LINES, path);
+        return 2;
+    }
+    memcpy(variant, lines, sizeof(lines));
+
+    failed += expect("valid chain", CHAIN_LINES, HCB_OK);
+    failed += expect("chain ending with a nonce", NONCE_LINE(TEST_BLOCKS - 1) + 1, HCB_ERROR_END);
+
+    variant[0][5] = '9';
+    failed += expect("unknown header", CHAIN_LINES, HCB_ERROR_FIRST_LINE);
+
+    variant[SEPARATOR_LINE(2)][0] = '7';
+    failed += expect("wrong separator", CHAIN_LINES, HCB_ERROR_SEPARATOR);
+
+    memset(variant[HASH_LINE(3)], '0', SHA256_BLOCK_SIZE * 2);
+    failed += expect("wrong hash", CHAIN_LINES, HCB_ERROR_HASH);
+
+    failed += expect("chain ending with a separator", SEPARATOR_LINE(TEST_BLOCKS - 1) + 1, HCB_ERROR_END);
+
+    variant[NONCE_LINE(4)][10] = 'a';
+    failed += expect("letter in a nonce", CHAIN_LINES, HCB_ERROR_NONCE);
+
+    variant[NONCE_LINE(4)][SHA256_BLOCK_SIZE * 2 - 1] = '\0';
+    failed += expect("short nonce", CHAIN_LINES, HCB_ERROR_NONCE_LENGTH);
+
+    strcat(variant[HASH_LINE(5)], "0");
+    failed += expect("long hash", CHAIN_LINES, HCB_ERROR_HASH_LENGTH);
+
+    // A nonce whose hash is right but does not have the difficulty of its level
+    int level = TEST_BLOCKS - 1;
+    for (int nonce = 0; ; nonce++) {
+        SHA256_CTX ctx;
+        BYTE hash[SHA256_BLOCK_SIZE];
+        snprintf(variant[NONCE_LINE(level)], sizeof(variant[0]), "%064d", nonce);
+        sha256_init(&ctx);
+        sha256_update(&ctx, (const BYTE*)variant[HASH_LINE(level - 1)], SHA256_BLOCK_SIZE * 2);
+        sha256_update(&ctx, (const BYTE*)"\n", 1);
+        sha256_update(&ctx, (const BYTE*)variant[NONCE_LINE(level)], SHA256_BLOCK_SIZE * 2);
+        sha256_final(&ctx, hash);
+        if (zero_bits(hash) != level) {
+            for (int i = 0; i < SHA256_BLOCK_SIZE; i++) {
+                sprintf(variant[HASH_LINE(level)] + 2 * i, "%02x", hash[i]);
+            }
+            break;
+        }
+    }
+    failed += expect("wrong difficulty", CHAIN_LINES, HCB_ERROR_DIFFICULTY);
+
+    unlink(path);
+    hcb_error error;
+    if (hcb_check(path, NULL, NULL, &error) != HCB_ERROR_OPEN) {
+        printf("FAIL missing file: status %d instead of %d\n", error.status, HCB_ERROR_OPEN);
+        failed++;
+    }
+
+    free(path);
+    printf("%d failures\n", failed);
+    return failed == 0 ? 0 : 1;
+
+}
@@ -0,0 +1,78 @@
+// The C++ layer of hcb.hpp: a chain built with hcb::ChainBuilder is valid for hcb::check, and
+// hcb::Searcher finds the nonces of its blocks
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include "hcb.hpp"
+#include "test.h"
+
+static int failed = 0;
+
+static void expect(bool condition, const char* what) {
+    if (!condition) {
+        std::printf("FAIL %s\n", what);
+        failed++;
+    }
+}
+
+int main() {
+
+    char* temp = test_temp_path("hcb-cpp");
+    std::string path = temp;
+    std::free(temp);
+
+    // Build a chain block after block, keeping its last block
+    hcb::Options options;
+    options.threads = 1;
+    auto builder = hcb::ChainBuilder::create(path, "C++ interface", options);
+    expect(builder.ok(), "ChainBuilder::create");
+    if (!builder) {
+        std::printf("%s\n", builder.error().message.c_str());
+        return 2;
+    }
+    hcb_block previous{};
+    hcb_block last{};
+    for (int level = 0; level < 10; level++) {
+        auto block = builder->next();
+        if (!block) {
+            std::printf("%s\n", block.error().message.c_str());
+            return 2;
+        }
+        expect(block->level == level, "ChainBuilder::next level");
+        previous = last;
+        last = *block;
+    }
+    expect(builder->level() == 10, "ChainBuilder::level");
+    builder = hcb::Error();
+
+    auto info = hcb::check(path);
+    expect(info.ok() && info->blocks == 10, "check of the built chain");
+    expect(info.ok() && std::memcmp(info->last_hash, last.hash, SHA256_BLOCK_SIZE) == 0, "check last hash");
+
+    // The last block is the lowest nonce of its level after the hash of the previous one
+    char prefix[SHA256_BLOCK_SIZE * 2 + 1];
+    for (int i = 0; i < SHA256_BLOCK_SIZE; i++) {
+        std::sprintf(prefix + 2 * i, "%02x", previous.hash[i]);
+    }
+    hcb::Searcher searcher;
+    expect(searcher.valid(), "Searcher");
+    auto found = searcher.search(prefix, last.level);
+    expect(found.ok() && found->nonce == last.nonce, "Searcher::search nonce");
+    expect(found.ok() && std::memcmp(found->hash, last.hash, SHA256_BLOCK_SIZE) == 0, "Searcher::search hash");
+    auto none = searcher.search(prefix, last.level, 0, last.nonce);
+    expect(!none.ok() && none.error().status == HCB_CANCELLED, "Searcher::search of a range without a nonce");
+
+    // A broken chain is reported with its status
+    std::FILE* fp = std::fopen(path.c_str(), "a");
+    std::fputs("0\n", fp);
+    std::fclose(fp);
+    auto broken = hcb::check(path);
+    expect(!broken.ok() && broken.error().status == HCB_ERROR_NONCE_LENGTH, "check of a broken chain");
+
+    unlink(path.c_str());
+    std::printf("%d failures\n", failed);
+    return failed == 0 ? 0 : 1;
+
+}
@@ -0,0 +1,102 @@
+// The energy of a fake powercap tree: only the package zones count, not their sub-zones nor the
+// intel-rapl-mmio duplicates, and a counter wrapping around adds the energy up to its range
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "energy.h"
+#include "test.h"
+
+static char root[] = "/tmp/hcb-powercap-XXXXXX";
+
+// Write the text to the file name of the zone directory, creating it
+static void write_zone(const char* zone, const char* name, const char* text) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", root, zone);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/%s/%s", root, zone, name);
+    if (!test_write_file(path, text, strlen(text))) {
+        printf("Error: Unable to write %s\n", path);
+        exit(2);
+    }
+}
+
+static void remove_zone(const char* zone) {
+    const char* names[] = {"name", "energy_uj", "max_energy_range_uj"};
+    char path[256];
+    for (int i = 0; i < 3; i++) {
+        snprintf(path, sizeof(path), "%s/%s/%s", root, zone, names[i]);
+        unlink(path);
+    }
+    snprintf(path, sizeof(path), "%s/%s", root, zone);
+    rmdir(path);
+}
+
+static int expect(const char* what, double joules, double expected) {
+    if (fabs(joules - expected) > 1e-6) {
+        printf("FAIL %s: %f joules instead of %f\n", what, joules, expected);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+
+    int failed = 0;
+    if (mkdtemp(root) == NULL) {
+        printf("Error: Unable to create a temporary directory\n");
+        return 2;
+    }
+
+    // A package, its core sub-zone and the same package again through MMIO, counters in µJ
+    write_zone("intel-rapl:0", "name", "package-0\n");
+    write_zone("intel-rapl:0", "max_energy_range_uj", "10000000\n");
+    write_zone("intel-rapl:0", "energy_uj", "9000000\n");
+    write_zone("intel-rapl:0:0", "name", "core\n");
+    write_zone("intel-rapl:0:0", "max_energy_range_uj", "10000000\n");
+    write_zone("intel-rapl:0:0", "energy_uj", "100\n");
+    write_zone("intel-rapl-mmio:0", "name", "package-0\n");
+    write_zone("intel-rapl-mmio:0", "max_energy_range_uj", "10000000\n");
+    write_zone("intel-rapl-mmio:0", "energy_uj", "100\n");
+
+    energy_t* energy = energy_open(root);
+    if (energy == NULL) {
+        printf("FAIL no zone opened in %s\n", root);
+        failed++;
+    } else {
+        if (energy_zones(energy) != 1) {
+            printf("FAIL %d zones instead of the package alone\n", energy_zones(energy));
+            failed++;
+        }
+        failed += expect("no energy used yet", energy_read(energy), 0);
+
+        // The other zones change too, but are not counted
+        write_zone("intel-rapl:0", "energy_uj", "9500000\n");
+        write_zone("intel-rapl:0:0", "energy_uj", "400000\n");
+        write_zone("intel-rapl-mmio:0", "energy_uj", "500100\n");
+        failed += expect("counter going up", energy_read(energy), 0.5);
+
+        // 0.5 J up to the range, then 0.25 J after the wrap
+        write_zone("intel-rapl:0", "energy_uj", "250000\n");
+        failed += expect("counter wrapping around", energy_read(energy), 1.25);
+        failed += expect("counter unchanged", energy_read(energy), 1.25);
+        energy_close(energy);
+    }
+
+    // A tree without a readable package
+    remove_zone("intel-rapl:0");
+    if ((energy = energy_open(root)) != NULL) {
+        printf("FAIL zones opened without a package\n");
+        energy_close(energy);
+        failed++;
+    }
+
+    remove_zone("intel-rapl:0:0");
+    remove_zone("intel-rapl-mmio:0");
+    rmdir(root);
+    printf("%d failures\n", failed);
+    return failed == 0 ? 0 : 1;
+
+}
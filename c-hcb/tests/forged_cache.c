@@ -0,0 +1,116 @@
+// A FILE.verified forged for a tampered chain must not make hcb --check accept the chain: the
+// cache is only trusted with --cached
+// Usage: test-forged-cache HCB
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "test.h"
+
+#define TEST_BLOCKS 12
+
+// Checksum of chain.c, which anyone can compute as it has no key
+static uint64_t checksum(const char* data, size_t size) {
+    uint64_t sum = size * 0x9E3779B97F4A7C15ULL;
+    uint64_t word;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        memcpy(&word, data + i, 8);
+        sum = (sum ^ word) * 0xFF51AFD7ED558CCDULL;
+        sum ^= sum >> 32;
+    }
+    word = 0;
+    memcpy(&word, data + i, size - i);
+    sum = (sum ^ word) * 0xFF51AFD7ED558CCDULL;
+    return sum ^ (sum >> 29);
+}
+
+// Exit code of hcb with the arguments, -1 if it did not exit
+static int run_hcb(const char* hcb, const char* arguments) {
+    char command[1024];
+    snprintf(command, sizeof(command), "\"%s\" %s > /dev/null", hcb, arguments);
+    int status = system(command);
+    return status != -1 && WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int main(int argc, char** argv) {
+
+    if (argc < 2) {
+        printf("Usage: test-forged-cache HCB\n");
+        return 2;
+    }
+    char* path = test_temp_path("hcb-forged");
+    char cache[256];
+    snprintf(cache, sizeof(cache), "%s.verified", path);
+    char arguments[256];
+    int failed = 0;
+
+    hcb_options options;
+    hcb_error error;
+    hcb_options_init(&options);
+    test_chain(path, "forged cache", TEST_BLOCKS, &options);
+
+    // A plain check is read-only
+    snprintf(arguments, sizeof(arguments), "--check %s", path);
+    if (run_hcb(argv[1], arguments) != 0 || access(cache, F_OK) == 0) {
+        printf("FAIL --check of a valid chain did not succeed without writing %s\n", cache);
+        failed++;
+    }
+
+    // Zero the hash of block 3, then forge the cache of the whole tampered chain
+    size_t size;
+    char* data = test_read_file(path, &size);
+    char* hash = data != NULL ? strstr(data, "\n3 ---") : NULL;
+    hash = hash != NULL ? strchr(hash + 1, '\n') : NULL;
+    if (hash == NULL) {
+        printf("Error: No block 3 in %s\n", path);
+        return 2;
+    }
+    memset(hash + 1, '0', SHA256_BLOCK_SIZE * 2);
+    int lines = 0;
+    for (size_t i = 0; i < size; i++) {
+        lines += data[i] == '\n';
+    }
+    char forged[128];
+    int length = snprintf(forged, sizeof(forged), "HCB-VERIFIED 1 %zu %d %d %llx\n", size, TEST_BLOCKS, lines,
+        (long long unsigned int)checksum(data, size));
+    if (!test_write_file(path, data, size) || !test_write_file(cache, forged, length)) {
+        printf("Error: Unable to write %s\n", path);
+        return 2;
+    }
+
+    // The check verifies every block despite the cache, and leaves the cache alone
+    int status = run_hcb(argv[1], arguments);
+    if (status != HCB_ERROR_HASH) {
+        printf("FAIL --check of the tampered chain with a forged cache returned %d instead of %d\n", status, HCB_ERROR_HASH);
+        failed++;
+    }
+    size_t cache_size;
+    char* kept = test_read_file(cache, &cache_size);
+    if (kept == NULL || cache_size != (size_t)length || memcmp(kept, forged, length) != 0) {
+        printf("FAIL --check rewrote %s\n", cache);
+        failed++;
+    }
+    if (hcb_check(path, &options, NULL, &error) != HCB_ERROR_HASH) {
+        printf("FAIL hcb_check with the default options accepted the tampered chain\n");
+        failed++;
+    }
+
+    // The cache is what --cached asks to trust, so it only belongs to the chains of this host
+    snprintf(arguments, sizeof(arguments), "--cached --check %s", path);
+    if (run_hcb(argv[1], arguments) != 0) {
+        printf("FAIL --cached --check did not use the cache\n");
+        failed++;
+    }
+
+    free(kept);
+    free(data);
+    unlink(cache);
+    unlink(path);
+    free(path);
+    printf("%d failures\n", failed);
+    return failed == 0 ? 0 : 1;
+
+}
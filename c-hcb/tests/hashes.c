@@ -0,0 +1,74 @@
+// Known answers of the hash algorithms of the chains: the empty message and "abc" of FIPS 180-4,
+// FIPS 202 and RFC 7693, the two block message of FIPS 180-4 and 1000 "a" spanning several blocks
+// of each algorithm, hashed at once and in pieces; the 256 bits digests come from Python's hashlib
+#include <stdio.h>
+#include <string.h>
+#include "hash.h"
+
+#define LONG_MESSAGE_SIZE 1000
+
+typedef struct {
+    const HASH_ALGORITHM* algorithm;
+    const char* message;                  // NULL for LONG_MESSAGE_SIZE "a"
+    const char* hash;
+} vector_t;
+
+static const char* two_blocks = "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu";
+
+int main(void) {
+
+    const vector_t vectors[] = {
+        {&hash_sha256, "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+        {&hash_sha256, "abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+        {&hash_sha512_256, "", "c672b8d1ef56ed28ab87c3622c5114069bdd3ad7b8f9737498d0c01ecef0967a"},
+        {&hash_sha512_256, "abc", "53048e2681941ef99b2e29b76b4c7dabe4c2d0c634fc6d46e0e2f13107e7af23"},
+        {&hash_sha512_256, two_blocks, "3928e184fb8690f840da3988121d31be65cb9d3ef83ee6146feac861e19b563a"},
+        {&hash_sha512_256, NULL, "40eb4a70d4d69815407a9e272f0101cd67e3d11262a4a0bfc087712749c7fb53"},
+        {&hash_sha3_256, "", "a7ffc6f8bf1ed76651c14756a061d662f580ff4de43b49fa82d80a4b80f8434a"},
+        {&hash_sha3_256, "abc", "3a985da74fe225b2045c172d6bd390bd855f086e3e9d525b46bfe24511431532"},
+        {&hash_sha3_256, two_blocks, "916f6061fe879741ca6469b43971dfdb28b1a32dc36cb3254e812be27aad1d18"},
+        {&hash_sha3_256, NULL, "8f3934e6f7a15698fe0f396b95d8c4440929a8fa6eae140171c068b4549fbf81"},
+        {&hash_blake2b_256, "", "0e5751c026e543b2e8ab2eb06099daa1d1e5df47778f7787faab45cdf12fe3a8"},
+        {&hash_blake2b_256, "abc", "bddd813c634239723171ef3fee98579b94964e3bb1cb3e427262c8c068d52319"},
+        {&hash_blake2b_256, two_blocks, "90a0bcf5e5a67ac1578c2754617994cfc248109275a809a0721feebd1e918738"},
+        {&hash_blake2b_256, NULL, "e00b0ddbf1e2cdaf5c898e1a5e8826ea3a2c339bcf2a478da2e5fca9ff126672"},
+    };
+    const size_t pieces[] = {0, 1, 7, 64, 127, 128, 136};
+
+    int failed = 0;
+    BYTE long_message[LONG_MESSAGE_SIZE];
+    memset(long_message, 'a', sizeof(long_message));
+
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+        const HASH_ALGORITHM* algorithm = vectors[i].algorithm;
+        const BYTE* message = vectors[i].message != NULL ? (const BYTE*)vectors[i].message : long_message;
+        size_t length = vectors[i].message != NULL ? strlen(vectors[i].message) : sizeof(long_message);
+
+        // At once with hash_digest (piece 0), then fed in pieces of each size
+        for (size_t p = 0; p < sizeof(pieces) / sizeof(pieces[0]); p++) {
+            BYTE hash[HASH_SIZE];
+            char hex[HASH_SIZE * 2 + 1];
+            if (pieces[p] == 0) {
+                hash_digest(algorithm, message, length, hash);
+            } else {
+                HASH_CTX ctx;
+                algorithm->init(&ctx);
+                for (size_t done = 0; done < length; done += pieces[p]) {
+                    algorithm->update(&ctx, message + done, length - done < pieces[p] ? length - done : pieces[p]);
+                }
+                algorithm->final(&ctx, hash);
+            }
+            for (int j = 0; j < HASH_SIZE; j++) {
+                sprintf(hex + 2 * j, "%02x", hash[j]);
+            }
+            if (strcmp(hex, vectors[i].hash) != 0) {
+                printf("FAIL %s of %zu bytes in pieces of %zu: %s instead of %s\n", algorithm->name, length, pieces[p], hex, vectors[i].hash);
+                failed++;
+            }
+        }
+    }
+
+    printf("%d failures\n", failed);
+    return failed == 0 ? 0 : 1;
+
+}
@@ -0,0 +1,48 @@
+#!/bin/sh
+# A chain interrupted by SIGINT many times and continued each time must have the same blocks as
+# the chain generated in one run
+# Usage: interrupt_resume.sh HCB
+set -e
+
+HCB="$1"
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+# Memory-hard levels are slow enough for the interruptions to land inside the chunks
+"$HCB" --memory 256 --checkpoint 0 resume "$DIR/whole.txt" > /dev/null &
+PID=$!
+sleep 6
+kill -INT $PID
+wait $PID
+
+# The first run only starts the chain, the next ones continue it from its #nonce checkpoint
+"$HCB" --memory 256 --checkpoint 0 resume "$DIR/parts.txt" > /dev/null &
+PID=$!
+sleep 0.3
+kill -INT $PID
+wait $PID
+for i in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20; do
+    "$HCB" --checkpoint 0 --continue "$DIR/parts.txt" > /dev/null &
+    PID=$!
+    sleep 0.3
+    kill -INT $PID
+    wait $PID
+done
+
+"$HCB" --full --check "$DIR/parts.txt" > /dev/null
+
+# Compare the blocks both chains have
+grep -v '^#' "$DIR/whole.txt" > "$DIR/whole.blocks"
+grep -v '^#' "$DIR/parts.txt" > "$DIR/parts.blocks"
+LINES=$(wc -l < "$DIR/parts.blocks")
+if [ $(wc -l < "$DIR/whole.blocks") -lt $LINES ]; then
+    LINES=$(wc -l < "$DIR/whole.blocks")
+fi
+head -n $LINES "$DIR/whole.blocks" > "$DIR/whole.common"
+head -n $LINES "$DIR/parts.blocks" > "$DIR/parts.common"
+if ! cmp -s "$DIR/whole.common" "$DIR/parts.common"; then
+    echo "FAIL the interrupted chain differs from the one generated in one run"
+    diff "$DIR/whole.common" "$DIR/parts.common" | head -n 10
+    exit 1
+fi
+echo "$(grep -c '^#stats' "$DIR/parts.txt") blocks compared after 21 interruptions"
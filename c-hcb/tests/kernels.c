@@ -0,0 +1,111 @@
+// Every SHA-256 kernel supported by this CPU must find the same nonces and hashes as the scalar
+// one, which must match the values computed with Python's hashlib
+#include <stdio.h>
+#include <string.h>
+#include "search.h"
+
+// Lowest nonce whose hash of "prefix\n" followed by the nonce on 64 digits starts with exactly
+// difficulty zero bits, from hashlib.sha256
+typedef struct {
+    const char* prefix;
+    int difficulty;
+    nonce_t nonce;
+    const char* hash;
+} known_t;
+
+static const known_t known[] = {
+    {"kernels", 8, 1480, "00bd92bb6056ff59b82101446c7438140593b3eae901f0bd87e9dbd356720ba4"},
+    {"kernels", 13, 40659, "000437f6ebc57fb87317520e72506c04f3fcd675ec1a1f6d35400f94a2cbbabe"},
+    {"e98f56f907c45b8a6621bdf148bdb5afdd9cba932fd4d9898890733e094d9f45", 12, 13576, "000b604f23dfce2584fc795eba3a4cf87304e01dcdcd790b75f12d58ae5d6573"},
+    {"e98f56f907c45b8a6621bdf148bdb5afdd9cba932fd4d9898890733e094d9f45", 17, 826375, "00006dc1388a28e755d3ac652d61197d6aeeed9919aabfdb73575587e0e06ed6"},
+};
+
+// Searches compared between the kernels, some starting far from 0 or inside a chunk
+typedef struct {
+    const char* prefix;
+    int difficulty;
+    nonce_t start;
+} case_t;
+
+static const case_t cases[] = {
+    {"", 0, 0},
+    {"a", 1, 0},
+    {"kernels", 10, 0},
+    {"kernels", 11, 123457},
+    {"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef", 14, 0},
+    {"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef", 9, 4294967290ULL},
+    {"a message longer than one block of SHA-256, so that its first block is compressed once before the nonces", 12, 0},
+    {"kernels", 9, (nonce_t)1 << 100},
+};
+
+// Search with the kernel and the number of threads, false if nothing was found
+static bool run(const SHA256_KERNEL* kernel, int threads, const char* prefix, int difficulty, nonce_t start, nonce_t* nonce, BYTE hash[]) {
+    search_t* search = search_create();
+    if (search == NULL) {
+        printf("Error: Out of memory\n");
+        return false;
+    }
+    search_set_kernel(search, kernel);
+    search_set_threads(search, threads);
+    int result = search_run(search, prefix, difficulty, start, NONCE_MAX, nonce, hash);
+    search_destroy(search);
+    return result == SEARCH_FOUND;
+}
+
+int main(void) {
+
+    int failed = 0;
+    int kernels = 0;
+    const SHA256_KERNEL* scalar = sha256_kernel_find("scalar");
+    if (scalar == NULL) {
+        printf("FAIL no scalar kernel\n");
+        return 1;
+    }
+
+    // The scalar kernel against hashlib
+    for (size_t i = 0; i < sizeof(known) / sizeof(known[0]); i++) {
+        nonce_t nonce;
+        BYTE hash[SHA256_BLOCK_SIZE];
+        char hex[SHA256_BLOCK_SIZE * 2 + 1];
+        bool found = run(scalar, 1, known[i].prefix, known[i].difficulty, 0, &nonce, hash);
+        for (int j = 0; j < SHA256_BLOCK_SIZE; j++) {
+            sprintf(hex + 2 * j, "%02x", hash[j]);
+        }
+        if (!found || nonce != known[i].nonce || strcmp(hex, known[i].hash) != 0) {
+            printf("FAIL scalar kernel, \"%s\" at difficulty %d: nonce %llu hash %s\n", known[i].prefix, known[i].difficulty,
+                (long long unsigned int)nonce, hex);
+            failed++;
+        }
+    }
+
+    // Every supported kernel against the scalar one
+    for (int k = 0; sha256_kernels[k] != NULL; k++) {
+        const SHA256_KERNEL* kernel = sha256_kernels[k];
+        if (!kernel->supported()) {
+            printf("%s: not supported by this CPU\n", kernel->name);
+            continue;
+        }
+        kernels++;
+        for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+            nonce_t expected, nonce;
+            BYTE expected_hash[SHA256_BLOCK_SIZE], hash[SHA256_BLOCK_SIZE];
+            if (!run(scalar, 1, cases[i].prefix, cases[i].difficulty, cases[i].start, &expected, expected_hash)) {
+                printf("FAIL scalar kernel, \"%s\" at difficulty %d: nothing found\n", cases[i].prefix, cases[i].difficulty);
+                failed++;
+                continue;
+            }
+            for (int threads = 1; threads <= 3; threads += 2) {
+                if (!run(kernel, threads, cases[i].prefix, cases[i].difficulty, cases[i].start, &nonce, hash) ||
+                    nonce != expected || memcmp(hash, expected_hash, SHA256_BLOCK_SIZE) != 0) {
+                    printf("FAIL %s kernel, %d threads, \"%s\" at difficulty %d: nonce %llu instead of %llu\n", kernel->name, threads,
+                        cases[i].prefix, cases[i].difficulty, (long long unsigned int)nonce, (long long unsigned int)expected);
+                    failed++;
+                }
+            }
+        }
+    }
+
+    printf("%d kernels compared, %d failures\n", kernels, failed);
+    return failed == 0 ? 0 : 1;
+
+}
@@ -0,0 +1,112 @@
+// A search cancelled in the middle of a chunk must resume from a position no higher than the
+// first nonce it did not test, so it finds the same nonce as an uninterrupted search
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "search.h"
+
+// Memory-hard searches are slow enough for a cancellation to land well inside a chunk
+#define TEST_MEMORY 256
+
+typedef struct {
+    search_t* search;
+    const char* prefix;
+    int difficulty;
+    int result;
+    nonce_t nonce;
+} run_t;
+
+static search_t* test_search(int threads) {
+    search_t* search = search_create();
+    if (search == NULL || !search_set_memory(search, TEST_MEMORY)) {
+        printf("Error: Out of memory\n");
+        exit(2);
+    }
+    search_set_threads(search, threads);
+    return search;
+}
+
+// Lowest valid nonce from start, searched without interruption
+static nonce_t search_from(const char* prefix, int difficulty, int threads, nonce_t start) {
+    BYTE hash[SHA256_BLOCK_SIZE];
+    nonce_t nonce;
+    search_t* search = test_search(threads);
+    int result = search_run(search, prefix, difficulty, start, NONCE_MAX, &nonce, hash);
+    search_destroy(search);
+    if (result != SEARCH_FOUND) {
+        printf("Error: The search of \"%s\" at difficulty %d found nothing\n", prefix, difficulty);
+        exit(1);
+    }
+    return nonce;
+}
+
+static void* run_thread(void* arg) {
+    BYTE hash[SHA256_BLOCK_SIZE];
+    run_t* run = arg;
+    run->result = search_run(run->search, run->prefix, run->difficulty, 0, NONCE_MAX, &run->nonce, hash);
+    return NULL;
+}
+
+// Cancel a search as soon as it starts the chunk of expected, then resume it
+static int check_resume(const char* prefix, int difficulty, int threads, nonce_t expected) {
+
+    pthread_t thread;
+    struct timespec poll = {0, 100000};
+    run_t run = {test_search(threads), prefix, difficulty, -1, 0};
+    nonce_t chunk = expected - expected % SEARCH_CHUNK_SIZE;
+
+    pthread_create(&thread, NULL, run_thread, &run);
+    while (search_position(run.search) < chunk) {
+        nanosleep(&poll, NULL);
+    }
+    search_cancel(run.search);
+    pthread_join(thread, NULL);
+    nonce_t position = search_position(run.search);
+    search_destroy(run.search);
+
+    if (run.result == SEARCH_FOUND) {
+        // The search reached the nonce before noticing the cancellation
+        return run.nonce == expected ? 0 : 1;
+    }
+    if (position > expected) {
+        printf("FAIL %s/%d, %d threads: cancelled at %llu, after the valid nonce %llu\n", prefix, difficulty, threads,
+            (long long unsigned int)position, (long long unsigned int)expected);
+        return 1;
+    }
+    nonce_t resumed = search_from(prefix, difficulty, threads, position);
+    if (resumed != expected) {
+        printf("FAIL %s/%d, %d threads: resumed from %llu found %llu instead of %llu\n", prefix, difficulty, threads,
+            (long long unsigned int)position, (long long unsigned int)resumed, (long long unsigned int)expected);
+        return 1;
+    }
+    return 0;
+
+}
+
+int main(void) {
+
+    char prefix[32];
+    int failed = 0;
+    int checked = 0;
+
+    // Levels whose nonce is far enough in its chunk for the cancellation to land before it
+    for (int i = 0; checked < 4 && i < 64; i++) {
+        snprintf(prefix, sizeof(prefix), "resume-%d", i);
+        int difficulty = 10 + i % 4;
+        nonce_t expected = search_from(prefix, difficulty, 1, 0);
+        if (expected < SEARCH_CHUNK_SIZE || expected % SEARCH_CHUNK_SIZE < SEARCH_CHUNK_SIZE / 2) {
+            continue;
+        }
+        failed += check_resume(prefix, difficulty, 1, expected);
+        failed += check_resume(prefix, difficulty, 3, expected);
+        checked++;
+    }
+    if (checked == 0) {
+        printf("FAIL no level to check\n");
+        return 1;
+    }
+    printf("%d levels checked, %d failures\n", checked, failed);
+    return failed == 0 ? 0 : 1;
+
+}
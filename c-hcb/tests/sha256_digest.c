@@ -0,0 +1,99 @@
+// The 129 bytes digest of the blocks, "message\nnonce", must match SHA-256 computed the usual way:
+// the scalar path folding the padding of the last block is called directly, as the dispatch only
+// takes it on the CPUs without the SHA extensions
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sha256.h"
+
+// Test vectors of FIPS 180-2, and a block of a chain from Python's hashlib
+typedef struct {
+    const char* message;
+    const char* hash;
+} vector_t;
+
+static const vector_t vectors[] = {
+    {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+    {"abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+    {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+};
+
+static const char* block_message = "e98f56f907c45b8a6621bdf148bdb5afdd9cba932fd4d9898890733e094d9f45";
+static const char* block_nonce = "0000000000000000000000000000000000000000000000000000000000826375";
+static const char* block_hash = "00006dc1388a28e755d3ac652d61197d6aeeed9919aabfdb73575587e0e06ed6";
+
+static void to_hex(const BYTE hash[], char hex[]) {
+    for (int i = 0; i < SHA256_BLOCK_SIZE; i++) {
+        sprintf(hex + 2 * i, "%02x", hash[i]);
+    }
+}
+
+// SHA-256 of "message\nnonce" with sha256_update
+static void digest_update(const BYTE message[], const BYTE nonce[], BYTE hash[]) {
+    SHA256_CTX ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, message, 64);
+    sha256_update(&ctx, (const BYTE*)"\n", 1);
+    sha256_update(&ctx, nonce, 64);
+    sha256_final(&ctx, hash);
+}
+
+int main(void) {
+
+    int failed = 0;
+    char hex[SHA256_BLOCK_SIZE * 2 + 1];
+    BYTE hash[SHA256_BLOCK_SIZE];
+    BYTE expected[SHA256_BLOCK_SIZE];
+
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+        SHA256_CTX ctx;
+        sha256_init(&ctx);
+        sha256_update(&ctx, (const BYTE*)vectors[i].message, strlen(vectors[i].message));
+        sha256_final(&ctx, hash);
+        to_hex(hash, hex);
+        if (strcmp(hex, vectors[i].hash) != 0) {
+            printf("FAIL sha256(\"%s\") = %s\n", vectors[i].message, hex);
+            failed++;
+        }
+    }
+
+    // A known block, through both paths
+    sha256_digest_hcb_scalar((const BYTE*)block_message, (const BYTE*)block_nonce, hash);
+    to_hex(hash, hex);
+    if (strcmp(hex, block_hash) != 0) {
+        printf("FAIL sha256_digest_hcb_scalar of a known block = %s\n", hex);
+        failed++;
+    }
+    sha256_digest_hcb((const BYTE*)block_message, (const BYTE*)block_nonce, hash);
+    to_hex(hash, hex);
+    if (strcmp(hex, block_hash) != 0) {
+        printf("FAIL sha256_digest_hcb of a known block = %s\n", hex);
+        failed++;
+    }
+
+    // Any bytes, the last one of the nonce in particular, which the folded block holds
+    srand(129);
+    for (int i = 0; i < 10000; i++) {
+        BYTE message[64], nonce[64];
+        for (int j = 0; j < 64; j++) {
+            message[j] = rand() & 0xFF;
+            nonce[j] = rand() & 0xFF;
+        }
+        nonce[63] = i & 0xFF;
+        digest_update(message, nonce, expected);
+        sha256_digest_hcb_scalar(message, nonce, hash);
+        if (memcmp(hash, expected, SHA256_BLOCK_SIZE) != 0) {
+            printf("FAIL sha256_digest_hcb_scalar of random block %d\n", i);
+            failed++;
+        }
+        sha256_digest_hcb(message, nonce, hash);
+        if (memcmp(hash, expected, SHA256_BLOCK_SIZE) != 0) {
+            printf("FAIL sha256_digest_hcb of random block %d\n", i);
+            failed++;
+        }
+    }
+
+    printf("%d failures\n", failed);
+    return failed == 0 ? 0 : 1;
+
+}
@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+
+char* test_temp_path(const char* name) {
+    char* path = malloc(strlen(name) + 32);
+    int fd = -1;
+    if (path != NULL) {
+        sprintf(path, "/tmp/%s-XXXXXX", name);
+        fd = mkstemp(path);
+    }
+    if (fd < 0) {
+        printf("Error: Unable to create a temporary file\n");
+        exit(2);
+    }
+    close(fd);
+    return path;
+}
+
+char* test_read_file(const char* path, size_t* size) {
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    long length = ftell(fp);
+    rewind(fp);
+    char* data = length >= 0 ? malloc(length + 1) : NULL;
+    if (data == NULL || fread(data, 1, length, fp) != (size_t)length) {
+        free(data);
+        fclose(fp);
+        return NULL;
+    }
+    data[length] = '\0';
+    *size = length;
+    fclose(fp);
+    return data;
+}
+
+bool test_write_file(const char* path, const char* data, size_t size) {
+    FILE* fp = fopen(path, "wb");
+    if (fp == NULL) {
+        return false;
+    }
+    bool written = fwrite(data, 1, size, fp) == size;
+    return fclose(fp) == 0 && written;
+}
+
+void test_chain(const char* path, const char* message, int blocks, const hcb_options* options) {
+    hcb_builder* builder;
+    hcb_error error;
+    if (hcb_builder_create(&builder, path, message, options, &error) != HCB_OK) {
+        printf("%s\n", error.message);
+        exit(2);
+    }
+    for (int level = 0; level < blocks; level++) {
+        if (hcb_builder_next(builder, NULL, &error) != HCB_OK) {
+            printf("%s\n", error.message);
+            exit(2);
+        }
+    }
+    hcb_builder_close(builder);
+}
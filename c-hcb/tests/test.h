@@ -0,0 +1,31 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "hcb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Helpers shared by the tests, which print "FAIL ..." for each failed check and exit with 1 if
+// any failed, or with 2 if they could not run
+
+// Path of a new empty file in /tmp whose name starts with name, exits if it cannot be created
+// The path is to be freed, and the file unlinked
+char* test_temp_path(const char* name);
+
+// Content of the file at path followed by a NUL, NULL if it cannot be read, to be freed
+char* test_read_file(const char* path, size_t* size);
+
+bool test_write_file(const char* path, const char* data, size_t size);
+
+// Generate a chain of the given number of blocks in path, options may be NULL, exits on error
+void test_chain(const char* path, const char* message, int blocks, const hcb_options* options);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   // TEST_H
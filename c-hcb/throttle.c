@@ -0,0 +1,259 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <sys/resource.h>
+#include "throttle.h"
+#include "util.h"
+
+struct throttle_s {
+    double share;
+    double max_load;
+    double available;                     // CPUs available to the process
+    int host_cpus;
+    atomic_int threads;                   // Threads being paced
+
+    // Last measure of the load of the host, protected by lock
+    pthread_mutex_t lock;
+    double sample_time;
+    double sample_cpu;                    // CPU time of the process
+    unsigned long long sample_busy;       // Busy time of the host, in clock ticks
+    double allowed;                       // CPUs the paced threads may use together
+};
+
+static double cpu_time(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+double throttle_thread_cpu(void) {
+    return cpu_time(CLOCK_THREAD_CPUTIME_ID);
+}
+
+// Time every CPU of the host spent running something, from the first line of /proc/stat
+static bool host_busy(unsigned long long* busy) {
+    unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
+    FILE* fp = fopen("/proc/stat", "r");
+    if (fp == NULL) {
+        return false;
+    }
+    int read = fscanf(fp, "cpu %llu %llu %llu %llu %llu %llu %llu %llu", &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal);
+    fclose(fp);
+    if (read != 8) {
+        return false;
+    }
+    *busy = user + nice + system + irq + softirq + steal;
+    return true;
+}
+
+// CPUs of the quota in the cpu.max file of a cgroup v2 directory, 0 if it has none
+static double quota_v2(const char* directory) {
+    char path[1024];
+    long long quota, period;
+    snprintf(path, sizeof(path), "/sys/fs/cgroup%s/cpu.max", directory);
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        return 0;
+    }
+    int read = fscanf(fp, "%lld %lld", &quota, &period);
+    fclose(fp);
+    return read == 2 && quota > 0 && period > 0 ? (double)quota / period : 0;
+}
+
+// CPUs of the smallest CPU quota of the cgroup of the process and of its parents, 0 if none
+static double cgroup_quota(void) {
+
+    char line[1024];
+    char directory[1024] = "";
+    double smallest = 0;
+
+    // cgroup v2: the line "0::PATH" of /proc/self/cgroup names the cgroup
+    FILE* fp = fopen("/proc/self/cgroup", "r");
+    while (fp != NULL && fgets(line, sizeof(line), fp) != NULL) {
+        if (strncmp(line, "0::", 3) == 0) {
+            snprintf(directory, sizeof(directory), "%s", line + 3);
+            directory[strcspn(directory, "\n")] = '\0';
+        }
+    }
+    if (fp != NULL) {
+        fclose(fp);
+    }
+    while (1) {
+        double quota = quota_v2(directory);
+        if (quota > 0 && (smallest == 0 || quota < smallest)) {
+            smallest = quota;
+        }
+        char* slash = strrchr(directory, '/');
+        if (slash == NULL || directory[0] == '\0') {
+            break;
+        }
+        *slash = '\0';
+    }
+    if (smallest > 0) {
+        return smallest;
+    }
+
+    // cgroup v1, a quota of -1 means none
+    long long quota = -1, period = 0;
+    if ((fp = fopen("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", "r")) != NULL) {
+        if (fscanf(fp, "%lld", &quota) != 1) {
+            quota = -1;
+        }
+        fclose(fp);
+    }
+    if ((fp = fopen("/sys/fs/cgroup/cpu/cpu.cfs_period_us", "r")) != NULL) {
+        if (fscanf(fp, "%lld", &period) != 1) {
+            period = 0;
+        }
+        fclose(fp);
+    }
+    return quota > 0 && period > 0 ? (double)quota / period : 0;
+
+}
+
+double throttle_available_cpus(void) {
+    cpu_set_t allowed;
+    double cpus = sched_getaffinity(0, sizeof(allowed), &allowed) == 0 ? CPU_COUNT(&allowed) : sysconf(_SC_NPROCESSORS_ONLN);
+    double quota = cgroup_quota();
+    if (cpus < 1) {
+        cpus = 1;
+    }
+    return quota > 0 && quota < cpus ? quota : cpus;
+}
+
+throttle_t* throttle_create(double share, double max_load) {
+    throttle_t* throttle = calloc(1, sizeof(throttle_t));
+    if (throttle == NULL) {
+        return NULL;
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    throttle->share = share;
+    throttle->max_load = max_load;
+    throttle->available = throttle_available_cpus();
+    throttle->host_cpus = cpus > 0 ? (int)cpus : 1;
+    throttle->allowed = share * throttle->available;
+    pthread_mutex_init(&throttle->lock, NULL);
+    return throttle;
+}
+
+void throttle_destroy(throttle_t* throttle) {
+    if (throttle == NULL) {
+        return;
+    }
+    pthread_mutex_destroy(&throttle->lock);
+    free(throttle);
+}
+
+bool throttle_set_idle(void) {
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) == 0) {
+        return true;
+    }
+    // On Linux, the nice value of the process 0 is the one of the calling thread
+    return setpriority(PRIO_PROCESS, 0, 19) == 0;
+}
+
+double throttle_allowed_cpus(throttle_t* throttle) {
+
+    pthread_mutex_lock(&throttle->lock);
+    double time = util_now();
+    if (time - throttle->sample_time >= THROTTLE_SAMPLE_INTERVAL) {
+
+        // The CPUs kept busy by the other processes are the busy time of the host, without the
+        // CPU time of this process
+        unsigned long long busy;
+        double cpu = cpu_time(CLOCK_PROCESS_CPUTIME_ID);
+        if (host_busy(&busy)) {
+            if (throttle->sample_time > 0 && busy >= throttle->sample_busy) {
+                double others = ((busy - throttle->sample_busy) / (double)sysconf(_SC_CLK_TCK) - (cpu - throttle->sample_cpu)) / (time - throttle->sample_time);
+                double spare = throttle->host_cpus * throttle->max_load - (others > 0 ? others : 0);
+                double target = throttle->share * throttle->available;
+                throttle->allowed = spare < target ? (spare > 0 ? spare : 0) : target;
+            }
+            throttle->sample_busy = busy;
+        }
+        throttle->sample_cpu = cpu;
+        throttle->sample_time = time;
+
+    }
+    double allowed = throttle->allowed;
+    pthread_mutex_unlock(&throttle->lock);
+    return allowed;
+
+}
+
+void throttle_begin(throttle_t* throttle, throttle_pace_t* pace) {
+    atomic_fetch_add(&throttle->threads, 1);
+
+    // A worker searching short windows one after the other keeps its period, so the time it ran
+    // over its share in the previous ones is still owed
+    double time = util_now();
+    if (time - pace->start_time > THROTTLE_PERIOD) {
+        pace->start_time = time;
+        pace->used = 0;
+    }
+    pace->thread_cpu = throttle_thread_cpu();
+}
+
+void throttle_end(throttle_t* throttle) {
+    atomic_fetch_sub(&throttle->threads, 1);
+}
+
+// Start a new period for the thread
+static void restart(throttle_pace_t* pace, double time) {
+    pace->start_time = time;
+    pace->used = 0;
+}
+
+bool throttle_pace(throttle_t* throttle, throttle_pace_t* pace) {
+
+    int threads = atomic_load(&throttle->threads);
+    double duty = throttle_allowed_cpus(throttle) / (threads > 0 ? threads : 1);
+    double time = util_now();
+    double cpu = throttle_thread_cpu();
+    pace->used += cpu - pace->thread_cpu;
+    pace->thread_cpu = cpu;
+    if (duty >= 1) {
+        restart(pace, time);
+        return false;
+    }
+
+    // Nothing may run while the host is too busy
+    if (duty <= 0) {
+        struct timespec ts = {0, (long)(THROTTLE_MAX_PAUSE * 1e9)};
+        nanosleep(&ts, NULL);
+        restart(pace, util_now());
+        return true;
+    }
+
+    // The thread may run duty seconds per second since the start of its period, it owes the rest
+    double owed = pace->used / duty - (time - pace->start_time);
+    if (owed < THROTTLE_MIN_PAUSE) {
+        if (time - pace->start_time > THROTTLE_PERIOD) {
+            restart(pace, time);
+        }
+        return false;
+    }
+
+    // A drop of the allowed share never makes the thread owe more than a period: the period then
+    // restarts after the pauses
+    if (owed > THROTTLE_PERIOD) {
+        owed = THROTTLE_PERIOD;
+        restart(pace, time + owed);
+    }
+
+    // Sleep in pauses short enough to notice a cancellation
+    double pause = owed < THROTTLE_MAX_PAUSE ? owed : THROTTLE_MAX_PAUSE;
+    struct timespec ts = {(time_t)pause, (long)((pause - (time_t)pause) * 1e9)};
+    nanosleep(&ts, NULL);
+    return owed > pause;
+
+}
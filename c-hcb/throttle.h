@@ -0,0 +1,68 @@
+#ifndef THROTTLE_H
+#define THROTTLE_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Seconds between two measures of the load of the host
+#define THROTTLE_SAMPLE_INTERVAL 1.0
+
+// Shortest and longest pause of a paced thread: the CPU time owed is slept in pauses of at least
+// THROTTLE_MIN_PAUSE, so a thread runs in bursts long enough to keep its caches warm, and of at
+// most THROTTLE_MAX_PAUSE, so a cancelled search stops quickly
+#define THROTTLE_MIN_PAUSE 0.02
+#define THROTTLE_MAX_PAUSE 0.25
+
+// Seconds of CPU time and elapsed time a paced thread is accounted over, so a change of the
+// allowed share applies within this time
+#define THROTTLE_PERIOD 2.0
+
+// Paces the search threads of a process so they use a share of the CPUs it may use, and less
+// when the other processes of the host need them
+typedef struct throttle_s throttle_t;
+
+// State of one paced thread, or of the threads running one after the other for the same worker
+typedef struct {
+    double start_time;                    // Start of the current period
+    double used;                          // CPU time used since then
+    double thread_cpu;                    // CPU time of the thread when used was last updated
+} throttle_pace_t;
+
+// Create a throttle letting the search threads use share (0 to 1) of the CPUs available to the
+// process (the cgroup CPU quota if any, the CPUs it may run on otherwise), and less when they
+// would make the host more than max_load (0 to 1) busy with the other processes
+// NULL if out of memory
+throttle_t* throttle_create(double share, double max_load);
+
+void throttle_destroy(throttle_t* throttle);
+
+// Give the calling thread the SCHED_IDLE policy, or the lowest nice value if it is not allowed,
+// the threads it creates afterwards inherit it
+// Returns false if neither could be set
+bool throttle_set_idle(void);
+
+// CPUs available to the process: the cgroup CPU quota, or the CPUs it may run on
+double throttle_available_cpus(void);
+
+// CPUs the search threads may currently use together, after backing off from the load of the host
+double throttle_allowed_cpus(throttle_t* throttle);
+
+// Start and stop pacing the calling thread, pace is kept from one search to the next
+void throttle_begin(throttle_t* throttle, throttle_pace_t* pace);
+void throttle_end(throttle_t* throttle);
+
+// Sleep for part of the time the calling thread ran over its share of the allowed CPUs
+// Returns true while more sleep is owed, the caller checks whether it was cancelled in between
+bool throttle_pace(throttle_t* throttle, throttle_pace_t* pace);
+
+// CPU time used by the calling thread, in seconds
+double throttle_thread_cpu(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   // THROTTLE_H
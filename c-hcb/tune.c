@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "tune.h"
+#include "util.h"
+
+// Message searched by the measures, at a difficulty that is never reached so every nonce is tested
+static const char* tune_prefix = "0000000000000000000000000000000000000000000000000000000000000000";
+#define TUNE_DIFFICULTY 128
+
+// Nonces tested per second by a searcher during about seconds
+static double measure(search_t* search, int threads, double seconds) {
+
+    BYTE hash[SHA256_BLOCK_SIZE];
+    nonce_t nonce;
+
+    // A first short run sizes the measured one, and wakes the CPUs up
+    double count = 10.0 * SEARCH_CHUNK_SIZE * threads;
+    double start = util_now();
+    search_run(search, tune_prefix, TUNE_DIFFICULTY, 0, (nonce_t)count, &nonce, hash);
+    double elapsed = util_now() - start;
+    if (elapsed > 0 && count * seconds / elapsed > count) {
+        count = count * seconds / elapsed;
+    }
+
+    start = util_now();
+    search_run(search, tune_prefix, TUNE_DIFFICULTY, 0, (nonce_t)count, &nonce, hash);
+    elapsed = util_now() - start;
+    return elapsed > 0 ? count / elapsed : 0;
+
+}
+
+hcb_status hcb_autotune(hcb_profile* profile, double seconds, hcb_tune_callback callback, void* data, hcb_error* error) {
+
+    hcb_profile measured;
+
+    search_t* search = search_create();
+    if (search == NULL) {
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+    }
+
+    // One thread, one per CPU and a few counts in between, for the SMT siblings and the
+    // efficiency cores that may be better left idle
+    int cpus = search_set_threads(search, 0);
+    int counts[] = {1, cpus / 4, cpus / 2, cpus * 3 / 4, cpus};
+
+    memset(profile, 0, sizeof(hcb_profile));
+    for (int k = 0; sha256_kernels[k] != NULL; k++) {
+        if (!sha256_kernels[k]->supported()) {
+            continue;
+        }
+        int previous = 0;
+        for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+            if (counts[c] <= previous) {
+                continue;
+            }
+            previous = counts[c];
+            for (int pinned = 0; pinned <= 1; pinned++) {
+                measured.kernel = sha256_kernels[k];
+                measured.threads = search_set_threads(search, counts[c]);
+                measured.pinned = pinned;
+                search_set_kernel(search, measured.kernel);
+                search_set_pinned(search, measured.pinned);
+                measured.hash_rate = measure(search, measured.threads, seconds);
+                if (callback != NULL) {
+                    callback(&measured, data);
+                }
+                if (measured.hash_rate > profile->hash_rate) {
+                    *profile = measured;
+                }
+            }
+        }
+    }
+
+    search_destroy(search);
+    return util_fail(error, HCB_OK, "");
+
+}
+
+void hcb_profile_host(char host[], size_t size) {
+
+    char* line = NULL;
+    size_t line_size = 0;
+    ssize_t length;
+    char model[256] = "Unknown CPU";
+
+    // The first "model name" of /proc/cpuinfo, the same for every CPU but the hybrid ones
+    FILE* fp = fopen("/proc/cpuinfo", "r");
+    while (fp != NULL && (length = getline(&line, &line_size, fp)) >= 0) {
+        char* value = strchr(line, ':');
+        if (strncmp(line, "model name", 10) == 0 && value != NULL) {
+            value += strspn(value + 1, " \t") + 1;
+            value[strcspn(value, "\r\n")] = '\0';
+            snprintf(model, sizeof(model), "%s", value);
+            break;
+        }
+    }
+    free(line);
+    if (fp != NULL) {
+        fclose(fp);
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    snprintf(host, size, "%s, %ld CPUs", model, cpus > 0 ? cpus : 1);
+
+}
+
+bool hcb_profile_path(char path[], size_t size) {
+    const char* cache = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    int length;
+    if (cache != NULL && cache[0] != '\0') {
+        length = snprintf(path, size, "%s/hcb/profiles", cache);
+    } else if (home != NULL && home[0] != '\0') {
+        length = snprintf(path, size, "%s/.cache/hcb/profiles", home);
+    } else {
+        return false;
+    }
+    return length > 0 && (size_t)length < size;
+}
+
+// Read a line of the profiles file: "KERNEL THREADS PINNED HASHRATE HOST"
+// Returns the host of the profile, NULL if the line is not one
+static const char* profile_parse(char* line, hcb_profile* profile) {
+    char kernel[32];
+    int threads, pinned;
+    double hash_rate;
+    int offset = -1;
+    line[strcspn(line, "\r\n")] = '\0';
+    if (sscanf(line, "%31s %d %d %lf %n", kernel, &threads, &pinned, &hash_rate, &offset) != 4 || offset < 0) {
+        return NULL;
+    }
+    profile->kernel = sha256_kernel_find(kernel);
+    profile->threads = threads;
+    profile->pinned = pinned != 0;
+    profile->hash_rate = hash_rate;
+    return line + offset;
+}
+
+bool hcb_profile_load(const char* path, hcb_profile* profile) {
+
+    char host[512];
+    char* line = NULL;
+    size_t size = 0;
+    hcb_profile current;
+    bool found = false;
+
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        return false;
+    }
+    hcb_profile_host(host, sizeof(host));
+    while (getline(&line, &size, fp) >= 0) {
+        const char* line_host = profile_parse(line, &current);
+        if (line_host != NULL && strcmp(line_host, host) == 0) {
+            found = current.kernel != NULL && current.kernel->supported() && current.threads > 0;
+            *profile = current;
+        }
+    }
+    free(line);
+    fclose(fp);
+    return found;
+
+}
+
+hcb_status hcb_profile_save(const char* path, const hcb_profile* profile, hcb_error* error) {
+
+    char host[512];
+    char* line = NULL;
+    size_t size = 0;
+    hcb_profile current;
+
+    // Create the missing directories
+    char* directory = strdup(path);
+    char* temp_path = malloc(strlen(path) + 5);
+    if (directory == NULL || temp_path == NULL) {
+        free(directory);
+        free(temp_path);
+        return util_fail(error, HCB_ERROR_MEMORY, "Error: Out of memory");
+    }
+    for (char* slash = strchr(directory + 1, '/'); slash != NULL; slash = strchr(slash + 1, '/')) {
+        *slash = '\0';
+        mkdir(directory, 0777);
+        *slash = '/';
+    }
+    free(directory);
+
+    // Written aside then renamed, so a reader never sees a partial file
+    sprintf(temp_path, "%s.tmp", path);
+    FILE* out = fopen(temp_path, "w");
+    if (out == NULL) {
+        free(temp_path);
+        return util_fail(error, HCB_ERROR_CREATE, "Error: Unable to open file \"%s\"", path);
+    }
+
+    // Keep the profiles of the other hosts
+    hcb_profile_host(host, sizeof(host));
+    FILE* in = fopen(path, "r");
+    while (in != NULL && getline(&line, &size, in) >= 0) {
+        char* copy = strdup(line);
+        const char* line_host = copy != NULL ? profile_parse(copy, &current) : NULL;
+        if (line_host != NULL && strcmp(line_host, host) != 0) {
+            fputs(line, out);
+        }
+        free(copy);
+    }
+    free(line);
+    if (in != NULL) {
+        fclose(in);
+    }
+
+    fprintf(out, "%s %d %d %.0f %s\n", profile->kernel->name, profile->threads, profile->pinned ? 1 : 0, profile->hash_rate, host);
+    if (fclose(out) != 0 || rename(temp_path, path) != 0) {
+        unlink(temp_path);
+        free(temp_path);
+        return util_fail(error, HCB_ERROR_WRITE, "Error: Unable to write file \"%s\"", path);
+    }
+    free(temp_path);
+    return util_fail(error, HCB_OK, "");
+
+}
@@ -0,0 +1,50 @@
+#ifndef TUNE_H
+#define TUNE_H
+
+#include <stddef.h>
+#include "hcb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Seconds each configuration is measured by hcb_autotune
+#define HCB_TUNE_SECONDS 0.3
+
+// Search configuration of a host: the fastest one measured by hcb_autotune
+typedef struct {
+    const SHA256_KERNEL* kernel;
+    int threads;
+    bool pinned;                  // Each search thread runs on its own CPU
+    double hash_rate;             // Nonces tested per second
+} hcb_profile;
+
+// Called after each configuration measured by hcb_autotune
+typedef void (*hcb_tune_callback)(const hcb_profile* measured, void* data);
+
+// Measure the search with every supported kernel, several numbers of threads up to one per CPU,
+// with and without pinning, for seconds each, profile receives the fastest configuration
+// callback may be NULL
+hcb_status hcb_autotune(hcb_profile* profile, double seconds, hcb_tune_callback callback, void* data, hcb_error* error);
+
+// Name of this host in the profiles: the CPU model and the number of CPUs online, which changes
+// with the SMT setting
+void hcb_profile_host(char host[], size_t size);
+
+// Default file of the profiles: $XDG_CACHE_HOME/hcb/profiles, or ~/.cache/hcb/profiles
+// Returns false if neither XDG_CACHE_HOME nor HOME is set
+bool hcb_profile_path(char path[], size_t size);
+
+// Read the profile of this host from the file at path
+// Returns false if there is none, or if its kernel is not supported any more
+bool hcb_profile_load(const char* path, hcb_profile* profile);
+
+// Save the profile of this host to the file at path, replacing its previous one, the profiles of
+// the other hosts are kept and the missing directories are created
+hcb_status hcb_profile_save(const char* path, const hcb_profile* profile, hcb_error* error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   // TUNE_H
@@ -0,0 +1,21 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include "util.h"
+
+hcb_status util_fail(hcb_error* error, hcb_status status, const char* format, ...) {
+    if (error != NULL) {
+        va_list args;
+        va_start(args, format);
+        error->status = status;
+        vsnprintf(error->message, sizeof(error->message), format, args);
+        va_end(args);
+    }
+    return status;
+}
+
+double util_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
@@ -0,0 +1,28 @@
+#ifndef UTIL_H
+#define UTIL_H
+
+#include "hcb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Helpers shared by the modules of libhcb, hcb and hcb-bench, not installed
+
+// Size of a sha256 hash in hexadecimal ascii characters
+static const int sha256_hex_length = SHA256_BLOCK_SIZE * 2;
+
+// Length of the nonce
+static const int nonce_length = SHA256_BLOCK_SIZE * 2;
+
+// Describe a status in error, which may be NULL, returns the status
+hcb_status util_fail(hcb_error* error, hcb_status status, const char* format, ...);
+
+// Seconds of the monotonic clock
+double util_now(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   // UTIL_H
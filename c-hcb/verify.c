@@ -0,0 +1,246 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "verify.h"
+#include "search.h"
+#include "util.h"
+
+// A verification, shared by all its workers
+typedef struct {
+    const verify_block_t* list;
+    size_t count;
+    size_t first;
+    const SHA256_KERNEL* kernel;
+    const HASH_ALGORITHM* algorithm;
+    atomic_size_t next_chunk;       // Next chunk to be claimed
+    atomic_size_t first_invalid;    // Lowest invalid block found so far, count if none
+} verify_t;
+
+void verify_hash(const verify_block_t* block, const HASH_ALGORITHM* algorithm, scratchpad_t* scratchpad, BYTE hash[]) {
+    HASH_CTX ctx;
+    if (algorithm == &hash_sha256 && block->message_length == sha256_hex_length) {
+        sha256_digest_hcb((const BYTE*)block->message, (const BYTE*)block->nonce, hash);
+    } else {
+        algorithm->init(&ctx);
+        algorithm->update(&ctx, (const BYTE*)block->message, block->message_length);
+        algorithm->update(&ctx, (const BYTE*)"\n", 1);
+        algorithm->update(&ctx, (const BYTE*)block->nonce, nonce_length);
+        algorithm->final(&ctx, hash);
+    }
+    if (scratchpad != NULL) {
+        scratchpad_fill(scratchpad, algorithm, block->message, block->message_length, 0);
+        scratchpad_hash(scratchpad, algorithm, hash, hash);
+    }
+}
+
+// Value of a lowercase hexadecimal digit, -1 if it is not one
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+bool verify_read_hex(const char* hex, BYTE hash[]) {
+    for (int i = 0; i < SHA256_BLOCK_SIZE; i++) {
+        int high = hex_digit(hex[i*2]);
+        int low = hex_digit(hex[i*2+1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        hash[i] = (BYTE)(high << 4 | low);
+    }
+    return true;
+}
+
+// Check the hash of the block at index in the list
+static bool block_valid(verify_t* verify, const BYTE hash[], size_t index) {
+    const verify_block_t* block = &verify->list[index];
+    return block->hash_valid && memcmp(hash, block->hash, SHA256_BLOCK_SIZE) == 0 &&
+        (size_t)numberOfZero((BYTE*)hash, SHA256_BLOCK_SIZE) == verify->first + index;
+}
+
+// Lower the first invalid block to index if it is smaller
+static void invalid_lower(verify_t* verify, size_t index) {
+    size_t current = atomic_load(&verify->first_invalid);
+    while (index < current && !atomic_compare_exchange_weak(&verify->first_invalid, &current, index));
+}
+
+// Whether the block has the usual "hash\nnonce" layout shared by every block but the first, and
+// is hashed with SHA-256, so it can be batched in the lanes of the kernel
+static bool block_standard(verify_t* verify, const verify_block_t* block) {
+    return block->message_length == sha256_hex_length && verify->algorithm == &hash_sha256;
+}
+
+// Standard blocks queued in the lanes of the kernel
+typedef struct {
+    int pending;
+    size_t index[SHA256_MAX_LANES];
+    WORD state[SHA256_MAX_LANES][8];
+    BYTE blocks[3][SHA256_MAX_LANES][64];
+} batch_t;
+
+// Hash the queued blocks, return false if one of them is invalid
+static bool batch_flush(verify_t* verify, batch_t* batch) {
+
+    BYTE hash[SHA256_BLOCK_SIZE];
+    bool valid = true;
+
+    if (batch->pending == 0) {
+        return true;
+    }
+
+    // Unused lanes are hashed for nothing
+    for (int l = 0; l < verify->kernel->lanes; l++) {
+        sha256_init_state(batch->state[l]);
+    }
+    for (int b = 0; b < 3; b++) {
+        verify->kernel->transform(batch->state, (const BYTE (*)[64])batch->blocks[b]);
+    }
+    for (int l = 0; l < batch->pending; l++) {
+        sha256_state_digest(batch->state[l], hash);
+        if (!block_valid(verify, hash, batch->index[l])) {
+            invalid_lower(verify, batch->index[l]);
+            valid = false;
+            break;
+        }
+    }
+    batch->pending = 0;
+    return valid;
+
+}
+
+// Worker thread: claims chunks of blocks in increasing order until an invalid block is known
+// to be lower than anything left to verify
+static void* verify_worker(void* arg) {
+
+    verify_t* verify = arg;
+    BYTE hash[SHA256_BLOCK_SIZE];
+    batch_t* batch = malloc(sizeof(batch_t));
+
+    // Standard blocks are 129 bytes long, so always padded to three blocks with the same end
+    // Without memory for a batch, the blocks are hashed one at a time
+    const size_t message_length = sha256_hex_length + 1 + nonce_length;
+    if (batch != NULL) {
+        memset(batch, 0, sizeof(batch_t));
+        for (int l = 0; l < verify->kernel->lanes; l++) {
+            BYTE* tail = batch->blocks[2][l];
+            tail[message_length - 128] = 0x80;
+            for (int i = 0; i < 8; i++) {
+                tail[63 - i] = (BYTE)((message_length * 8) >> (i * 8));
+            }
+        }
+    }
+
+    while (1) {
+
+        size_t first = atomic_fetch_add(&verify->next_chunk, 1) * VERIFY_CHUNK_SIZE;
+        if (first >= verify->count || first >= atomic_load(&verify->first_invalid)) {
+            break;
+        }
+        size_t last = first + VERIFY_CHUNK_SIZE < verify->count ? first + VERIFY_CHUNK_SIZE : verify->count;
+
+        for (size_t index = first; index < last; index++) {
+
+            const verify_block_t* block = &verify->list[index];
+
+            // Blocks with an unusual layout (the first one) or algorithm are hashed alone, and so
+            // are all of them without several lanes to batch them in
+            if (batch == NULL || !block_standard(verify, block) || verify->kernel->lanes == 1) {
+                if (batch != NULL && !batch_flush(verify, batch)) {
+                    break;
+                }
+                verify_hash(block, verify->algorithm, NULL, hash);
+                if (!block_valid(verify, hash, index)) {
+                    invalid_lower(verify, index);
+                    break;
+                }
+                continue;
+            }
+
+            // Queue the block in the next lane: the hash fills the first block, the line break and
+            // the nonce the second one, the last digit of the nonce starts the padded third one
+            BYTE* lane[3] = {batch->blocks[0][batch->pending], batch->blocks[1][batch->pending], batch->blocks[2][batch->pending]};
+            memcpy(lane[0], block->message, 64);
+            lane[1][0] = '\n';
+            memcpy(lane[1] + 1, block->nonce, 63);
+            lane[2][0] = block->nonce[63];
+            batch->index[batch->pending++] = index;
+            if (batch->pending == verify->kernel->lanes && !batch_flush(verify, batch)) {
+                break;
+            }
+
+        }
+        if (batch != NULL) {
+            batch_flush(verify, batch);
+        }
+
+    }
+
+    free(batch);
+    return NULL;
+
+}
+
+size_t verify_blocks(const verify_block_t* blocks, size_t count, size_t first, int threads, const SHA256_KERNEL* kernel, const HASH_ALGORITHM* algorithm, scratchpad_t* scratchpad) {
+
+    pthread_t workers[SEARCH_MAX_THREADS];
+
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads > SEARCH_MAX_THREADS) {
+        threads = SEARCH_MAX_THREADS;
+    }
+
+    verify_t verify;
+    verify.list = blocks;
+    verify.count = count;
+    verify.first = first;
+    verify.kernel = kernel;
+    verify.algorithm = algorithm;
+    atomic_init(&verify.next_chunk, 0);
+    atomic_init(&verify.first_invalid, count);
+
+    // A memory-hard block costs the filling of its scratchpad, which the threads share
+    if (scratchpad != NULL) {
+        BYTE hash[SHA256_BLOCK_SIZE];
+        for (size_t index = 0; index < count; index++) {
+            scratchpad_fill(scratchpad, algorithm, blocks[index].message, blocks[index].message_length, threads);
+            verify_hash(&blocks[index], algorithm, scratchpad, hash);
+            if (!block_valid(&verify, hash, index)) {
+                return index;
+            }
+        }
+        return count;
+    }
+
+    // Single threaded verification does not need a pool
+    if (threads == 1) {
+        verify_worker(&verify);
+        return atomic_load(&verify.first_invalid);
+    }
+
+    int started = 0;
+    for (; started < threads; started++) {
+        if (pthread_create(&workers[started], NULL, verify_worker, &verify) != 0) {
+            break;
+        }
+    }
+    if (started == 0) {
+        verify_worker(&verify);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    return atomic_load(&verify.first_invalid);
+
+}
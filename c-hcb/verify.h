@@ -0,0 +1,46 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "sha256.h"
+#include "hash.h"
+#include "scratchpad.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of consecutive blocks a verification worker claims at once
+#define VERIFY_CHUNK_SIZE 64
+
+// A block of a chain: the hash of "message\nnonce" must be hash, starting with as many zero
+// bits as the block number
+// The message and the nonce point into the chain and are not NUL-terminated
+typedef struct {
+    const char* message;          // Previous hash, or start message for the block #0
+    size_t message_length;
+    const char* nonce;            // SHA256_BLOCK_SIZE * 2 digits
+    BYTE hash[SHA256_BLOCK_SIZE]; // Hash read in the chain
+    bool hash_valid;              // False if the hash was not written in lowercase hexadecimal
+} verify_block_t;
+
+// Verify the blocks[0..count) of a chain hashed with algorithm with the given number of threads
+// (0 for one per CPU), batching the SHA-256 blocks over the lanes of kernel, blocks[0] being the
+// block number first
+// The blocks of a memory-hard chain (scratchpad not NULL) are verified in order, the threads
+// filling the scratchpad of each one, so the scratchpad is left filled for the returned block
+// Returns the index in blocks of the first invalid block, or count if every block is valid
+size_t verify_blocks(const verify_block_t* blocks, size_t count, size_t first, int threads, const SHA256_KERNEL* kernel, const HASH_ALGORITHM* algorithm, scratchpad_t* scratchpad);
+
+// Read a lowercase hexadecimal hash, returns false if it is not one
+bool verify_read_hex(const char* hex, BYTE hash[]);
+
+// Hash a single block the regular way, or the memory-hard way with scratchpad if not NULL
+void verify_hash(const verify_block_t* block, const HASH_ALGORITHM* algorithm, scratchpad_t* scratchpad, BYTE hash[]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   // VERIFY_H